@@ -1,7 +1,19 @@
 @echo off
 
+rem build.bat [debug|profile|release]
+set CONFIG_FLAGS=-D DEV=1 -D DEBUG=1 -Od
+set LINK_FLAGS=-opt:ref
+if "%1"=="profile" (
+  set CONFIG_FLAGS=-D DEV=1 -D DEBUG=0 -O2 -GL
+  set LINK_FLAGS=-opt:ref -opt:icf -LTCG
+)
+if "%1"=="release" (
+  set CONFIG_FLAGS=-D DEV=0 -D DEBUG=0 -O2 -GL
+  set LINK_FLAGS=-opt:ref -opt:icf -LTCG
+)
+
 call vcvarsall.bat x64 > nul 2>&1
 pushd build
-cl -D DEV=1 -D DEBUG=1 -nologo -Oi -GR- -EHa- -MT -Gm- -Od -W4 -WX -wd4201 -wd4127 -wd4100 -FC -Z7 -Fmwin32_handmade_hero.map ../src/win32/win32-handmade-hero.cpp ../src/win32/win32-input.cpp ../src/win32/win32-file-io.cpp ../src/win32/win32-sound.cpp ../src/win32/win32-clock.cpp ../src/win32/win32-display.cpp ../src/handmade-hero/handmade-hero.cpp user32.lib gdi32.lib xinput.lib winmm.lib /link -opt:ref
+cl %CONFIG_FLAGS% -nologo -Oi -GR- -EHa- -MT -Gm- -W4 -WX -wd4201 -wd4127 -wd4100 -FC -Z7 -Fmwin32_handmade_hero.map ../src/win32/win32-handmade-hero.cpp ../src/win32/win32-input.cpp ../src/win32/win32-file-io.cpp ../src/win32/win32-sound.cpp ../src/win32/win32-clock.cpp ../src/win32/win32-display.cpp ../src/win32/win32-present.cpp ../src/win32/win32-capture.cpp ../src/win32/win32-hash.cpp ../src/win32/win32-golden.cpp ../src/win32/win32-bench.cpp ../src/win32/win32-text.cpp ../src/win32/win32-save-state.cpp ../src/win32/win32-memory.cpp ../src/win32/win32-latency.cpp ../src/win32/win32-log.cpp ../src/win32/win32-telemetry.cpp ../src/win32/win32-stream.cpp ../src/win32/win32-file-watch.cpp ../src/win32/win32-music.cpp ../src/win32/win32-replay.cpp ../src/handmade-hero/handmade-hero.cpp ../src/handmade-hero/handmade-hero-world.cpp ../src/handmade-hero/handmade-hero-entity.cpp ../src/handmade-hero/handmade-hero-collision.cpp ../src/handmade-hero/handmade-hero-particle.cpp ../src/handmade-hero/handmade-hero-color.cpp ../src/handmade-hero/handmade-hero-pixel.cpp ../src/handmade-hero/handmade-hero-stream.cpp ../src/handmade-hero/handmade-hero-flow.cpp ../src/handmade-hero/handmade-hero-sprite.cpp ../src/handmade-hero/handmade-hero-music.cpp user32.lib gdi32.lib xinput.lib winmm.lib /link %LINK_FLAGS%
 popd
 pause
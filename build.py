@@ -6,6 +6,71 @@ from typing import Iterable, Optional, Tuple
 from rich.console import Console
 
 
+SOURCE_FILES = [
+    "../src/win32/win32-handmade-hero.cpp",  # Win32 entry point
+    "../src/win32/win32-input.cpp",  # Win32 input handling
+    "../src/win32/win32-file-io.cpp",  # Win32 file I/O
+    "../src/win32/win32-sound.cpp",  # Win32 sound handling
+    "../src/win32/win32-clock.cpp",  # Win32 clock handling
+    "../src/win32/win32-display.cpp",  # Win32 display handling
+    "../src/win32/win32-present.cpp",  # Win32 present thread
+    "../src/win32/win32-capture.cpp",  # Win32 video capture
+    "../src/win32/win32-hash.cpp",  # Win32 memory hashing
+    "../src/win32/win32-golden.cpp",  # Win32 golden-frame harness
+    "../src/win32/win32-bench.cpp",  # Win32 micro-benchmarks
+    "../src/win32/win32-text.cpp",  # Glyph atlas and debug text
+    "../src/win32/win32-save-state.cpp",  # Incremental save states
+    "../src/win32/win32-memory.cpp",  # Memory instrumentation
+    "../src/win32/win32-latency.cpp",  # Adaptive audio latency
+    "../src/win32/win32-log.cpp",  # Asynchronous logging
+    "../src/win32/win32-telemetry.cpp",  # Frame-time telemetry
+    "../src/win32/win32-stream.cpp",  # Background file reads
+    "../src/win32/win32-file-watch.cpp",  # File change notifications
+    "../src/win32/win32-music.cpp",  # Music encoder
+    "../src/win32/win32-replay.cpp",  # Replay recording and verification
+    "../src/handmade-hero/handmade-hero.cpp",  # Game code
+    "../src/handmade-hero/handmade-hero-world.cpp",  # Tile-map world storage
+    "../src/handmade-hero/handmade-hero-entity.cpp",  # Entity storage
+    "../src/handmade-hero/handmade-hero-collision.cpp",  # Broadphase and narrowphase collision
+    "../src/handmade-hero/handmade-hero-particle.cpp",  # SIMD particle system
+    "../src/handmade-hero/handmade-hero-color.cpp",  # sRGB tables and blending
+    "../src/handmade-hero/handmade-hero-pixel.cpp",  # Pixel formats
+    "../src/handmade-hero/handmade-hero-stream.cpp",  # Chunk streaming
+    "../src/handmade-hero/handmade-hero-flow.cpp",  # Flow fields
+    "../src/handmade-hero/handmade-hero-sprite.cpp",  # Sprites
+    "../src/handmade-hero/handmade-hero-music.cpp",  # Music
+]
+
+EXECUTABLE_NAME = "win32-handmade-hero"
+TRAINING_ARGUMENTS = "-train"
+
+
+class BuildOptions:
+    def __init__(
+        self,
+        config: str = "debug",
+        compiler: str = "cl",
+        lto: bool = False,
+        arch_flags: Optional[str] = None,
+        pgo: Optional[str] = None,
+        unity: bool = False,
+    ) -> None:
+        self.config = config
+        self.compiler = compiler
+        self.lto = lto
+        self.arch_flags = arch_flags
+        self.pgo = pgo
+        self.unity = unity
+
+    @property
+    def is_optimized(self) -> bool:
+        return self.config != "debug"
+
+    @property
+    def is_clang(self) -> bool:
+        return self.compiler == "clang-cl"
+
+
 def run_command(command: str) -> Tuple[bool, str]:
     result = ""
     process = subprocess.Popen(
@@ -27,17 +92,28 @@ def run_command(command: str) -> Tuple[bool, str]:
     return True, result
 
 
+def create_unity_file(output_name: str) -> str:
+    unity_name = f"{output_name}_unity.cpp"
+    with open(unity_name, "w") as unity_file:
+        for source_file in SOURCE_FILES:
+            unity_file.write(f'#include "{source_file}"\n')
+    return unity_name
+
+
 def create_compile_command(
     output_name: str,
+    options: BuildOptions,
     additional_files: Optional[Iterable[str]] = None,
     additional_libs: Optional[Iterable[str]] = None,
 ) -> Iterable[str]:
-    compile_command = ["cl"]
+    compile_command = [options.compiler]
 
+    # debug: development build, profile: optimized with DEV tooling,
+    # release: optimized without DEV tooling
     compile_command.extend(
         [
-            "-D DEV=1",  # Development build
-            "-D DEBUG=1",  # Debug build
+            f"-D DEV={0 if options.config == 'release' else 1}",
+            f"-D DEBUG={1 if options.config == 'debug' else 0}",
         ]
     )
 
@@ -50,10 +126,36 @@ def create_compile_command(
             "-EHa-",  # Disable C++ exception handling
             "-MT",  # Use static multi-threaded runtime library
             "-Gm-",  # Disable minimal rebuild
-            "-Od",  # Disable optimization
         ]
     )
 
+    # Optimization flags
+    if options.is_optimized:
+        compile_command.append("-O2")  # Maximize speed
+        if options.lto:
+            if options.is_clang:
+                compile_command.extend(
+                    [
+                        "-flto=thin",  # ThinLTO
+                        "-fuse-ld=lld",  # Link bitcode objects with lld-link
+                    ]
+                )
+            else:
+                compile_command.append("-GL")  # Whole program optimization
+    else:
+        compile_command.append("-Od")  # Disable optimization
+
+    if options.arch_flags:
+        compile_command.append(f"-arch:{options.arch_flags}")  # AVX or AVX2
+
+    # Profile-guided optimization flags
+    if options.pgo == "generate" and options.is_clang:
+        compile_command.append(f"-fprofile-instr-generate={EXECUTABLE_NAME}.profraw")
+    elif options.pgo == "use" and options.is_clang:
+        compile_command.append(f"-fprofile-instr-use={EXECUTABLE_NAME}.profdata")
+    elif options.pgo and "-GL" not in compile_command:
+        compile_command.append("-GL")  # Required by /GENPROFILE and /USEPROFILE
+
     # Warning and error flags
     compile_command.extend(
         [
@@ -73,21 +175,15 @@ def create_compile_command(
         ]
     )
 
-    # Output flags (map file)
+    # Output flags (executable and map file)
+    compile_command.append(f"-Fe{EXECUTABLE_NAME}.exe")
     compile_command.append(f"-Fm{output_name}.map")
 
     # Source files
-    compile_command.extend(
-        [
-            "../src/win32/win32-handmade-hero.cpp",  # Win32 entry point
-            "../src/win32/win32-input.cpp",  # Win32 input handling
-            "../src/win32/win32-file-io.cpp",  # Win32 file I/O
-            "../src/win32/win32-sound.cpp",  # Win32 sound handling
-            "../src/win32/win32-clock.cpp",  # Win32 clock handling
-            "../src/win32/win32-display.cpp",  # Win32 display handling
-            "../src/handmade-hero/handmade-hero.cpp",  # Game code
-        ]
-    )
+    if options.unity:
+        compile_command.append(create_unity_file(output_name))
+    else:
+        compile_command.extend(SOURCE_FILES)
 
     # Default libraries
     compile_command.extend(
@@ -109,10 +205,29 @@ def create_compile_command(
 
     # Linker flags (optimize for size)
     compile_command.extend(["/link", "-opt:ref"])
+    if options.is_optimized:
+        compile_command.append("-opt:icf")  # Fold identical functions
+    if "-GL" in compile_command:
+        compile_command.append("-LTCG")  # Link-time code generation
+    if options.pgo == "generate" and not options.is_clang:
+        compile_command.append(f"-GENPROFILE:PGD={EXECUTABLE_NAME}.pgd")
+    elif options.pgo == "use" and not options.is_clang:
+        compile_command.append(f"-USEPROFILE:PGD={EXECUTABLE_NAME}.pgd")
 
     return compile_command
 
 
+def create_training_command(options: BuildOptions) -> str:
+    # Runs the scripted headless replay and merges the resulting profile
+    training_command = f"{EXECUTABLE_NAME}.exe {TRAINING_ARGUMENTS}"
+    if options.is_clang:
+        return (
+            f"{training_command} && llvm-profdata merge"
+            f" -output={EXECUTABLE_NAME}.profdata {EXECUTABLE_NAME}.profraw"
+        )
+    return f"{training_command} && pgomgr /merge {EXECUTABLE_NAME}.pgd"
+
+
 def lint(console: Console) -> None:
     _, output = run_command("cpplint --quiet --recursive .")
     if not output:
@@ -123,6 +238,7 @@ def lint(console: Console) -> None:
 def build(
     console: Console,
     arch: str,
+    options: BuildOptions,
     additional_files: Optional[Iterable[str]] = None,
     additional_libs: Optional[Iterable[str]] = None,
     output_name: Optional[str] = None,
@@ -136,19 +252,23 @@ def build(
         command = "call vcvarsall.bat x86"
     command = command + " > nul 2>&1"
 
+    # Change to build directory
+    os.chdir("build")
+
     # Prepare compilation command
     output_name = output_name or "win32_handmade_hero"
     compile_command = create_compile_command(
-        output_name, additional_files, additional_libs
+        output_name, options, additional_files, additional_libs
     )
 
-    # Change to build directory, run compilation, and return
-    os.chdir("build")
-
-    _, output = run_command(command + " && " + " ".join(compile_command))
-    if not output:
-        return
-    console.print(output)
+    # Run compilation and, for an instrumented build, the training run
+    success, output = run_command(command + " && " + " ".join(compile_command))
+    if success and options.pgo == "generate":
+        success, output = run_command(
+            command + " && " + create_training_command(options)
+        )
+    if output:
+        console.print(output)
 
     os.chdir("..")
 
@@ -169,12 +289,54 @@ def main() -> None:
         "--libs", nargs="*", help="Additional libraries to link"
     )
     parser.add_argument("--output", help="Output file name (without extension)")
+    parser.add_argument(
+        "--config",
+        type=str,
+        choices=["debug", "profile", "release"],
+        default="debug",
+        help="Build profile (profile keeps the DEV tooling on optimized code)",
+    )
+    parser.add_argument(
+        "--compiler",
+        type=str,
+        choices=["cl", "clang-cl"],
+        default="cl",
+        help="Compiler driver",
+    )
+    parser.add_argument(
+        "--lto", action="store_true", help="Link-time optimization"
+    )
+    parser.add_argument(
+        "--arch-flags",
+        type=str,
+        choices=["AVX", "AVX2"],
+        help="Target instruction set (SSE2 when omitted)",
+    )
+    parser.add_argument(
+        "--pgo",
+        type=str,
+        choices=["generate", "use"],
+        help="Profile-guided optimization stage",
+    )
+    parser.add_argument(
+        "--unity",
+        action="store_true",
+        help="Compile all sources as one translation unit",
+    )
 
     args = parser.parse_args()
+    options = BuildOptions(
+        args.config,
+        args.compiler,
+        args.lto,
+        args.arch_flags,
+        args.pgo,
+        args.unity,
+    )
 
     console = Console()
     lint(console)
-    build(console, args.arch, args.files, args.libs, args.output)
+    build(console, args.arch, options, args.files, args.libs, args.output)
 
 
 if __name__ == "__main__":
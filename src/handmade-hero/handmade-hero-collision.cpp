@@ -0,0 +1,288 @@
+#include "../../src/handmade-hero/handmade-hero-collision.h"
+
+#include <emmintrin.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-entity.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+// minss/maxss keep the random velocity signs off the branch predictor.
+static inline float Min(float a, float b) {
+  return _mm_cvtss_f32(_mm_min_ss(_mm_set_ss(a), _mm_set_ss(b)));
+}
+
+static inline float Max(float a, float b) {
+  return _mm_cvtss_f32(_mm_max_ss(_mm_set_ss(a), _mm_set_ss(b)));
+}
+
+static inline bool BoxesOverlap(CollisionBox *a, CollisionBox *b) {
+  bool result = (a->min_x < b->max_x) & (b->min_x < a->max_x) &
+                (a->min_y < b->max_y) & (b->min_y < a->max_y);
+  return result;
+}
+
+static inline CollisionBox GetEntityBox(EntityStorage *storage,
+                                        EntitySet *set, uint32_t dense_idx) {
+  EntityCold *cold = &storage->cold[set->slot_idx[dense_idx]];
+  CollisionBox result = {};
+  result.min_x = set->pos_x[dense_idx];
+  result.min_y = set->pos_y[dense_idx];
+  result.max_x = result.min_x + cold->width;
+  result.max_y = result.min_y + cold->height;
+  return result;
+}
+
+static inline int32_t GetCellCoord(float value, float origin, float cell_size,
+                                   int32_t cell_count) {
+  int32_t result = static_cast<int32_t>((value - origin) / cell_size);
+  if (result < 0) {
+    result = 0;
+  }
+  if (result >= cell_count) {
+    result = cell_count - 1;
+  }
+  return result;
+}
+
+void BuildCollisionGrid(CollisionGrid *grid, MemoryArena *arena,
+                        EntityStorage *storage, EntitySet *set, float dt) {
+  CollisionBox *swept_boxes = PushArray(arena, set->count, CollisionBox);
+  uint32_t *collider_idx = PushArray(arena, set->count, uint32_t);
+
+  uint32_t collider_count = 0;
+  float min_x = INFINITY;
+  float min_y = INFINITY;
+  float max_x = -INFINITY;
+  float max_y = -INFINITY;
+  float max_extent = 0.0f;
+  for (uint32_t i = 0; i < set->count; ++i) {
+    if (!(set->flags[i] & ENTITY_FLAG_COLLIDES)) {
+      continue;
+    }
+
+    CollisionBox box = GetEntityBox(storage, set, i);
+    float delta_x = set->vel_x[i] * dt;
+    float delta_y = set->vel_y[i] * dt;
+
+    CollisionBox *swept = &swept_boxes[collider_count];
+    swept->min_x = box.min_x + Min(delta_x, 0.0f);
+    swept->min_y = box.min_y + Min(delta_y, 0.0f);
+    swept->max_x = box.max_x + Max(delta_x, 0.0f);
+    swept->max_y = box.max_y + Max(delta_y, 0.0f);
+    collider_idx[collider_count++] = i;
+
+    min_x = Min(min_x, swept->min_x);
+    min_y = Min(min_y, swept->min_y);
+    max_x = Max(max_x, swept->max_x);
+    max_y = Max(max_y, swept->max_y);
+    max_extent = Max(max_extent, swept->max_x - swept->min_x);
+    max_extent = Max(max_extent, swept->max_y - swept->min_y);
+  }
+
+  *grid = {};
+  grid->entity_count = collider_count;
+  grid->dense_idx = PushArray(arena, collider_count, uint32_t);
+  grid->boxes = PushArray(arena, collider_count, CollisionBox);
+  if (collider_count == 0) {
+    grid->cells_x = 1;
+    grid->cells_y = 1;
+    grid->cell_start = PushArray(arena, 2, uint32_t);
+    grid->cell_start[0] = 0;
+    grid->cell_start[1] = 0;
+    return;
+  }
+
+  // Grow the cells until the grid has at most a few cells per
+  // entity, so sparse sets don't pay for a huge, mostly empty grid.
+  float cell_size = Max(max_extent, 1.0f / 1024.0f);
+  float max_cell_count = 4.0f * collider_count + 64.0f;
+  float cell_count_x = (max_x - min_x) / cell_size + 1.0f;
+  float cell_count_y = (max_y - min_y) / cell_size + 1.0f;
+  if (cell_count_x * cell_count_y > max_cell_count) {
+    cell_size *= sqrtf(cell_count_x * cell_count_y / max_cell_count);
+  }
+
+  grid->origin_x = min_x;
+  grid->origin_y = min_y;
+  grid->cell_size = cell_size;
+  grid->cells_x = static_cast<int32_t>((max_x - min_x) / cell_size) + 1;
+  grid->cells_y = static_cast<int32_t>((max_y - min_y) / cell_size) + 1;
+
+  uint32_t cell_count = static_cast<uint32_t>(grid->cells_x * grid->cells_y);
+  grid->cell_start = PushArray(arena, cell_count + 1, uint32_t);
+  uint32_t *cell_cursor = PushArray(arena, cell_count, uint32_t);
+  uint32_t *entity_cell = PushArray(arena, collider_count, uint32_t);
+  for (uint32_t cell_idx = 0; cell_idx <= cell_count; ++cell_idx) {
+    grid->cell_start[cell_idx] = 0;
+  }
+
+  for (uint32_t i = 0; i < collider_count; ++i) {
+    CollisionBox *swept = &swept_boxes[i];
+    float center_x = 0.5f * (swept->min_x + swept->max_x);
+    float center_y = 0.5f * (swept->min_y + swept->max_y);
+    int32_t cell_x =
+        GetCellCoord(center_x, grid->origin_x, cell_size, grid->cells_x);
+    int32_t cell_y =
+        GetCellCoord(center_y, grid->origin_y, cell_size, grid->cells_y);
+    entity_cell[i] = static_cast<uint32_t>(cell_y * grid->cells_x + cell_x);
+    ++grid->cell_start[entity_cell[i] + 1];
+  }
+
+  for (uint32_t cell_idx = 0; cell_idx < cell_count; ++cell_idx) {
+    grid->cell_start[cell_idx + 1] += grid->cell_start[cell_idx];
+    cell_cursor[cell_idx] = grid->cell_start[cell_idx];
+  }
+
+  // Scatter in cell order so the pair search walks contiguous memory.
+  for (uint32_t i = 0; i < collider_count; ++i) {
+    uint32_t sorted_idx = cell_cursor[entity_cell[i]]++;
+    grid->dense_idx[sorted_idx] = collider_idx[i];
+    grid->boxes[sorted_idx] = swept_boxes[i];
+  }
+}
+
+uint32_t FindCollisionPairs(CollisionGrid *grid, CollisionPair *pairs,
+                            uint32_t max_pair_count) {
+  // Half of the neighbourhood is enough to see every pair exactly once.
+  static const int32_t neighbor_offsets[4][2] = {
+      {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+  uint32_t pair_count = 0;
+  for (int32_t cell_y = 0; cell_y < grid->cells_y; ++cell_y) {
+    for (int32_t cell_x = 0; cell_x < grid->cells_x; ++cell_x) {
+      uint32_t cell_idx =
+          static_cast<uint32_t>(cell_y * grid->cells_x + cell_x);
+      uint32_t first = grid->cell_start[cell_idx];
+      uint32_t last = grid->cell_start[cell_idx + 1];
+
+      for (uint32_t i = first; i < last; ++i) {
+        CollisionBox *box = &grid->boxes[i];
+
+        for (uint32_t j = i + 1; j < last; ++j) {
+          if (BoxesOverlap(box, &grid->boxes[j])) {
+            if (pair_count == max_pair_count) {
+              return pair_count;
+            }
+            pairs[pair_count++] = {grid->dense_idx[i], grid->dense_idx[j]};
+          }
+        }
+
+        for (int k = 0; k < 4; ++k) {
+          int32_t neighbor_x = cell_x + neighbor_offsets[k][0];
+          int32_t neighbor_y = cell_y + neighbor_offsets[k][1];
+          if (neighbor_x < 0 || neighbor_x >= grid->cells_x ||
+              neighbor_y >= grid->cells_y) {
+            continue;
+          }
+
+          uint32_t neighbor_idx =
+              static_cast<uint32_t>(neighbor_y * grid->cells_x + neighbor_x);
+          uint32_t neighbor_last = grid->cell_start[neighbor_idx + 1];
+          for (uint32_t j = grid->cell_start[neighbor_idx]; j < neighbor_last;
+               ++j) {
+            if (BoxesOverlap(box, &grid->boxes[j])) {
+              if (pair_count == max_pair_count) {
+                return pair_count;
+              }
+              pairs[pair_count++] = {grid->dense_idx[i], grid->dense_idx[j]};
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return pair_count;
+}
+
+bool SweepBoxes(CollisionBox *a, float delta_ax, float delta_ay,
+                CollisionBox *b, float delta_bx, float delta_by,
+                CollisionHit *hit) {
+  // Sweep a against a stationary b using the relative displacement.
+  float delta_x = delta_ax - delta_bx;
+  float delta_y = delta_ay - delta_by;
+
+  float entry_x = -INFINITY;
+  float exit_x = INFINITY;
+  if (delta_x > 0.0f) {
+    entry_x = (b->min_x - a->max_x) / delta_x;
+    exit_x = (b->max_x - a->min_x) / delta_x;
+  } else if (delta_x < 0.0f) {
+    entry_x = (b->max_x - a->min_x) / delta_x;
+    exit_x = (b->min_x - a->max_x) / delta_x;
+  } else if (a->max_x <= b->min_x || b->max_x <= a->min_x) {
+    return false;
+  }
+
+  float entry_y = -INFINITY;
+  float exit_y = INFINITY;
+  if (delta_y > 0.0f) {
+    entry_y = (b->min_y - a->max_y) / delta_y;
+    exit_y = (b->max_y - a->min_y) / delta_y;
+  } else if (delta_y < 0.0f) {
+    entry_y = (b->max_y - a->min_y) / delta_y;
+    exit_y = (b->min_y - a->max_y) / delta_y;
+  } else if (a->max_y <= b->min_y || b->max_y <= a->min_y) {
+    return false;
+  }
+
+  float entry = Max(entry_x, entry_y);
+  float exit = Min(exit_x, exit_y);
+  if (entry > exit || exit < 0.0f || entry > 1.0f) {
+    return false;
+  }
+
+  hit->t = Max(entry, 0.0f);
+  hit->normal_x = 0.0f;
+  hit->normal_y = 0.0f;
+  if (entry_x > entry_y) {
+    hit->normal_x = delta_x > 0.0f ? -1.0f : 1.0f;
+  } else {
+    hit->normal_y = delta_y > 0.0f ? -1.0f : 1.0f;
+  }
+
+  return true;
+}
+
+uint32_t ResolveEntityCollisions(EntityStorage *storage, EntitySet *set,
+                                 MemoryArena *arena, float dt) {
+  CollisionGrid grid;
+  BuildCollisionGrid(&grid, arena, storage, set, dt);
+
+  uint32_t max_pair_count = grid.entity_count * COLLISION_PAIRS_PER_ENTITY;
+  CollisionPair *pairs = PushArray(arena, max_pair_count, CollisionPair);
+  uint32_t pair_count = FindCollisionPairs(&grid, pairs, max_pair_count);
+
+  uint32_t hit_count = 0;
+  for (uint32_t pair_idx = 0; pair_idx < pair_count; ++pair_idx) {
+    uint32_t a = pairs[pair_idx].a;
+    uint32_t b = pairs[pair_idx].b;
+    CollisionBox box_a = GetEntityBox(storage, set, a);
+    CollisionBox box_b = GetEntityBox(storage, set, b);
+
+    CollisionHit hit = {};
+    if (!SweepBoxes(&box_a, set->vel_x[a] * dt, set->vel_y[a] * dt, &box_b,
+                    set->vel_x[b] * dt, set->vel_y[b] * dt, &hit)) {
+      continue;
+    }
+    ++hit_count;
+
+    // Equal masses: exchange the velocity components along the normal when
+    // the entities are approaching.
+    if (hit.normal_x != 0.0f) {
+      if ((set->vel_x[a] - set->vel_x[b]) * hit.normal_x < 0.0f) {
+        float vel_x = set->vel_x[a];
+        set->vel_x[a] = set->vel_x[b];
+        set->vel_x[b] = vel_x;
+      }
+    } else if ((set->vel_y[a] - set->vel_y[b]) * hit.normal_y < 0.0f) {
+      float vel_y = set->vel_y[a];
+      set->vel_y[a] = set->vel_y[b];
+      set->vel_y[b] = vel_y;
+    }
+  }
+
+  return hit_count;
+}
@@ -0,0 +1,54 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_COLLISION_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_COLLISION_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-entity.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const uint32_t COLLISION_PAIRS_PER_ENTITY = 8;
+
+struct CollisionBox {
+  float min_x;
+  float min_y;
+  float max_x;
+  float max_y;
+};
+
+// Entities binned by the cell holding the centre of their swept box. Cells
+// are at least as large as the largest swept box, so overlapping boxes are
+// always in the same or an adjacent cell.
+struct CollisionGrid {
+  float origin_x;
+  float origin_y;
+  float cell_size;
+  int32_t cells_x;
+  int32_t cells_y;
+  uint32_t *cell_start;
+  uint32_t entity_count;
+  uint32_t *dense_idx;
+  CollisionBox *boxes;
+};
+
+struct CollisionPair {
+  uint32_t a;
+  uint32_t b;
+};
+
+struct CollisionHit {
+  float t;
+  float normal_x;
+  float normal_y;
+};
+
+void BuildCollisionGrid(CollisionGrid *grid, MemoryArena *arena,
+                        EntityStorage *storage, EntitySet *set, float dt);
+uint32_t FindCollisionPairs(CollisionGrid *grid, CollisionPair *pairs,
+                            uint32_t max_pair_count);
+bool SweepBoxes(CollisionBox *a, float delta_ax, float delta_ay,
+                CollisionBox *b, float delta_bx, float delta_by,
+                CollisionHit *hit);
+uint32_t ResolveEntityCollisions(EntityStorage *storage, EntitySet *set,
+                                 MemoryArena *arena, float dt);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_COLLISION_H_
@@ -0,0 +1,234 @@
+#include "../../src/handmade-hero/handmade-hero-color.h"
+
+#include <emmintrin.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+static bool srgb_tables_init = false;
+static float srgb_to_linear[256];
+static uint8_t linear_to_srgb[LINEAR_TO_SRGB_TABLE_SIZE];
+
+void InitSRGBTables() {
+  if (srgb_tables_init) {
+    return;
+  }
+
+  for (int i = 0; i < 256; ++i) {
+    float value = i / 255.0f;
+    srgb_to_linear[i] = value <= 0.04045f
+                            ? value / 12.92f
+                            : powf((value + 0.055f) / 1.055f, 2.4f);
+  }
+
+  for (int i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; ++i) {
+    float value = static_cast<float>(i) / (LINEAR_TO_SRGB_TABLE_SIZE - 1);
+    float srgb = value <= 0.0031308f
+                     ? value * 12.92f
+                     : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    linear_to_srgb[i] = static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+  }
+
+  srgb_tables_init = true;
+}
+
+float SRGBToLinear(uint32_t channel) {
+  float result = srgb_to_linear[channel & 0xFF];
+  return result;
+}
+
+uint32_t LinearToSRGB(float value) {
+  int idx = static_cast<int>(value * (LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f);
+  if (idx < 0) {
+    idx = 0;
+  }
+  if (idx >= LINEAR_TO_SRGB_TABLE_SIZE) {
+    idx = LINEAR_TO_SRGB_TABLE_SIZE - 1;
+  }
+  return linear_to_srgb[idx];
+}
+
+uint32_t BlendPixelLinear(uint32_t dest, float red, float green, float blue,
+                          float alpha) {
+  float dest_red = srgb_to_linear[(dest >> 16) & 0xFF];
+  float dest_green = srgb_to_linear[(dest >> 8) & 0xFF];
+  float dest_blue = srgb_to_linear[dest & 0xFF];
+
+  uint32_t result = (dest & 0xFF000000) |
+                    (LinearToSRGB(dest_red + (red - dest_red) * alpha) << 16) |
+                    (LinearToSRGB(dest_green + (green - dest_green) * alpha)
+                     << 8) |
+                    LinearToSRGB(dest_blue + (blue - dest_blue) * alpha);
+  return result;
+}
+
+// Returns the 8-bit sRGB value of each lane in the low byte of its 32 bits.
+__m128i LinearToSRGB4(__m128 value) {
+  __m128 table_scale = _mm_set1_ps(LINEAR_TO_SRGB_TABLE_SIZE - 1.0f);
+  __m128 index = _mm_min_ps(
+      _mm_max_ps(_mm_mul_ps(value, table_scale), _mm_setzero_ps()),
+      table_scale);
+  int32_t idx[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(idx), _mm_cvtps_epi32(index));
+  __m128i result =
+      _mm_setr_epi32(linear_to_srgb[idx[0]], linear_to_srgb[idx[1]],
+                     linear_to_srgb[idx[2]], linear_to_srgb[idx[3]]);
+  return result;
+}
+
+// Lerps four BGRA pixels towards a linear color per lane. The table lookups
+// are gathered lane by lane, everything else stays in SSE registers. Dest
+// alpha is kept.
+__m128i BlendPixelsLinear4(__m128i dest, __m128 red, __m128 green,
+                           __m128 blue, __m128 alpha) {
+  uint32_t pixels[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels), dest);
+  __m128 dest_red = _mm_setr_ps(srgb_to_linear[(pixels[0] >> 16) & 0xFF],
+                                srgb_to_linear[(pixels[1] >> 16) & 0xFF],
+                                srgb_to_linear[(pixels[2] >> 16) & 0xFF],
+                                srgb_to_linear[(pixels[3] >> 16) & 0xFF]);
+  __m128 dest_green = _mm_setr_ps(srgb_to_linear[(pixels[0] >> 8) & 0xFF],
+                                  srgb_to_linear[(pixels[1] >> 8) & 0xFF],
+                                  srgb_to_linear[(pixels[2] >> 8) & 0xFF],
+                                  srgb_to_linear[(pixels[3] >> 8) & 0xFF]);
+  __m128 dest_blue = _mm_setr_ps(srgb_to_linear[pixels[0] & 0xFF],
+                                 srgb_to_linear[pixels[1] & 0xFF],
+                                 srgb_to_linear[pixels[2] & 0xFF],
+                                 srgb_to_linear[pixels[3] & 0xFF]);
+
+  red = _mm_add_ps(dest_red, _mm_mul_ps(_mm_sub_ps(red, dest_red), alpha));
+  green =
+      _mm_add_ps(dest_green, _mm_mul_ps(_mm_sub_ps(green, dest_green), alpha));
+  blue = _mm_add_ps(dest_blue, _mm_mul_ps(_mm_sub_ps(blue, dest_blue), alpha));
+
+  // Lerps between values in [0, 1] stay in range, so the table indices need
+  // no clamp.
+  __m128 table_scale = _mm_set1_ps(LINEAR_TO_SRGB_TABLE_SIZE - 1.0f);
+  int32_t red_idx[4];
+  int32_t green_idx[4];
+  int32_t blue_idx[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(red_idx),
+                   _mm_cvtps_epi32(_mm_mul_ps(red, table_scale)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(green_idx),
+                   _mm_cvtps_epi32(_mm_mul_ps(green, table_scale)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(blue_idx),
+                   _mm_cvtps_epi32(_mm_mul_ps(blue, table_scale)));
+
+  for (int lane = 0; lane < 4; ++lane) {
+    pixels[lane] = (pixels[lane] & 0xFF000000) |
+                   (linear_to_srgb[red_idx[lane]] << 16) |
+                   (linear_to_srgb[green_idx[lane]] << 8) |
+                   linear_to_srgb[blue_idx[lane]];
+  }
+  __m128i result = _mm_loadu_si128(reinterpret_cast<__m128i *>(pixels));
+  return result;
+}
+
+static inline uint32_t BlendPixelGamma(uint32_t dest, uint32_t color,
+                                       uint32_t coverage) {
+  coverage += coverage >> 7;
+  uint32_t result = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    uint32_t dest_channel = (dest >> shift) & 0xFF;
+    uint32_t color_channel = (color >> shift) & 0xFF;
+    uint32_t channel =
+        (dest_channel * (256 - coverage) + color_channel * coverage) >> 8;
+    result |= channel << shift;
+  }
+  return result;
+}
+
+// Blends the 8-bit channels directly, which is what the pipeline did before
+// and darkens edges.
+static void BlendCoverageGamma(uint32_t *dest, uint8_t *coverage, int count,
+                               uint32_t color) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i one = _mm_set1_epi16(256);
+  __m128i color_wide =
+      _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    uint32_t weights;
+    memcpy(&weights, coverage + i, sizeof(weights));
+    if (!weights) {
+      continue;
+    }
+
+    // Widen four coverage bytes to 0..256 and broadcast each across its
+    // pixel's four channels.
+    __m128i weight = _mm_unpacklo_epi8(
+        _mm_cvtsi32_si128(static_cast<int>(weights)), zero);
+    weight = _mm_add_epi16(weight, _mm_srli_epi16(weight, 7));
+    weight = _mm_unpacklo_epi16(weight, weight);
+    __m128i weight_lo = _mm_unpacklo_epi32(weight, weight);
+    __m128i weight_hi = _mm_unpackhi_epi32(weight, weight);
+
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<__m128i *>(dest + i));
+    __m128i pixels_lo = _mm_unpacklo_epi8(pixels, zero);
+    __m128i pixels_hi = _mm_unpackhi_epi8(pixels, zero);
+    pixels_lo = _mm_srli_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(pixels_lo, _mm_sub_epi16(one, weight_lo)),
+                      _mm_mullo_epi16(color_wide, weight_lo)),
+        8);
+    pixels_hi = _mm_srli_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(pixels_hi, _mm_sub_epi16(one, weight_hi)),
+                      _mm_mullo_epi16(color_wide, weight_hi)),
+        8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i),
+                     _mm_packus_epi16(pixels_lo, pixels_hi));
+  }
+  for (; i < count; ++i) {
+    if (coverage[i]) {
+      dest[i] = BlendPixelGamma(dest[i], color, coverage[i]);
+    }
+  }
+}
+
+// Decodes four pixels per step through the sRGB table, lerps in linear
+// float, and re-encodes through the quantized inverse table.
+static void BlendCoverageLinear(uint32_t *dest, uint8_t *coverage, int count,
+                                uint32_t color) {
+  __m128 color_red = _mm_set1_ps(srgb_to_linear[(color >> 16) & 0xFF]);
+  __m128 color_green = _mm_set1_ps(srgb_to_linear[(color >> 8) & 0xFF]);
+  __m128 color_blue = _mm_set1_ps(srgb_to_linear[color & 0xFF]);
+  __m128 coverage_scale = _mm_set1_ps(1.0f / 255.0f);
+  __m128i zero = _mm_setzero_si128();
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    uint32_t weights;
+    memcpy(&weights, coverage + i, sizeof(weights));
+    if (!weights) {
+      continue;
+    }
+
+    __m128i weight = _mm_unpacklo_epi16(
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(weights)), zero),
+        zero);
+    __m128 alpha = _mm_mul_ps(_mm_cvtepi32_ps(weight), coverage_scale);
+
+    __m128i *pixels = reinterpret_cast<__m128i *>(dest + i);
+    _mm_storeu_si128(pixels,
+                     BlendPixelsLinear4(_mm_loadu_si128(pixels), color_red,
+                                        color_green, color_blue, alpha));
+  }
+  for (; i < count; ++i) {
+    if (coverage[i]) {
+      dest[i] = BlendPixelLinear(dest[i], srgb_to_linear[(color >> 16) & 0xFF],
+                                 srgb_to_linear[(color >> 8) & 0xFF],
+                                 srgb_to_linear[color & 0xFF],
+                                 coverage[i] / 255.0f);
+    }
+  }
+}
+
+void BlendCoverageSpan(uint32_t *dest, uint8_t *coverage, int count,
+                       uint32_t color, BlendSpace blend_space) {
+  if (blend_space == BLEND_SPACE_LINEAR) {
+    BlendCoverageLinear(dest, coverage, count, color);
+  } else {
+    BlendCoverageGamma(dest, coverage, count, color);
+  }
+}
@@ -0,0 +1,26 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_COLOR_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_COLOR_H_
+
+#include <emmintrin.h>
+
+#include <cstdint>
+
+static const int LINEAR_TO_SRGB_TABLE_SIZE = 4096;
+
+enum BlendSpace {
+  BLEND_SPACE_GAMMA,
+  BLEND_SPACE_LINEAR,
+};
+
+void InitSRGBTables();
+float SRGBToLinear(uint32_t channel);
+uint32_t LinearToSRGB(float value);
+uint32_t BlendPixelLinear(uint32_t dest, float red, float green, float blue,
+                          float alpha);
+__m128i LinearToSRGB4(__m128 value);
+__m128i BlendPixelsLinear4(__m128i dest, __m128 red, __m128 green,
+                           __m128 blue, __m128 alpha);
+void BlendCoverageSpan(uint32_t *dest, uint8_t *coverage, int count,
+                       uint32_t color, BlendSpace blend_space);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_COLOR_H_
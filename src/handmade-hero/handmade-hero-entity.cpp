@@ -0,0 +1,181 @@
+#include "../../src/handmade-hero/handmade-hero-entity.h"
+
+#include <emmintrin.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static void InitEntitySet(EntitySet *set, MemoryArena *arena,
+                          uint32_t capacity) {
+  set->count = 0;
+  set->pos_x = PushArray(arena, capacity, float);
+  set->pos_y = PushArray(arena, capacity, float);
+  set->vel_x = PushArray(arena, capacity, float);
+  set->vel_y = PushArray(arena, capacity, float);
+  set->flags = PushArray(arena, capacity, uint32_t);
+  set->slot_idx = PushArray(arena, capacity, uint32_t);
+}
+
+static uint32_t PushEntityToSet(EntitySet *set, uint32_t slot_idx,
+                                float pos_x, float pos_y, float vel_x,
+                                float vel_y, uint32_t flags) {
+  uint32_t dense_idx = set->count++;
+  set->pos_x[dense_idx] = pos_x;
+  set->pos_y[dense_idx] = pos_y;
+  set->vel_x[dense_idx] = vel_x;
+  set->vel_y[dense_idx] = vel_y;
+  set->flags[dense_idx] = flags;
+  set->slot_idx[dense_idx] = slot_idx;
+  return dense_idx;
+}
+
+// Swap-removes a dense entry and repoints the slot of the entity that was
+// moved into the hole.
+static void RemoveEntityFromSet(EntityStorage *storage, EntitySet *set,
+                                uint32_t dense_idx) {
+  uint32_t last_idx = --set->count;
+  if (dense_idx != last_idx) {
+    set->pos_x[dense_idx] = set->pos_x[last_idx];
+    set->pos_y[dense_idx] = set->pos_y[last_idx];
+    set->vel_x[dense_idx] = set->vel_x[last_idx];
+    set->vel_y[dense_idx] = set->vel_y[last_idx];
+    set->flags[dense_idx] = set->flags[last_idx];
+    set->slot_idx[dense_idx] = set->slot_idx[last_idx];
+    storage->slots[set->slot_idx[dense_idx]].dense_idx = dense_idx;
+  }
+}
+
+static void MoveEntityToSet(EntityStorage *storage, uint32_t from_type,
+                            uint32_t dense_idx, uint32_t to_type) {
+  EntitySet *from = &storage->sets[from_type];
+  EntitySet *to = &storage->sets[to_type];
+  uint32_t slot_idx = from->slot_idx[dense_idx];
+
+  EntitySlot *slot = &storage->slots[slot_idx];
+  slot->set_type = to_type;
+  slot->dense_idx = PushEntityToSet(
+      to, slot_idx, from->pos_x[dense_idx], from->pos_y[dense_idx],
+      from->vel_x[dense_idx], from->vel_y[dense_idx], from->flags[dense_idx]);
+
+  RemoveEntityFromSet(storage, from, dense_idx);
+}
+
+void InitEntityStorage(EntityStorage *storage, MemoryArena *arena,
+                       uint32_t capacity) {
+  capacity = (capacity + 3) & ~3u;
+
+  storage->capacity = capacity;
+  storage->count = 0;
+  storage->used_slot_count = 0;
+  storage->first_free_slot = ENTITY_NULL_SLOT;
+  storage->slots = PushArray(arena, capacity, EntitySlot);
+  storage->cold = PushArray(arena, capacity, EntityCold);
+  for (int i = 0; i < ENTITY_SET_COUNT; ++i) {
+    InitEntitySet(&storage->sets[i], arena, capacity);
+  }
+}
+
+EntityHandle AddEntity(EntityStorage *storage, EntityCold *cold, float pos_x,
+                       float pos_y, float vel_x, float vel_y, uint32_t flags) {
+  EntityHandle result = {ENTITY_NULL_SLOT, 0};
+
+  uint32_t slot_idx = storage->first_free_slot;
+  if (slot_idx != ENTITY_NULL_SLOT) {
+    storage->first_free_slot = storage->slots[slot_idx].next_free;
+  } else if (storage->used_slot_count < storage->capacity) {
+    slot_idx = storage->used_slot_count++;
+    storage->slots[slot_idx].generation = 1;
+  } else {
+    return result;
+  }
+
+  // New entities start in the low frequency set until the next set update
+  // finds them near the camera.
+  EntitySlot *slot = &storage->slots[slot_idx];
+  slot->set_type = ENTITY_SET_LOW;
+  slot->next_free = ENTITY_NULL_SLOT;
+  slot->dense_idx = PushEntityToSet(&storage->sets[ENTITY_SET_LOW], slot_idx,
+                                    pos_x, pos_y, vel_x, vel_y, flags);
+  storage->cold[slot_idx] = *cold;
+  ++storage->count;
+
+  result.slot_idx = slot_idx;
+  result.generation = slot->generation;
+  return result;
+}
+
+bool IsEntityValid(EntityStorage *storage, EntityHandle handle) {
+  bool result = handle.slot_idx < storage->used_slot_count &&
+                storage->slots[handle.slot_idx].generation == handle.generation;
+  return result;
+}
+
+bool RemoveEntity(EntityStorage *storage, EntityHandle handle) {
+  if (!IsEntityValid(storage, handle)) {
+    return false;
+  }
+
+  EntitySlot *slot = &storage->slots[handle.slot_idx];
+  RemoveEntityFromSet(storage, &storage->sets[slot->set_type],
+                      slot->dense_idx);
+
+  ++slot->generation;
+  slot->next_free = storage->first_free_slot;
+  storage->first_free_slot = handle.slot_idx;
+  --storage->count;
+
+  return true;
+}
+
+EntityCold *GetEntityCold(EntityStorage *storage, EntityHandle handle) {
+  EntityCold *result = 0;
+  if (IsEntityValid(storage, handle)) {
+    result = &storage->cold[handle.slot_idx];
+  }
+  return result;
+}
+
+void UpdateEntitySets(EntityStorage *storage, float min_x, float min_y,
+                      float max_x, float max_y) {
+  // Walking backwards means the entry swapped into a hole has already been
+  // visited.
+  EntitySet *high = &storage->sets[ENTITY_SET_HIGH];
+  for (uint32_t i = high->count; i-- > 0;) {
+    float x = high->pos_x[i];
+    float y = high->pos_y[i];
+    if (x < min_x || x >= max_x || y < min_y || y >= max_y) {
+      MoveEntityToSet(storage, ENTITY_SET_HIGH, i, ENTITY_SET_LOW);
+    }
+  }
+
+  EntitySet *low = &storage->sets[ENTITY_SET_LOW];
+  for (uint32_t i = low->count; i-- > 0;) {
+    float x = low->pos_x[i];
+    float y = low->pos_y[i];
+    if (x >= min_x && x < max_x && y >= min_y && y < max_y) {
+      MoveEntityToSet(storage, ENTITY_SET_LOW, i, ENTITY_SET_HIGH);
+    }
+  }
+}
+
+// Entities without ENTITY_FLAG_MOVES keep their position whatever their
+// velocity.
+void SimulateEntities(EntitySet *set, float dt) {
+  __m128 dt_wide = _mm_set1_ps(dt);
+  __m128i moves_flag = _mm_set1_epi32(ENTITY_FLAG_MOVES);
+  for (uint32_t i = 0; i < set->count; i += 4) {
+    __m128i flags =
+        _mm_loadu_si128(reinterpret_cast<__m128i *>(set->flags + i));
+    __m128 moves = _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_and_si128(flags, moves_flag), moves_flag));
+    __m128 pos_x = _mm_loadu_ps(set->pos_x + i);
+    __m128 pos_y = _mm_loadu_ps(set->pos_y + i);
+    __m128 vel_x = _mm_loadu_ps(set->vel_x + i);
+    __m128 vel_y = _mm_loadu_ps(set->vel_y + i);
+    pos_x = _mm_add_ps(pos_x, _mm_and_ps(moves, _mm_mul_ps(vel_x, dt_wide)));
+    pos_y = _mm_add_ps(pos_y, _mm_and_ps(moves, _mm_mul_ps(vel_y, dt_wide)));
+    _mm_storeu_ps(set->pos_x + i, pos_x);
+    _mm_storeu_ps(set->pos_y + i, pos_y);
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_ENTITY_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_ENTITY_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const uint32_t ENTITY_NULL_SLOT = 0xFFFFFFFF;
+
+enum EntitySetType {
+  ENTITY_SET_HIGH,
+  ENTITY_SET_LOW,
+  ENTITY_SET_COUNT,
+};
+
+enum EntityFlag {
+  ENTITY_FLAG_MOVES = 1 << 0,
+  ENTITY_FLAG_COLLIDES = 1 << 1,
+  ENTITY_FLAG_SEEKS_GOAL = 1 << 2,
+};
+
+struct EntityHandle {
+  uint32_t slot_idx;
+  uint32_t generation;
+};
+
+// Hot fields simulated every frame, one array per field. Arrays are sized to
+// a multiple of four so SIMD loops can run past count without a tail.
+struct EntitySet {
+  uint32_t count;
+  float *pos_x;
+  float *pos_y;
+  float *vel_x;
+  float *vel_y;
+  uint32_t *flags;
+  uint32_t *slot_idx;
+};
+
+struct EntityCold {
+  uint32_t type;
+  float width;
+  float height;
+  uint32_t color;
+};
+
+struct EntitySlot {
+  uint32_t generation;
+  uint32_t set_type;
+  uint32_t dense_idx;
+  uint32_t next_free;
+};
+
+struct EntityStorage {
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t used_slot_count;
+  uint32_t first_free_slot;
+  EntitySlot *slots;
+  EntityCold *cold;
+  EntitySet sets[ENTITY_SET_COUNT];
+};
+
+void InitEntityStorage(EntityStorage *storage, MemoryArena *arena,
+                       uint32_t capacity);
+EntityHandle AddEntity(EntityStorage *storage, EntityCold *cold, float pos_x,
+                       float pos_y, float vel_x, float vel_y, uint32_t flags);
+bool IsEntityValid(EntityStorage *storage, EntityHandle handle);
+bool RemoveEntity(EntityStorage *storage, EntityHandle handle);
+EntityCold *GetEntityCold(EntityStorage *storage, EntityHandle handle);
+void UpdateEntitySets(EntityStorage *storage, float min_x, float min_y,
+                      float max_x, float max_y);
+void SimulateEntities(EntitySet *set, float dt);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_ENTITY_H_
@@ -0,0 +1,237 @@
+#include "../../src/handmade-hero/handmade-hero-flow.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-stream.h"
+#include "../../src/handmade-hero/handmade-hero-world.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const int FLOW_DIRECTION_COUNT = 8;
+static const float FLOW_DIAGONAL = 0.70710678f;
+
+// Orthogonal neighbours come first so BFS only walks those four.
+static const int FLOW_NEIGHBOR_X[FLOW_DIRECTION_COUNT] = {1, -1, 0, 0,
+                                                          1, -1, 1, -1};
+static const int FLOW_NEIGHBOR_Y[FLOW_DIRECTION_COUNT] = {0, 0, 1, -1,
+                                                          1, 1, -1, -1};
+
+static void FillBlockedCells(FlowFieldCache *cache, FlowField *field,
+                             World *world, ChunkStreamer *streamer) {
+  static_assert(FLOW_FIELD_CHUNK_SPAN * FLOW_FIELD_CHUNK_SPAN <= 64,
+                "Unknown chunks must fit the 64-bit mask");
+
+  field->unknown_chunk_mask = 0;
+  int32_t origin_chunk_x = field->origin_x >> TILE_CHUNK_SHIFT;
+  int32_t origin_chunk_y = field->origin_y >> TILE_CHUNK_SHIFT;
+  for (int chunk_y = 0; chunk_y < FLOW_FIELD_CHUNK_SPAN; ++chunk_y) {
+    for (int chunk_x = 0; chunk_x < FLOW_FIELD_CHUNK_SPAN; ++chunk_x) {
+      TileChunk *chunk = GetTileChunk(world, origin_chunk_x + chunk_x,
+                                      origin_chunk_y + chunk_y);
+      bool is_unknown =
+          !chunk && IsChunkStreamed(streamer, origin_chunk_x + chunk_x,
+                                    origin_chunk_y + chunk_y);
+      if (is_unknown) {
+        field->unknown_chunk_mask |=
+            1ull << (chunk_y * FLOW_FIELD_CHUNK_SPAN + chunk_x);
+      }
+
+      uint8_t *row = &cache->blocked[chunk_y * TILE_CHUNK_DIM * FLOW_FIELD_DIM +
+                                     chunk_x * TILE_CHUNK_DIM];
+      for (int y = 0; y < TILE_CHUNK_DIM; ++y) {
+        for (int x = 0; x < TILE_CHUNK_DIM; ++x) {
+          uint32_t tile = chunk ? chunk->tiles[y * TILE_CHUNK_DIM + x] : 0;
+          row[x] = is_unknown || tile == TILE_VALUE_WALL;
+        }
+        row += FLOW_FIELD_DIM;
+      }
+    }
+  }
+}
+
+static bool HasUnknownChunkLoaded(FlowField *field, World *world) {
+  int32_t origin_chunk_x = field->origin_x >> TILE_CHUNK_SHIFT;
+  int32_t origin_chunk_y = field->origin_y >> TILE_CHUNK_SHIFT;
+  for (int i = 0; i < FLOW_FIELD_CHUNK_SPAN * FLOW_FIELD_CHUNK_SPAN; ++i) {
+    if ((field->unknown_chunk_mask & (1ull << i)) &&
+        GetTileChunk(world, origin_chunk_x + i % FLOW_FIELD_CHUNK_SPAN,
+                     origin_chunk_y + i / FLOW_FIELD_CHUNK_SPAN)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void IntegrateFlowField(FlowFieldCache *cache, FlowField *field) {
+  for (int i = 0; i < FLOW_FIELD_CELL_COUNT; ++i) {
+    field->costs[i] = FLOW_COST_UNREACHABLE;
+  }
+
+  int goal_idx = (field->goal_y - field->origin_y) * FLOW_FIELD_DIM +
+                 (field->goal_x - field->origin_x);
+  if (cache->blocked[goal_idx]) {
+    return;
+  }
+
+  // Every step costs the same, so a breadth-first walk visits cells in cost
+  // order and each cell is settled the first time it is reached.
+  int read_idx = 0;
+  int write_idx = 0;
+  field->costs[goal_idx] = 0;
+  cache->queue[write_idx++] = static_cast<uint16_t>(goal_idx);
+  while (read_idx < write_idx) {
+    int idx = cache->queue[read_idx++];
+    int x = idx % FLOW_FIELD_DIM;
+    int y = idx / FLOW_FIELD_DIM;
+    uint16_t cost = field->costs[idx] + 1;
+    for (int d = 0; d < 4; ++d) {
+      int next_x = x + FLOW_NEIGHBOR_X[d];
+      int next_y = y + FLOW_NEIGHBOR_Y[d];
+      if (next_x < 0 || next_y < 0 || next_x >= FLOW_FIELD_DIM ||
+          next_y >= FLOW_FIELD_DIM) {
+        continue;
+      }
+      int next_idx = next_y * FLOW_FIELD_DIM + next_x;
+      if (cache->blocked[next_idx] ||
+          field->costs[next_idx] != FLOW_COST_UNREACHABLE) {
+        continue;
+      }
+      field->costs[next_idx] = cost;
+      cache->queue[write_idx++] = static_cast<uint16_t>(next_idx);
+    }
+  }
+}
+
+static inline uint16_t GetFlowCost(FlowField *field, int x, int y) {
+  uint16_t result = FLOW_COST_UNREACHABLE;
+  if (x >= 0 && y >= 0 && x < FLOW_FIELD_DIM && y < FLOW_FIELD_DIM) {
+    result = field->costs[y * FLOW_FIELD_DIM + x];
+  }
+  return result;
+}
+
+static void PointFlowField(FlowField *field) {
+  for (int y = 0; y < FLOW_FIELD_DIM; ++y) {
+    for (int x = 0; x < FLOW_FIELD_DIM; ++x) {
+      int idx = y * FLOW_FIELD_DIM + x;
+      uint16_t best_cost = field->costs[idx];
+      uint8_t best_direction = FLOW_DIRECTION_NONE;
+      for (int d = 0; d < FLOW_DIRECTION_COUNT; ++d) {
+        int dx = FLOW_NEIGHBOR_X[d];
+        int dy = FLOW_NEIGHBOR_Y[d];
+        uint16_t cost = GetFlowCost(field, x + dx, y + dy);
+        // A diagonal step must not clip the corner of a wall.
+        if (dx && dy &&
+            (GetFlowCost(field, x + dx, y) == FLOW_COST_UNREACHABLE ||
+             GetFlowCost(field, x, y + dy) == FLOW_COST_UNREACHABLE)) {
+          continue;
+        }
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_direction = static_cast<uint8_t>(d);
+        }
+      }
+      field->directions[idx] = best_direction;
+    }
+  }
+}
+
+static void BuildFlowField(FlowFieldCache *cache, FlowField *field,
+                           World *world, ChunkStreamer *streamer,
+                           int32_t goal_x, int32_t goal_y) {
+  int32_t half_span = FLOW_FIELD_CHUNK_SPAN / 2;
+  field->is_valid = true;
+  field->goal_x = goal_x;
+  field->goal_y = goal_y;
+  field->origin_x = ((goal_x >> TILE_CHUNK_SHIFT) - half_span) * TILE_CHUNK_DIM;
+  field->origin_y = ((goal_y >> TILE_CHUNK_SHIFT) - half_span) * TILE_CHUNK_DIM;
+  field->world_version = world->version;
+
+  FillBlockedCells(cache, field, world, streamer);
+  IntegrateFlowField(cache, field);
+  PointFlowField(field);
+
+  ++cache->builds_this_frame;
+  ++cache->stats.build_count;
+}
+
+void BeginFlowFieldFrame(FlowFieldCache *cache) {
+  ++cache->frame_idx;
+  cache->builds_this_frame = 0;
+}
+
+// Builds are capped per frame. Past the cap a stale field is still served,
+// and a goal with no field yet gets none until a later frame.
+FlowField *GetFlowField(FlowFieldCache *cache, World *world,
+                        ChunkStreamer *streamer, int32_t goal_x,
+                        int32_t goal_y) {
+  FlowField *result = 0;
+  for (int i = 0; i < FLOW_CACHE_FIELD_COUNT; ++i) {
+    FlowField *field = &cache->fields[i];
+    if (field->is_valid && field->goal_x == goal_x &&
+        field->goal_y == goal_y) {
+      result = field;
+      break;
+    }
+  }
+
+  bool can_build = cache->builds_this_frame < FLOW_MAX_BUILDS_PER_FRAME;
+  if (result) {
+    if (!HasWorldChanged(world, result->world_version, result->origin_x,
+                         result->origin_y,
+                         result->origin_x + FLOW_FIELD_DIM - 1,
+                         result->origin_y + FLOW_FIELD_DIM - 1) &&
+        !HasUnknownChunkLoaded(result, world)) {
+      result->world_version = world->version;
+      ++cache->stats.hit_count;
+    } else if (can_build) {
+      BuildFlowField(cache, result, world, streamer, goal_x, goal_y);
+      ++cache->stats.invalidated_count;
+    } else {
+      ++cache->stats.stale_count;
+    }
+  } else if (can_build) {
+    // Fields already handed out this frame are never recycled.
+    FlowField *victim = 0;
+    for (int i = 0; i < FLOW_CACHE_FIELD_COUNT; ++i) {
+      FlowField *field = &cache->fields[i];
+      if (!field->is_valid) {
+        victim = field;
+        break;
+      }
+      if (field->last_used_frame != cache->frame_idx &&
+          (!victim || field->last_used_frame < victim->last_used_frame)) {
+        victim = field;
+      }
+    }
+
+    if (victim) {
+      BuildFlowField(cache, victim, world, streamer, goal_x, goal_y);
+      result = victim;
+    }
+  }
+
+  if (result) {
+    result->last_used_frame = cache->frame_idx;
+  }
+  return result;
+}
+
+bool GetFlowDirection(FlowField *field, float pos_x, float pos_y,
+                      float *dir_x, float *dir_y) {
+  int x = static_cast<int>(floorf(pos_x)) - field->origin_x;
+  int y = static_cast<int>(floorf(pos_y)) - field->origin_y;
+  if (x < 0 || y < 0 || x >= FLOW_FIELD_DIM || y >= FLOW_FIELD_DIM) {
+    return false;
+  }
+
+  uint8_t direction = field->directions[y * FLOW_FIELD_DIM + x];
+  if (direction == FLOW_DIRECTION_NONE) {
+    return false;
+  }
+
+  float scale = direction < 4 ? 1.0f : FLOW_DIAGONAL;
+  *dir_x = FLOW_NEIGHBOR_X[direction] * scale;
+  *dir_y = FLOW_NEIGHBOR_Y[direction] * scale;
+  return true;
+}
@@ -0,0 +1,62 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_FLOW_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_FLOW_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-stream.h"
+#include "../../src/handmade-hero/handmade-hero-world.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const int FLOW_FIELD_CHUNK_SPAN = 8;
+static const int FLOW_FIELD_DIM = FLOW_FIELD_CHUNK_SPAN * TILE_CHUNK_DIM;
+static const int FLOW_FIELD_CELL_COUNT = FLOW_FIELD_DIM * FLOW_FIELD_DIM;
+static const int FLOW_CACHE_FIELD_COUNT = 8;
+static const int FLOW_MAX_BUILDS_PER_FRAME = 2;
+static const uint16_t FLOW_COST_UNREACHABLE = 0xFFFF;
+static const uint8_t FLOW_DIRECTION_NONE = 0xFF;
+
+// Integration costs are BFS steps to the goal; directions index the eight
+// neighbours, pointing at the cheapest one. A field covers a chunk-aligned
+// square around its goal. Streamed chunks that were not resident when it was
+// built count as walls, and their bits in unknown_chunk_mask get it rebuilt
+// once one of them loads.
+struct FlowField {
+  bool is_valid;
+  int32_t goal_x;
+  int32_t goal_y;
+  int32_t origin_x;
+  int32_t origin_y;
+  uint32_t world_version;
+  uint64_t unknown_chunk_mask;
+  uint64_t last_used_frame;
+  uint16_t costs[FLOW_FIELD_CELL_COUNT];
+  uint8_t directions[FLOW_FIELD_CELL_COUNT];
+};
+
+struct FlowFieldStats {
+  int64_t hit_count;
+  int64_t build_count;
+  int64_t invalidated_count;
+  int64_t stale_count;
+};
+
+// Lives in transient storage across frames. Fields are keyed by goal tile and
+// checked against the world's change log, so an edit only rebuilds the fields
+// whose square it touches.
+struct FlowFieldCache {
+  FlowField fields[FLOW_CACHE_FIELD_COUNT];
+  uint64_t frame_idx;
+  int builds_this_frame;
+  uint8_t blocked[FLOW_FIELD_CELL_COUNT];
+  uint16_t queue[FLOW_FIELD_CELL_COUNT];
+  FlowFieldStats stats;
+};
+
+void BeginFlowFieldFrame(FlowFieldCache *cache);
+FlowField *GetFlowField(FlowFieldCache *cache, World *world,
+                        ChunkStreamer *streamer, int32_t goal_x,
+                        int32_t goal_y);
+bool GetFlowDirection(FlowField *field, float pos_x, float pos_y,
+                      float *dir_x, float *dir_y);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_FLOW_H_
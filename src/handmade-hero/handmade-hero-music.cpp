@@ -0,0 +1,331 @@
+#include "../../src/handmade-hero/handmade-hero-music.h"
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const int32_t ADPCM_STEP_TABLE[ADPCM_STEP_INDEX_MAX + 1] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+static const int32_t ADPCM_INDEX_TABLE[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static inline int16_t DecodeAdpcmNibble(AdpcmState *state, uint32_t nibble) {
+  int32_t step = ADPCM_STEP_TABLE[state->step_index];
+  int32_t diff = step >> 3;
+  if (nibble & 4) {
+    diff += step;
+  }
+  if (nibble & 2) {
+    diff += step >> 1;
+  }
+  if (nibble & 1) {
+    diff += step >> 2;
+  }
+
+  int32_t predictor = state->predictor + ((nibble & 8) ? -diff : diff);
+  if (predictor < -32768) {
+    predictor = -32768;
+  }
+  if (predictor > 32767) {
+    predictor = 32767;
+  }
+  state->predictor = predictor;
+
+  int32_t step_index = state->step_index + ADPCM_INDEX_TABLE[nibble & 7];
+  if (step_index < 0) {
+    step_index = 0;
+  }
+  if (step_index > ADPCM_STEP_INDEX_MAX) {
+    step_index = ADPCM_STEP_INDEX_MAX;
+  }
+  state->step_index = step_index;
+
+  return static_cast<int16_t>(predictor);
+}
+
+// Quantizes the difference to the prediction, then runs the decoder on the
+// result so encoder and decoder states never drift apart.
+static inline uint32_t EncodeAdpcmSample(AdpcmState *state, int32_t sample) {
+  int32_t step = ADPCM_STEP_TABLE[state->step_index];
+  int32_t diff = sample - state->predictor;
+  uint32_t nibble = 0;
+  if (diff < 0) {
+    nibble = 8;
+    diff = -diff;
+  }
+  if (diff >= step) {
+    nibble |= 4;
+    diff -= step;
+  }
+  if (diff >= step >> 1) {
+    nibble |= 2;
+    diff -= step >> 1;
+  }
+  if (diff >= step >> 2) {
+    nibble |= 1;
+  }
+
+  DecodeAdpcmNibble(state, nibble);
+  return nibble;
+}
+
+static void EncodeChannelBlock(AdpcmState *state, int16_t *samples,
+                               uint32_t stride, int frame_count,
+                               uint8_t *dest) {
+  AdpcmBlockHeader *header = reinterpret_cast<AdpcmBlockHeader *>(dest);
+  header->predictor = static_cast<int16_t>(state->predictor);
+  header->step_index = static_cast<uint8_t>(state->step_index);
+  header->reserved = 0;
+
+  // The last block is padded with silence.
+  uint8_t *nibbles = dest + sizeof(AdpcmBlockHeader);
+  for (int i = 0; i < MUSIC_BLOCK_FRAMES; i += 2) {
+    int32_t first = i < frame_count ? samples[i * stride] : 0;
+    int32_t second = i + 1 < frame_count ? samples[(i + 1) * stride] : 0;
+    uint32_t low = EncodeAdpcmSample(state, first);
+    uint32_t high = EncodeAdpcmSample(state, second);
+    nibbles[i / 2] = static_cast<uint8_t>(low | (high << 4));
+  }
+}
+
+static void DecodeChannelBlock(uint8_t *data, int16_t *samples) {
+  AdpcmBlockHeader *header = reinterpret_cast<AdpcmBlockHeader *>(data);
+  AdpcmState state = {};
+  state.predictor = header->predictor;
+  state.step_index = header->step_index > ADPCM_STEP_INDEX_MAX
+                         ? ADPCM_STEP_INDEX_MAX
+                         : header->step_index;
+
+  uint8_t *nibbles = data + sizeof(AdpcmBlockHeader);
+  for (int i = 0; i < MUSIC_BLOCK_FRAMES; i += 2) {
+    samples[i] = DecodeAdpcmNibble(&state, nibbles[i / 2] & 0xF);
+    samples[i + 1] = DecodeAdpcmNibble(&state, nibbles[i / 2] >> 4);
+  }
+}
+
+uint32_t GetMusicFileSize(uint32_t frame_count) {
+  uint32_t block_count =
+      (frame_count + MUSIC_BLOCK_FRAMES - 1) / MUSIC_BLOCK_FRAMES;
+  uint32_t result = static_cast<uint32_t>(sizeof(MusicFileHeader)) +
+                    block_count * MUSIC_BLOCK_SIZE;
+  return result;
+}
+
+// samples holds channel_count interleaved 16-bit channels; mono is written
+// to both output channels. Returns the encoded size, or 0 if it did not fit.
+uint32_t EncodeMusic(int16_t *samples, uint32_t frame_count,
+                     uint32_t channel_count, uint32_t samples_per_second,
+                     uint8_t *dest, uint32_t dest_size) {
+  uint32_t result = GetMusicFileSize(frame_count);
+  if (frame_count == 0 || channel_count < 1 || channel_count > 2 ||
+      result > dest_size) {
+    return 0;
+  }
+
+  MusicFileHeader *header = reinterpret_cast<MusicFileHeader *>(dest);
+  header->magic = MUSIC_FILE_MAGIC;
+  header->version = MUSIC_FILE_VERSION;
+  header->samples_per_second = samples_per_second;
+  header->channel_count = MUSIC_CHANNEL_COUNT;
+  header->block_frames = MUSIC_BLOCK_FRAMES;
+  header->block_size = MUSIC_BLOCK_SIZE;
+  header->block_count =
+      (frame_count + MUSIC_BLOCK_FRAMES - 1) / MUSIC_BLOCK_FRAMES;
+  header->frame_count = frame_count;
+
+  AdpcmState states[MUSIC_CHANNEL_COUNT] = {};
+  uint8_t *block = dest + sizeof(MusicFileHeader);
+  for (uint32_t block_idx = 0; block_idx < header->block_count; ++block_idx) {
+    uint32_t first_frame = block_idx * MUSIC_BLOCK_FRAMES;
+    uint32_t remaining_count = frame_count - first_frame;
+    int block_frame_count = remaining_count < MUSIC_BLOCK_FRAMES
+                                ? static_cast<int>(remaining_count)
+                                : MUSIC_BLOCK_FRAMES;
+    for (uint32_t channel = 0; channel < MUSIC_CHANNEL_COUNT; ++channel) {
+      uint32_t source_channel = channel < channel_count ? channel : 0;
+      EncodeChannelBlock(
+          &states[channel],
+          samples + first_frame * channel_count + source_channel,
+          channel_count, block_frame_count,
+          block + channel * MUSIC_CHANNEL_BLOCK_SIZE);
+    }
+    block += MUSIC_BLOCK_SIZE;
+  }
+
+  return result;
+}
+
+void DecodeMusicBlock(uint8_t *data, int16_t *left, int16_t *right) {
+  DecodeChannelBlock(data, left);
+  DecodeChannelBlock(data + MUSIC_CHANNEL_BLOCK_SIZE, right);
+}
+
+static bool IsMusicFileHeaderValid(MusicFileHeader *header,
+                                   int samples_per_second) {
+  bool result = header->magic == MUSIC_FILE_MAGIC &&
+                header->version == MUSIC_FILE_VERSION &&
+                header->samples_per_second ==
+                    static_cast<uint32_t>(samples_per_second) &&
+                header->channel_count == MUSIC_CHANNEL_COUNT &&
+                header->block_frames == MUSIC_BLOCK_FRAMES &&
+                header->block_size == MUSIC_BLOCK_SIZE &&
+                header->frame_count > 0 &&
+                header->block_count ==
+                    (static_cast<uint64_t>(header->frame_count) +
+                     MUSIC_BLOCK_FRAMES - 1) /
+                        MUSIC_BLOCK_FRAMES;
+  return result;
+}
+
+// Blocks are numbered across loops, so the first block of a loop follows the
+// partial last block of the one before it.
+static uint64_t GetMusicBlockSequence(MusicFileHeader *header, uint64_t frame,
+                                      uint32_t *track_frame) {
+  uint64_t loop = frame / header->frame_count;
+  *track_frame = static_cast<uint32_t>(frame % header->frame_count);
+  uint64_t result =
+      loop * header->block_count + *track_frame / MUSIC_BLOCK_FRAMES;
+  return result;
+}
+
+// There is no resampler, so a file baked at another rate stays silent.
+static void InitMusicLoadQueue(MusicLoadQueue *queue, PlatformApi *platform,
+                               const char *file_name,
+                               int samples_per_second) {
+  queue->is_init = true;
+  if (!platform->OpenFile || !platform->ReadFile || !platform->QueueRead) {
+    return;
+  }
+
+  void *file = platform->OpenFile(file_name);
+  if (!file) {
+    return;
+  }
+
+  if (!platform->ReadFile(file, 0, sizeof(queue->header), &queue->header)) {
+    platform->CloseFile(file);
+    return;
+  }
+  if (!IsMusicFileHeaderValid(&queue->header, samples_per_second)) {
+#if DEV
+    Log(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET,
+        "Music file rejected: version %u, %u Hz, %u channels, %u blocks of "
+        "%u frames for %u frames; the game plays at %d Hz",
+        queue->header.version, queue->header.samples_per_second,
+        queue->header.channel_count, queue->header.block_count,
+        queue->header.block_frames, queue->header.frame_count,
+        samples_per_second);
+#endif
+    platform->CloseFile(file);
+    return;
+  }
+  queue->file = file;
+}
+
+// Keeps the next MUSIC_BLOCK_SLOT_COUNT blocks past the play position read
+// and decoded, so mixing never waits on the disk or the decoder.
+void UpdateMusicStream(MusicPlayer *player, MusicLoadQueue *queue,
+                       PlatformApi *platform, const char *file_name,
+                       int samples_per_second) {
+  if (!queue->is_init) {
+    InitMusicLoadQueue(queue, platform, file_name, samples_per_second);
+  }
+  if (!queue->file) {
+    return;
+  }
+
+  uint32_t track_frame;
+  uint64_t first_sequence =
+      GetMusicBlockSequence(&queue->header, player->play_frame, &track_frame);
+  for (uint64_t sequence = first_sequence;
+       sequence < first_sequence + MUSIC_BLOCK_SLOT_COUNT; ++sequence) {
+    MusicBlock *block = &queue->blocks[sequence % MUSIC_BLOCK_SLOT_COUNT];
+    if (block->status == PLATFORM_READ_PENDING) {
+      continue;
+    }
+
+    if (block->sequence != sequence ||
+        block->status == PLATFORM_READ_FAILED ||
+        block->status == PLATFORM_READ_IDLE) {
+      if (block->sequence == sequence &&
+          block->status == PLATFORM_READ_FAILED) {
+        ++player->stats.failed_count;
+      }
+
+      uint64_t block_idx = sequence % queue->header.block_count;
+      block->sequence = sequence;
+      block->is_decoded = false;
+      block->status = PLATFORM_READ_PENDING;
+      if (!platform->QueueRead(queue->file,
+                               sizeof(MusicFileHeader) +
+                                   block_idx * MUSIC_BLOCK_SIZE,
+                               MUSIC_BLOCK_SIZE, block->data,
+                               &block->status)) {
+        block->status = PLATFORM_READ_IDLE;
+      }
+    }
+
+    // Reads complete inline when the stream queue is not running.
+    if (block->status == PLATFORM_READ_DONE && !block->is_decoded) {
+      DecodeMusicBlock(block->data, block->samples[0], block->samples[1]);
+      block->is_decoded = true;
+      ++player->stats.decoded_block_count;
+    }
+  }
+}
+
+// Adds the music on top of whatever is already in the sound buffer. Frames
+// whose block is not decoded yet play as silence, but the position still
+// advances so music stays in time with the game.
+void MixMusic(MusicPlayer *player, MusicLoadQueue *queue,
+              GameSoundBuffer *sound_buffer) {
+  if (!queue->file) {
+    player->play_frame += sound_buffer->sample_count;
+    return;
+  }
+
+  float scale = player->volume * (1.0f / 32768.0f);
+  int sample_idx = 0;
+  while (sample_idx < sound_buffer->sample_count) {
+    uint32_t track_frame;
+    uint64_t sequence = GetMusicBlockSequence(
+        &queue->header, player->play_frame + sample_idx, &track_frame);
+    uint32_t block_frame = track_frame % MUSIC_BLOCK_FRAMES;
+
+    // A run ends at its block's end, which for the last block is the loop
+    // point.
+    uint32_t run_end = track_frame - block_frame + MUSIC_BLOCK_FRAMES;
+    if (run_end > queue->header.frame_count) {
+      run_end = queue->header.frame_count;
+    }
+    int run = static_cast<int>(run_end - track_frame);
+    if (run > sound_buffer->sample_count - sample_idx) {
+      run = sound_buffer->sample_count - sample_idx;
+    }
+
+    MusicBlock *block = &queue->blocks[sequence % MUSIC_BLOCK_SLOT_COUNT];
+    if (block->sequence == sequence && block->is_decoded) {
+      int16_t *left = block->samples[0] + block_frame;
+      int16_t *right = block->samples[1] + block_frame;
+      float *left_out = sound_buffer->left_samples + sample_idx;
+      float *right_out = sound_buffer->right_samples + sample_idx;
+      for (int i = 0; i < run; ++i) {
+        left_out[i] += left[i] * scale;
+        right_out[i] += right[i] * scale;
+      }
+    } else {
+      player->stats.underrun_frame_count += run;
+    }
+
+    sample_idx += run;
+  }
+
+  player->play_frame += sound_buffer->sample_count;
+}
@@ -0,0 +1,92 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_MUSIC_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_MUSIC_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const uint32_t MUSIC_FILE_MAGIC = 0x4D484848;  // "HHHM"
+static const uint32_t MUSIC_FILE_VERSION = 1;
+static const char MUSIC_FILE_NAME[] = "music.adpcm";
+static const int MUSIC_CHANNEL_COUNT = 2;
+static const int MUSIC_BLOCK_FRAMES = 1024;
+static const int MUSIC_BLOCK_SLOT_COUNT = 16;
+static const int ADPCM_STEP_INDEX_MAX = 88;
+
+// IMA ADPCM: four bits per sample, with each block restating the decoder
+// state so blocks decode independently of each other.
+struct AdpcmState {
+  int32_t predictor;
+  int32_t step_index;
+};
+
+struct AdpcmBlockHeader {
+  int16_t predictor;
+  uint8_t step_index;
+  uint8_t reserved;
+};
+
+// A block holds one header and MUSIC_BLOCK_FRAMES packed nibbles per
+// channel, low nibble first.
+static const uint32_t MUSIC_CHANNEL_BLOCK_SIZE =
+    sizeof(AdpcmBlockHeader) + MUSIC_BLOCK_FRAMES / 2;
+static const uint32_t MUSIC_BLOCK_SIZE =
+    MUSIC_CHANNEL_COUNT * MUSIC_CHANNEL_BLOCK_SIZE;
+
+// The file is the header followed by block_count blocks. Playback loops
+// every frame_count frames, so only the start of the last block plays.
+struct MusicFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t samples_per_second;
+  uint32_t channel_count;
+  uint32_t block_frames;
+  uint32_t block_size;
+  uint32_t block_count;
+  uint32_t frame_count;
+};
+
+struct MusicBlock {
+  volatile int32_t status;
+  uint64_t sequence;
+  bool is_decoded;
+  uint8_t data[MUSIC_BLOCK_SIZE];
+  int16_t samples[MUSIC_CHANNEL_COUNT][MUSIC_BLOCK_FRAMES];
+};
+
+// Lives in transient storage like the chunk load queue. Slot i holds the
+// block whose sequence number, counted from the start of playback across
+// loops, is i modulo MUSIC_BLOCK_SLOT_COUNT.
+struct MusicLoadQueue {
+  bool is_init;
+  void *file;
+  MusicFileHeader header;
+  MusicBlock blocks[MUSIC_BLOCK_SLOT_COUNT];
+};
+
+struct MusicStats {
+  int64_t decoded_block_count;
+  int64_t underrun_frame_count;
+  int64_t failed_count;
+};
+
+// play_frame counts frames since playback started; the position in the
+// track is play_frame modulo the file's frame_count.
+struct MusicPlayer {
+  uint64_t play_frame;
+  float volume;
+  MusicStats stats;
+};
+
+uint32_t GetMusicFileSize(uint32_t frame_count);
+uint32_t EncodeMusic(int16_t *samples, uint32_t frame_count,
+                     uint32_t channel_count, uint32_t samples_per_second,
+                     uint8_t *dest, uint32_t dest_size);
+void DecodeMusicBlock(uint8_t *data, int16_t *left, int16_t *right);
+void UpdateMusicStream(MusicPlayer *player, MusicLoadQueue *queue,
+                       PlatformApi *platform, const char *file_name,
+                       int samples_per_second);
+void MixMusic(MusicPlayer *player, MusicLoadQueue *queue,
+              GameSoundBuffer *sound_buffer);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_MUSIC_H_
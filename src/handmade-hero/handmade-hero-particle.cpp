@@ -0,0 +1,249 @@
+#include "../../src/handmade-hero/handmade-hero-particle.h"
+
+#include <emmintrin.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+void InitParticleSystem(ParticleSystem *system, MemoryArena *arena,
+                        uint32_t capacity) {
+  capacity = (capacity + 3) & ~3u;
+
+  system->capacity = capacity;
+  system->count = 0;
+  system->pos_x = PushArray(arena, capacity, float);
+  system->pos_y = PushArray(arena, capacity, float);
+  system->vel_x = PushArray(arena, capacity, float);
+  system->vel_y = PushArray(arena, capacity, float);
+  system->color_r = PushArray(arena, capacity, float);
+  system->color_g = PushArray(arena, capacity, float);
+  system->color_b = PushArray(arena, capacity, float);
+  system->life = PushArray(arena, capacity, float);
+  system->inv_lifetime = PushArray(arena, capacity, float);
+}
+
+void EmitParticles(ParticleSystem *system, ParticleEmitter *emitter, float dt,
+                   uint32_t *random_state) {
+  emitter->spawn_accumulator += emitter->spawn_rate * dt;
+  uint32_t spawn_count = static_cast<uint32_t>(emitter->spawn_accumulator);
+  emitter->spawn_accumulator -= static_cast<float>(spawn_count);
+
+  uint32_t free_count = system->capacity - system->count;
+  if (spawn_count > free_count) {
+    spawn_count = free_count;
+  }
+
+  // Emitter colors are sRGB like the rest of the art, truncated to bytes
+  // the same way as their markers. Particles carry them as linear.
+  float color_r =
+      SRGBToLinear(static_cast<uint32_t>(emitter->color_r * 255.0f));
+  float color_g =
+      SRGBToLinear(static_cast<uint32_t>(emitter->color_g * 255.0f));
+  float color_b =
+      SRGBToLinear(static_cast<uint32_t>(emitter->color_b * 255.0f));
+
+  for (uint32_t i = 0; i < spawn_count; ++i) {
+    uint32_t idx = system->count++;
+    float spread = RandomBilateral(random_state);
+    float lift = 0.5f + 0.5f * RandomUnilateral(random_state);
+    float lifetime =
+        emitter->lifetime * (0.75f + 0.5f * RandomUnilateral(random_state));
+
+    system->pos_x[idx] = emitter->pos_x;
+    system->pos_y[idx] = emitter->pos_y;
+    system->vel_x[idx] = emitter->speed * 0.5f * spread;
+    system->vel_y[idx] = -emitter->speed * lift;
+    system->color_r[idx] = color_r;
+    system->color_g[idx] = color_g;
+    system->color_b[idx] = color_b;
+    system->life[idx] = lifetime;
+    system->inv_lifetime[idx] = 1.0f / lifetime;
+  }
+}
+
+void UpdateParticles(ParticleSystem *system, float dt, float gravity) {
+  __m128 dt_wide = _mm_set1_ps(dt);
+  __m128 gravity_dt = _mm_set1_ps(gravity * dt);
+  __m128 zero = _mm_setzero_ps();
+
+  uint32_t count = system->count;
+  uint32_t write_idx = 0;
+  for (uint32_t i = 0; i < count; i += 4) {
+    __m128 vel_x = _mm_loadu_ps(system->vel_x + i);
+    __m128 vel_y = _mm_add_ps(_mm_loadu_ps(system->vel_y + i), gravity_dt);
+    __m128 pos_x = _mm_add_ps(_mm_loadu_ps(system->pos_x + i),
+                              _mm_mul_ps(vel_x, dt_wide));
+    __m128 pos_y = _mm_add_ps(_mm_loadu_ps(system->pos_y + i),
+                              _mm_mul_ps(vel_y, dt_wide));
+    __m128 life = _mm_sub_ps(_mm_loadu_ps(system->life + i), dt_wide);
+
+    uint32_t alive_mask =
+        static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpgt_ps(life, zero)));
+    if (count - i < 4) {
+      alive_mask &= (1u << (count - i)) - 1;
+    }
+
+    // Whole blocks of live particles slide down as vectors.
+    if (alive_mask == 0xF) {
+      _mm_storeu_ps(system->pos_x + write_idx, pos_x);
+      _mm_storeu_ps(system->pos_y + write_idx, pos_y);
+      _mm_storeu_ps(system->vel_x + write_idx, vel_x);
+      _mm_storeu_ps(system->vel_y + write_idx, vel_y);
+      _mm_storeu_ps(system->life + write_idx, life);
+      if (write_idx != i) {
+        _mm_storeu_ps(system->color_r + write_idx,
+                      _mm_loadu_ps(system->color_r + i));
+        _mm_storeu_ps(system->color_g + write_idx,
+                      _mm_loadu_ps(system->color_g + i));
+        _mm_storeu_ps(system->color_b + write_idx,
+                      _mm_loadu_ps(system->color_b + i));
+        _mm_storeu_ps(system->inv_lifetime + write_idx,
+                      _mm_loadu_ps(system->inv_lifetime + i));
+      }
+      write_idx += 4;
+      continue;
+    }
+
+    float lane_pos_x[4];
+    float lane_pos_y[4];
+    float lane_vel_x[4];
+    float lane_vel_y[4];
+    float lane_life[4];
+    _mm_storeu_ps(lane_pos_x, pos_x);
+    _mm_storeu_ps(lane_pos_y, pos_y);
+    _mm_storeu_ps(lane_vel_x, vel_x);
+    _mm_storeu_ps(lane_vel_y, vel_y);
+    _mm_storeu_ps(lane_life, life);
+
+    // Within a mixed block every lane is written at the compacted position
+    // and the cursor only advances past live ones, so dead particles cost no
+    // branch. The cursor never passes the read position, which makes this
+    // safe in place.
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+      uint32_t read_idx = i + lane;
+      system->pos_x[write_idx] = lane_pos_x[lane];
+      system->pos_y[write_idx] = lane_pos_y[lane];
+      system->vel_x[write_idx] = lane_vel_x[lane];
+      system->vel_y[write_idx] = lane_vel_y[lane];
+      system->life[write_idx] = lane_life[lane];
+      system->color_r[write_idx] = system->color_r[read_idx];
+      system->color_g[write_idx] = system->color_g[read_idx];
+      system->color_b[write_idx] = system->color_b[read_idx];
+      system->inv_lifetime[write_idx] = system->inv_lifetime[read_idx];
+      write_idx += (alive_mask >> lane) & 1;
+    }
+  }
+
+  system->count = write_idx;
+}
+
+void DrawParticles(GameBuffer *buffer, ParticleSystem *system, int camera_x,
+                   int camera_y, float pixels_per_unit,
+                   BlendSpace blend_space) {
+  Assert(buffer->format == PIXEL_FORMAT_BGRA8);
+
+  __m128 scale = _mm_set1_ps(pixels_per_unit);
+  __m128 offset_x = _mm_set1_ps(static_cast<float>(camera_x));
+  __m128 offset_y = _mm_set1_ps(static_cast<float>(camera_y));
+  __m128 width = _mm_set1_ps(static_cast<float>(buffer->width));
+  __m128 height = _mm_set1_ps(static_cast<float>(buffer->height));
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128i alpha_one = _mm_set1_epi32(256);
+  __m128i zero_int = _mm_setzero_si128();
+  __m128i opaque = _mm_slli_epi32(_mm_set1_epi32(0xFF), 24);
+
+  uint8_t *memory = reinterpret_cast<uint8_t *>(buffer->memory);
+  for (uint32_t i = 0; i < system->count; i += 4) {
+    __m128 screen_x = _mm_sub_ps(
+        _mm_mul_ps(_mm_loadu_ps(system->pos_x + i), scale), offset_x);
+    __m128 screen_y = _mm_sub_ps(
+        _mm_mul_ps(_mm_loadu_ps(system->pos_y + i), scale), offset_y);
+    __m128 alpha = _mm_mul_ps(_mm_loadu_ps(system->life + i),
+                              _mm_loadu_ps(system->inv_lifetime + i));
+    alpha = _mm_min_ps(_mm_max_ps(alpha, zero), one);
+
+    __m128 visible = _mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(screen_x, zero), _mm_cmplt_ps(screen_x, width)),
+        _mm_and_ps(_mm_cmpge_ps(screen_y, zero),
+                   _mm_cmplt_ps(screen_y, height)));
+    uint32_t visible_mask = static_cast<uint32_t>(_mm_movemask_ps(visible));
+    if (system->count - i < 4) {
+      visible_mask &= (1u << (system->count - i)) - 1;
+    }
+    if (!visible_mask) {
+      continue;
+    }
+
+    int32_t pixel_x[4];
+    int32_t pixel_y[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pixel_x),
+                     _mm_cvttps_epi32(screen_x));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pixel_y),
+                     _mm_cvttps_epi32(screen_y));
+
+    uint32_t *pixels[4] = {};
+    uint32_t dest_values[4] = {};
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+      if (visible_mask & (1u << lane)) {
+        pixels[lane] = reinterpret_cast<uint32_t *>(
+            memory + pixel_y[lane] * buffer->pitch +
+            pixel_x[lane] * buffer->bytes_per_pixel);
+        dest_values[lane] = *pixels[lane];
+      }
+    }
+
+    __m128 color_r = _mm_loadu_ps(system->color_r + i);
+    __m128 color_g = _mm_loadu_ps(system->color_g + i);
+    __m128 color_b = _mm_loadu_ps(system->color_b + i);
+    __m128i dest = _mm_loadu_si128(reinterpret_cast<__m128i *>(dest_values));
+
+    uint32_t blended[4];
+    if (blend_space == BLEND_SPACE_LINEAR) {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(blended),
+          BlendPixelsLinear4(dest, color_r, color_g, color_b, alpha));
+    } else {
+      // Premultiplied source as packed BGRA, from the sRGB bytes of the
+      // linear particle colors.
+      __m128i red = _mm_cvtps_epi32(
+          _mm_mul_ps(_mm_cvtepi32_ps(LinearToSRGB4(color_r)), alpha));
+      __m128i green = _mm_cvtps_epi32(
+          _mm_mul_ps(_mm_cvtepi32_ps(LinearToSRGB4(color_g)), alpha));
+      __m128i blue = _mm_cvtps_epi32(
+          _mm_mul_ps(_mm_cvtepi32_ps(LinearToSRGB4(color_b)), alpha));
+      __m128i source =
+          _mm_or_si128(_mm_slli_epi32(red, 16),
+                       _mm_or_si128(_mm_slli_epi32(green, 8), blue));
+      __m128i inv_alpha = _mm_sub_epi32(
+          alpha_one, _mm_cvtps_epi32(_mm_mul_ps(alpha, _mm_set1_ps(256.0f))));
+
+      // dest = source + dest * (256 - alpha) / 256 on 16-bit channels, with
+      // each pixel's inverse alpha broadcast across its four channels.
+      __m128i inv_alpha_16 = _mm_packs_epi32(inv_alpha, inv_alpha);
+      inv_alpha_16 = _mm_unpacklo_epi16(inv_alpha_16, inv_alpha_16);
+      __m128i inv_alpha_lo = _mm_unpacklo_epi32(inv_alpha_16, inv_alpha_16);
+      __m128i inv_alpha_hi = _mm_unpackhi_epi32(inv_alpha_16, inv_alpha_16);
+
+      __m128i dest_lo = _mm_srli_epi16(
+          _mm_mullo_epi16(_mm_unpacklo_epi8(dest, zero_int), inv_alpha_lo), 8);
+      __m128i dest_hi = _mm_srli_epi16(
+          _mm_mullo_epi16(_mm_unpackhi_epi8(dest, zero_int), inv_alpha_hi), 8);
+      __m128i blended_lo =
+          _mm_add_epi16(dest_lo, _mm_unpacklo_epi8(source, zero_int));
+      __m128i blended_hi =
+          _mm_add_epi16(dest_hi, _mm_unpackhi_epi8(source, zero_int));
+
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(blended),
+          _mm_or_si128(_mm_packus_epi16(blended_lo, blended_hi), opaque));
+    }
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+      if (visible_mask & (1u << lane)) {
+        *pixels[lane] = blended[lane];
+      }
+    }
+  }
+}
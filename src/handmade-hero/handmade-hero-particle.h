@@ -0,0 +1,49 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_PARTICLE_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_PARTICLE_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const uint32_t PARTICLE_CAPACITY = 65536;
+
+// Fixed-capacity SoA pool. Live particles are always packed at the front.
+// Colors are linear.
+struct ParticleSystem {
+  uint32_t capacity;
+  uint32_t count;
+  float *pos_x;
+  float *pos_y;
+  float *vel_x;
+  float *vel_y;
+  float *color_r;
+  float *color_g;
+  float *color_b;
+  float *life;
+  float *inv_lifetime;
+};
+
+struct ParticleEmitter {
+  float pos_x;
+  float pos_y;
+  float spawn_rate;
+  float spawn_accumulator;
+  float speed;
+  float lifetime;
+  // sRGB, like the marker tint.
+  float color_r;
+  float color_g;
+  float color_b;
+};
+
+void InitParticleSystem(ParticleSystem *system, MemoryArena *arena,
+                        uint32_t capacity);
+void EmitParticles(ParticleSystem *system, ParticleEmitter *emitter, float dt,
+                   uint32_t *random_state);
+void UpdateParticles(ParticleSystem *system, float dt, float gravity);
+void DrawParticles(GameBuffer *buffer, ParticleSystem *system, int camera_x,
+                   int camera_y, float pixels_per_unit,
+                   BlendSpace blend_space);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_PARTICLE_H_
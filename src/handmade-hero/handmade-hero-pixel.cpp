@@ -0,0 +1,417 @@
+#include "../../src/handmade-hero/handmade-hero-pixel.h"
+
+#include <emmintrin.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+// Per-format traits. Weights passed to Blend are 0..256.
+static inline uint32_t LerpPacked(uint32_t dest, uint32_t color,
+                                  uint32_t weight) {
+  uint32_t result = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    uint32_t dest_channel = (dest >> shift) & 0xFF;
+    uint32_t color_channel = (color >> shift) & 0xFF;
+    uint32_t channel =
+        (dest_channel * (256 - weight) + color_channel * weight) >> 8;
+    result |= channel << shift;
+  }
+  return result;
+}
+
+struct FormatBGRA8 {
+  typedef uint32_t Pixel;
+
+  static inline Pixel Encode(uint32_t color) { return color; }
+
+  static inline uint32_t Decode(Pixel pixel) { return pixel; }
+
+  static inline Pixel Blend(Pixel dest, uint32_t color, uint32_t weight) {
+    Pixel result = LerpPacked(dest, color, weight);
+    return result;
+  }
+};
+
+struct FormatRGB565 {
+  typedef uint16_t Pixel;
+
+  static inline Pixel Encode(uint32_t color) {
+    Pixel result = static_cast<Pixel>(((color >> 8) & 0xF800) |
+                                      ((color >> 5) & 0x07E0) |
+                                      ((color >> 3) & 0x001F));
+    return result;
+  }
+
+  // Replicates the high bits into the low ones so 0x1F decodes to 0xFF.
+  static inline uint32_t Decode(Pixel pixel) {
+    uint32_t red = (pixel >> 11) & 0x1F;
+    uint32_t green = (pixel >> 5) & 0x3F;
+    uint32_t blue = pixel & 0x1F;
+    red = (red << 3) | (red >> 2);
+    green = (green << 2) | (green >> 4);
+    blue = (blue << 3) | (blue >> 2);
+    uint32_t result = 0xFF000000 | (red << 16) | (green << 8) | blue;
+    return result;
+  }
+
+  static inline Pixel Blend(Pixel dest, uint32_t color, uint32_t weight) {
+    Pixel result = Encode(LerpPacked(Decode(dest), color, weight));
+    return result;
+  }
+};
+
+// Masks keep only alpha and decode as white so they composite as coverage.
+struct FormatMask8 {
+  typedef uint8_t Pixel;
+
+  static inline Pixel Encode(uint32_t color) {
+    Pixel result = static_cast<Pixel>(color >> 24);
+    return result;
+  }
+
+  static inline uint32_t Decode(Pixel pixel) {
+    uint32_t result = (static_cast<uint32_t>(pixel) << 24) | 0x00FFFFFF;
+    return result;
+  }
+
+  static inline Pixel Blend(Pixel dest, uint32_t color, uint32_t weight) {
+    Pixel result =
+        static_cast<Pixel>((dest * (256 - weight) + (color >> 24) * weight) >>
+                           8);
+    return result;
+  }
+};
+
+// HDR channels are unbounded floats where 1.0 is display white. Decoding
+// clamps.
+struct FormatHDR {
+  typedef HDRPixel Pixel;
+
+  static inline Pixel Encode(uint32_t color) {
+    float scale = 1.0f / 255.0f;
+    Pixel result = {};
+    result.red = ((color >> 16) & 0xFF) * scale;
+    result.green = ((color >> 8) & 0xFF) * scale;
+    result.blue = (color & 0xFF) * scale;
+    result.alpha = (color >> 24) * scale;
+    return result;
+  }
+
+  static inline uint32_t EncodeChannel(float value) {
+    if (value < 0.0f) {
+      value = 0.0f;
+    }
+    if (value > 1.0f) {
+      value = 1.0f;
+    }
+    uint32_t result = static_cast<uint32_t>(value * 255.0f + 0.5f);
+    return result;
+  }
+
+  static inline uint32_t Decode(Pixel pixel) {
+    uint32_t result =
+        (EncodeChannel(pixel.alpha) << 24) | (EncodeChannel(pixel.red) << 16) |
+        (EncodeChannel(pixel.green) << 8) | EncodeChannel(pixel.blue);
+    return result;
+  }
+
+  static inline Pixel Blend(Pixel dest, uint32_t color, uint32_t weight) {
+    Pixel source = Encode(color);
+    float t = weight * (1.0f / 256.0f);
+    Pixel result = {};
+    result.red = dest.red + (source.red - dest.red) * t;
+    result.green = dest.green + (source.green - dest.green) * t;
+    result.blue = dest.blue + (source.blue - dest.blue) * t;
+    result.alpha = dest.alpha + (source.alpha - dest.alpha) * t;
+    return result;
+  }
+};
+
+template <typename Format>
+static inline typename Format::Pixel *GetRow(GameBuffer *buffer, int y) {
+  typename Format::Pixel *result = reinterpret_cast<typename Format::Pixel *>(
+      reinterpret_cast<uint8_t *>(buffer->memory) + y * buffer->pitch);
+  return result;
+}
+
+template <typename Format>
+static void FillRectangleFormat(GameBuffer *buffer, int min_x, int min_y,
+                                int max_x, int max_y, uint32_t color) {
+  typename Format::Pixel value = Format::Encode(color);
+  for (int y = min_y; y < max_y; ++y) {
+    typename Format::Pixel *row = GetRow<Format>(buffer, y);
+    for (int x = min_x; x < max_x; ++x) {
+      row[x] = value;
+    }
+  }
+}
+
+template <typename Format>
+static void BlendMaskRow(typename Format::Pixel *dest, uint8_t *coverage,
+                         int count, uint32_t color) {
+  for (int i = 0; i < count; ++i) {
+    uint32_t weight = coverage[i];
+    if (weight) {
+      weight += weight >> 7;
+      dest[i] = Format::Blend(dest[i], color, weight);
+    }
+  }
+}
+
+// 32-bit targets already have a SIMD coverage blend.
+template <>
+void BlendMaskRow<FormatBGRA8>(uint32_t *dest, uint8_t *coverage, int count,
+                               uint32_t color) {
+  BlendCoverageSpan(dest, coverage, count, color, BLEND_SPACE_GAMMA);
+}
+
+template <typename Format>
+static void BlendMaskFormat(GameBuffer *dest, GameBuffer *mask, int min_x,
+                            int min_y, int max_x, int max_y, int x, int y,
+                            uint32_t color) {
+  for (int row_y = min_y; row_y < max_y; ++row_y) {
+    uint8_t *coverage = GetRow<FormatMask8>(mask, row_y - y) + (min_x - x);
+    BlendMaskRow<Format>(GetRow<Format>(dest, row_y) + min_x, coverage,
+                         max_x - min_x, color);
+  }
+}
+
+template <typename Source, typename Dest>
+static void ConvertRow(typename Source::Pixel *source,
+                       typename Dest::Pixel *dest, int count) {
+  for (int i = 0; i < count; ++i) {
+    dest[i] = Dest::Encode(Source::Decode(source[i]));
+  }
+}
+
+// Resolving HDR to the display format is the common case, so it clamps and
+// packs four pixels at a time.
+template <>
+void ConvertRow<FormatHDR, FormatBGRA8>(HDRPixel *source, uint32_t *dest,
+                                       int count) {
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 scale = _mm_set1_ps(255.0f);
+  __m128 half = _mm_set1_ps(0.5f);
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i channels[4];
+    for (int lane = 0; lane < 4; ++lane) {
+      // RGBA in memory, BGRA out.
+      __m128 value = _mm_loadu_ps(&source[i + lane].red);
+      value = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 0, 1, 2));
+      value = _mm_min_ps(_mm_max_ps(value, zero), one);
+      channels[lane] =
+          _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+    }
+    __m128i pixels_lo = _mm_packs_epi32(channels[0], channels[1]);
+    __m128i pixels_hi = _mm_packs_epi32(channels[2], channels[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i),
+                     _mm_packus_epi16(pixels_lo, pixels_hi));
+  }
+  for (; i < count; ++i) {
+    dest[i] = FormatHDR::Decode(source[i]);
+  }
+}
+
+template <typename Source, typename Dest>
+static void ConvertBufferFormat(GameBuffer *source, GameBuffer *dest) {
+  for (int y = 0; y < source->height; ++y) {
+    ConvertRow<Source, Dest>(GetRow<Source>(source, y), GetRow<Dest>(dest, y),
+                             source->width);
+  }
+}
+
+template <typename Source>
+static void ConvertBufferFrom(GameBuffer *source, GameBuffer *dest) {
+  switch (dest->format) {
+    case PIXEL_FORMAT_BGRA8:
+      ConvertBufferFormat<Source, FormatBGRA8>(source, dest);
+      break;
+    case PIXEL_FORMAT_RGB565:
+      ConvertBufferFormat<Source, FormatRGB565>(source, dest);
+      break;
+    case PIXEL_FORMAT_MASK8:
+      ConvertBufferFormat<Source, FormatMask8>(source, dest);
+      break;
+    case PIXEL_FORMAT_HDR:
+      ConvertBufferFormat<Source, FormatHDR>(source, dest);
+      break;
+    default:
+      Assert(!"Unknown pixel format");
+  }
+}
+
+int GetBytesPerPixel(PixelFormat format) {
+  int result = 0;
+  switch (format) {
+    case PIXEL_FORMAT_BGRA8:
+      result = sizeof(FormatBGRA8::Pixel);
+      break;
+    case PIXEL_FORMAT_RGB565:
+      result = sizeof(FormatRGB565::Pixel);
+      break;
+    case PIXEL_FORMAT_MASK8:
+      result = sizeof(FormatMask8::Pixel);
+      break;
+    case PIXEL_FORMAT_HDR:
+      result = sizeof(FormatHDR::Pixel);
+      break;
+    default:
+      Assert(!"Unknown pixel format");
+  }
+  return result;
+}
+
+GameBuffer MakeGameBuffer(void *memory, int width, int height,
+                          PixelFormat format) {
+  GameBuffer result = {};
+  result.memory = memory;
+  result.width = width;
+  result.height = height;
+  result.bytes_per_pixel = GetBytesPerPixel(format);
+  result.pitch = width * result.bytes_per_pixel;
+  result.format = format;
+  return result;
+}
+
+uint32_t GetPixel(GameBuffer *buffer, int x, int y) {
+  Assert(x >= 0 && x < buffer->width && y >= 0 && y < buffer->height);
+
+  uint32_t result = 0;
+  switch (buffer->format) {
+    case PIXEL_FORMAT_BGRA8:
+      result = FormatBGRA8::Decode(GetRow<FormatBGRA8>(buffer, y)[x]);
+      break;
+    case PIXEL_FORMAT_RGB565:
+      result = FormatRGB565::Decode(GetRow<FormatRGB565>(buffer, y)[x]);
+      break;
+    case PIXEL_FORMAT_MASK8:
+      result = FormatMask8::Decode(GetRow<FormatMask8>(buffer, y)[x]);
+      break;
+    case PIXEL_FORMAT_HDR:
+      result = FormatHDR::Decode(GetRow<FormatHDR>(buffer, y)[x]);
+      break;
+    default:
+      Assert(!"Unknown pixel format");
+  }
+  return result;
+}
+
+void ClearBuffer(GameBuffer *buffer, uint32_t color) {
+  FillRectangle(buffer, 0, 0, buffer->width, buffer->height, color);
+}
+
+void FillRectangle(GameBuffer *buffer, int min_x, int min_y, int max_x,
+                   int max_y, uint32_t color) {
+  if (min_x < 0) {
+    min_x = 0;
+  }
+  if (min_y < 0) {
+    min_y = 0;
+  }
+  if (max_x > buffer->width) {
+    max_x = buffer->width;
+  }
+  if (max_y > buffer->height) {
+    max_y = buffer->height;
+  }
+
+  switch (buffer->format) {
+    case PIXEL_FORMAT_BGRA8:
+      FillRectangleFormat<FormatBGRA8>(buffer, min_x, min_y, max_x, max_y,
+                                       color);
+      break;
+    case PIXEL_FORMAT_RGB565:
+      FillRectangleFormat<FormatRGB565>(buffer, min_x, min_y, max_x, max_y,
+                                        color);
+      break;
+    case PIXEL_FORMAT_MASK8:
+      FillRectangleFormat<FormatMask8>(buffer, min_x, min_y, max_x, max_y,
+                                       color);
+      break;
+    case PIXEL_FORMAT_HDR:
+      FillRectangleFormat<FormatHDR>(buffer, min_x, min_y, max_x, max_y,
+                                     color);
+      break;
+    default:
+      Assert(!"Unknown pixel format");
+  }
+}
+
+// Composites an 8-bit mask with its top left corner at (x, y) in dest.
+void BlendMask(GameBuffer *dest, GameBuffer *mask, int x, int y,
+               uint32_t color) {
+  Assert(mask->format == PIXEL_FORMAT_MASK8);
+
+  int min_x = x < 0 ? 0 : x;
+  int min_y = y < 0 ? 0 : y;
+  int max_x = x + mask->width;
+  int max_y = y + mask->height;
+  if (max_x > dest->width) {
+    max_x = dest->width;
+  }
+  if (max_y > dest->height) {
+    max_y = dest->height;
+  }
+  if (min_x >= max_x || min_y >= max_y) {
+    return;
+  }
+
+  switch (dest->format) {
+    case PIXEL_FORMAT_BGRA8:
+      BlendMaskFormat<FormatBGRA8>(dest, mask, min_x, min_y, max_x, max_y, x,
+                                   y, color);
+      break;
+    case PIXEL_FORMAT_RGB565:
+      BlendMaskFormat<FormatRGB565>(dest, mask, min_x, min_y, max_x, max_y, x,
+                                    y, color);
+      break;
+    case PIXEL_FORMAT_MASK8:
+      BlendMaskFormat<FormatMask8>(dest, mask, min_x, min_y, max_x, max_y, x,
+                                   y, color);
+      break;
+    case PIXEL_FORMAT_HDR:
+      BlendMaskFormat<FormatHDR>(dest, mask, min_x, min_y, max_x, max_y, x, y,
+                                 color);
+      break;
+    default:
+      Assert(!"Unknown pixel format");
+  }
+}
+
+void ConvertBuffer(GameBuffer *source, GameBuffer *dest) {
+  Assert(source->width == dest->width && source->height == dest->height);
+
+  if (source->format == dest->format) {
+    size_t row_size =
+        static_cast<size_t>(source->width) * source->bytes_per_pixel;
+    for (int y = 0; y < source->height; ++y) {
+      memcpy(reinterpret_cast<uint8_t *>(dest->memory) + y * dest->pitch,
+             reinterpret_cast<uint8_t *>(source->memory) + y * source->pitch,
+             row_size);
+    }
+    return;
+  }
+
+  switch (source->format) {
+    case PIXEL_FORMAT_BGRA8:
+      ConvertBufferFrom<FormatBGRA8>(source, dest);
+      break;
+    case PIXEL_FORMAT_RGB565:
+      ConvertBufferFrom<FormatRGB565>(source, dest);
+      break;
+    case PIXEL_FORMAT_MASK8:
+      ConvertBufferFrom<FormatMask8>(source, dest);
+      break;
+    case PIXEL_FORMAT_HDR:
+      ConvertBufferFrom<FormatHDR>(source, dest);
+      break;
+    default:
+      Assert(!"Unknown pixel format");
+  }
+}
@@ -0,0 +1,30 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_PIXEL_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_PIXEL_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+// Colors passed in and out of these routines are always packed 0xAARRGGBB.
+// Each routine switches on the buffer's format once and then runs a loop
+// specialized for it.
+struct HDRPixel {
+  float red;
+  float green;
+  float blue;
+  float alpha;
+};
+
+int GetBytesPerPixel(PixelFormat format);
+GameBuffer MakeGameBuffer(void *memory, int width, int height,
+                          PixelFormat format);
+uint32_t GetPixel(GameBuffer *buffer, int x, int y);
+
+void ClearBuffer(GameBuffer *buffer, uint32_t color);
+void FillRectangle(GameBuffer *buffer, int min_x, int min_y, int max_x,
+                   int max_y, uint32_t color);
+void BlendMask(GameBuffer *dest, GameBuffer *mask, int x, int y,
+               uint32_t color);
+void ConvertBuffer(GameBuffer *source, GameBuffer *dest);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_PIXEL_H_
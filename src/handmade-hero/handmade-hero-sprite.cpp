@@ -0,0 +1,383 @@
+#include "../../src/handmade-hero/handmade-hero-sprite.h"
+
+#include <emmintrin.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+struct SpriteBounds {
+  int min_x;
+  int min_y;
+  int max_x;
+  int max_y;
+};
+
+// Axes scaled by their inverse squared length, so a dot product with a pixel
+// offset from the origin gives u or v directly.
+struct SpriteMapping {
+  float u_x;
+  float u_y;
+  float v_x;
+  float v_y;
+};
+
+static inline float Min4(float a, float b, float c, float d) {
+  float result = fminf(fminf(a, b), fminf(c, d));
+  return result;
+}
+
+static inline float Max4(float a, float b, float c, float d) {
+  float result = fmaxf(fmaxf(a, b), fmaxf(c, d));
+  return result;
+}
+
+static bool GetSpriteBounds(GameBuffer *dest, GameBuffer *texture,
+                            SpriteBasis *basis, int clip_min_x, int clip_min_y,
+                            int clip_max_x, int clip_max_y,
+                            SpriteBounds *bounds, SpriteMapping *mapping) {
+  Assert(dest->format == PIXEL_FORMAT_BGRA8);
+  Assert(texture->format == PIXEL_FORMAT_BGRA8);
+
+  float x_length_sq =
+      basis->x_axis_x * basis->x_axis_x + basis->x_axis_y * basis->x_axis_y;
+  float y_length_sq =
+      basis->y_axis_x * basis->y_axis_x + basis->y_axis_y * basis->y_axis_y;
+  if (x_length_sq <= 0.0f || y_length_sq <= 0.0f || texture->width < 2 ||
+      texture->height < 2) {
+    return false;
+  }
+  mapping->u_x = basis->x_axis_x / x_length_sq;
+  mapping->u_y = basis->x_axis_y / x_length_sq;
+  mapping->v_x = basis->y_axis_x / y_length_sq;
+  mapping->v_y = basis->y_axis_y / y_length_sq;
+
+  float x0 = basis->origin_x;
+  float y0 = basis->origin_y;
+  float x1 = x0 + basis->x_axis_x;
+  float y1 = y0 + basis->x_axis_y;
+  float x2 = x0 + basis->y_axis_x;
+  float y2 = y0 + basis->y_axis_y;
+  float x3 = x1 + basis->y_axis_x;
+  float y3 = y1 + basis->y_axis_y;
+
+  bounds->min_x = static_cast<int>(floorf(Min4(x0, x1, x2, x3)));
+  bounds->min_y = static_cast<int>(floorf(Min4(y0, y1, y2, y3)));
+  bounds->max_x = static_cast<int>(ceilf(Max4(x0, x1, x2, x3)));
+  bounds->max_y = static_cast<int>(ceilf(Max4(y0, y1, y2, y3)));
+
+  if (clip_min_x < 0) {
+    clip_min_x = 0;
+  }
+  if (clip_min_y < 0) {
+    clip_min_y = 0;
+  }
+  if (clip_max_x > dest->width) {
+    clip_max_x = dest->width;
+  }
+  if (clip_max_y > dest->height) {
+    clip_max_y = dest->height;
+  }
+  if (bounds->min_x < clip_min_x) {
+    bounds->min_x = clip_min_x;
+  }
+  if (bounds->min_y < clip_min_y) {
+    bounds->min_y = clip_min_y;
+  }
+  if (bounds->max_x > clip_max_x) {
+    bounds->max_x = clip_max_x;
+  }
+  if (bounds->max_y > clip_max_y) {
+    bounds->max_y = clip_max_y;
+  }
+
+  bool result = bounds->min_x < bounds->max_x && bounds->min_y < bounds->max_y;
+  return result;
+}
+
+static inline uint32_t *GetTexel(GameBuffer *texture, int x, int y) {
+  uint32_t *result = reinterpret_cast<uint32_t *>(
+      reinterpret_cast<uint8_t *>(texture->memory) + y * texture->pitch +
+      x * sizeof(uint32_t));
+  return result;
+}
+
+static inline float GetChannel(uint32_t pixel, int shift) {
+  float result = static_cast<float>((pixel >> shift) & 0xFF);
+  return result;
+}
+
+static inline float SampleChannel(uint32_t *texel_row, uint32_t *next_row,
+                                  int shift, float fx, float fy) {
+  float top_left = GetChannel(texel_row[0], shift);
+  float top_right = GetChannel(texel_row[1], shift);
+  float bottom_left = GetChannel(next_row[0], shift);
+  float bottom_right = GetChannel(next_row[1], shift);
+  float top = top_left + (top_right - top_left) * fx;
+  float bottom = bottom_left + (bottom_right - bottom_left) * fx;
+  float result = top + (bottom - top) * fy;
+  return result;
+}
+
+// Scalar version of DrawSprite, kept as the reference its output is checked
+// and benchmarked against.
+void DrawSpriteReference(GameBuffer *dest, GameBuffer *texture,
+                         SpriteBasis *basis, uint32_t color, int clip_min_x,
+                         int clip_min_y, int clip_max_x, int clip_max_y) {
+  SpriteBounds bounds = {};
+  SpriteMapping mapping = {};
+  if (!GetSpriteBounds(dest, texture, basis, clip_min_x, clip_min_y,
+                       clip_max_x, clip_max_y, &bounds, &mapping)) {
+    return;
+  }
+
+  float tint[4];
+  for (int channel = 0; channel < 4; ++channel) {
+    tint[channel] = GetChannel(color, channel * 8) * (1.0f / 255.0f);
+  }
+  float max_texel_x = static_cast<float>(texture->width - 1);
+  float max_texel_y = static_cast<float>(texture->height - 1);
+
+  for (int y = bounds.min_y; y < bounds.max_y; ++y) {
+    uint32_t *row = reinterpret_cast<uint32_t *>(
+        reinterpret_cast<uint8_t *>(dest->memory) + y * dest->pitch);
+    float offset_y = y + 0.5f - basis->origin_y;
+    for (int x = bounds.min_x; x < bounds.max_x; ++x) {
+      float offset_x = x + 0.5f - basis->origin_x;
+      float u = offset_x * mapping.u_x + offset_y * mapping.u_y;
+      float v = offset_x * mapping.v_x + offset_y * mapping.v_y;
+      if (u < 0.0f || u > 1.0f || v < 0.0f || v > 1.0f) {
+        continue;
+      }
+
+      // Texel centers sit at integer coordinates.
+      float texel_x = fminf(fmaxf(u * texture->width - 0.5f, 0.0f),
+                            max_texel_x);
+      float texel_y = fminf(fmaxf(v * texture->height - 0.5f, 0.0f),
+                            max_texel_y);
+      int ix = static_cast<int>(fminf(texel_x, max_texel_x - 1.0f));
+      int iy = static_cast<int>(fminf(texel_y, max_texel_y - 1.0f));
+      float fx = texel_x - ix;
+      float fy = texel_y - iy;
+      uint32_t *texel_row = GetTexel(texture, ix, iy);
+      uint32_t *next_row = GetTexel(texture, ix, iy + 1);
+
+      float texel[4];
+      for (int channel = 0; channel < 4; ++channel) {
+        texel[channel] =
+            SampleChannel(texel_row, next_row, channel * 8, fx, fy) *
+            tint[channel];
+      }
+
+      float inv_alpha = 1.0f - texel[3] * (1.0f / 255.0f);
+      uint32_t result = 0;
+      for (int channel = 0; channel < 4; ++channel) {
+        int shift = channel * 8;
+        float value = texel[channel] + GetChannel(row[x], shift) * inv_alpha;
+        result |= static_cast<uint32_t>(fminf(value, 255.0f) + 0.5f) << shift;
+      }
+      row[x] = result;
+    }
+  }
+}
+
+static inline __m128 UnpackChannel(__m128i pixels, int shift) {
+  __m128 result = _mm_cvtepi32_ps(
+      _mm_and_si128(_mm_srli_epi32(pixels, shift), _mm_set1_epi32(0xFF)));
+  return result;
+}
+
+static inline __m128 Lerp(__m128 a, __m128 b, __m128 t) {
+  __m128 result = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+  return result;
+}
+
+// Shades four horizontally adjacent pixels starting at x. Lanes outside the
+// sprite or past max_x keep their dest value.
+static inline __m128i ShadeSpriteLanes(GameBuffer *texture, SpriteBasis *basis,
+                                       SpriteMapping *mapping, __m128 tint[4],
+                                       int x, int max_x, __m128 offset_y,
+                                       __m128i dest) {
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 max_channel = _mm_set1_ps(255.0f);
+
+  __m128 offset_x = _mm_add_ps(_mm_set1_ps(x + 0.5f - basis->origin_x),
+                               _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+  __m128 u = _mm_add_ps(_mm_mul_ps(offset_x, _mm_set1_ps(mapping->u_x)),
+                        _mm_mul_ps(offset_y, _mm_set1_ps(mapping->u_y)));
+  __m128 v = _mm_add_ps(_mm_mul_ps(offset_x, _mm_set1_ps(mapping->v_x)),
+                        _mm_mul_ps(offset_y, _mm_set1_ps(mapping->v_y)));
+
+  __m128i lane_x = _mm_add_epi32(_mm_set1_epi32(x), _mm_set_epi32(3, 2, 1, 0));
+  __m128i in_span = _mm_cmplt_epi32(lane_x, _mm_set1_epi32(max_x));
+  __m128 inside = _mm_and_ps(
+      _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)),
+      _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(v, one)));
+  __m128i mask = _mm_and_si128(_mm_castps_si128(inside), in_span);
+  if (!_mm_movemask_epi8(mask)) {
+    return dest;
+  }
+
+  __m128 max_texel_x = _mm_set1_ps(static_cast<float>(texture->width - 1));
+  __m128 max_texel_y = _mm_set1_ps(static_cast<float>(texture->height - 1));
+  __m128 half = _mm_set1_ps(0.5f);
+  __m128 texture_width = _mm_set1_ps(static_cast<float>(texture->width));
+  __m128 texture_height = _mm_set1_ps(static_cast<float>(texture->height));
+  __m128 texel_x = _mm_min_ps(
+      _mm_max_ps(_mm_sub_ps(_mm_mul_ps(u, texture_width), half), zero),
+      max_texel_x);
+  __m128 texel_y = _mm_min_ps(
+      _mm_max_ps(_mm_sub_ps(_mm_mul_ps(v, texture_height), half), zero),
+      max_texel_y);
+  __m128i ix = _mm_cvttps_epi32(
+      _mm_min_ps(texel_x, _mm_sub_ps(max_texel_x, one)));
+  __m128i iy = _mm_cvttps_epi32(
+      _mm_min_ps(texel_y, _mm_sub_ps(max_texel_y, one)));
+  __m128 fx = _mm_sub_ps(texel_x, _mm_cvtepi32_ps(ix));
+  __m128 fy = _mm_sub_ps(texel_y, _mm_cvtepi32_ps(iy));
+
+  // SSE2 has no gather, so each lane loads its two texel pairs and a 4x4
+  // transpose regroups them by corner. Lanes outside the sprite read a
+  // clamped, harmless texel.
+  int32_t lane_ix[4];
+  int32_t lane_iy[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lane_ix), ix);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lane_iy), iy);
+  __m128i quads[4];
+  for (int lane = 0; lane < 4; ++lane) {
+    __m128i *texel_row = reinterpret_cast<__m128i *>(
+        GetTexel(texture, lane_ix[lane], lane_iy[lane]));
+    __m128i *next_row = reinterpret_cast<__m128i *>(
+        GetTexel(texture, lane_ix[lane], lane_iy[lane] + 1));
+    quads[lane] = _mm_unpacklo_epi64(_mm_loadl_epi64(texel_row),
+                                     _mm_loadl_epi64(next_row));
+  }
+  __m128i quads_01_lo = _mm_unpacklo_epi32(quads[0], quads[1]);
+  __m128i quads_23_lo = _mm_unpacklo_epi32(quads[2], quads[3]);
+  __m128i quads_01_hi = _mm_unpackhi_epi32(quads[0], quads[1]);
+  __m128i quads_23_hi = _mm_unpackhi_epi32(quads[2], quads[3]);
+  __m128i texel_00 = _mm_unpacklo_epi64(quads_01_lo, quads_23_lo);
+  __m128i texel_10 = _mm_unpackhi_epi64(quads_01_lo, quads_23_lo);
+  __m128i texel_01 = _mm_unpacklo_epi64(quads_01_hi, quads_23_hi);
+  __m128i texel_11 = _mm_unpackhi_epi64(quads_01_hi, quads_23_hi);
+
+  __m128 texel[4];
+  for (int channel = 0; channel < 4; ++channel) {
+    int shift = channel * 8;
+    __m128 top = Lerp(UnpackChannel(texel_00, shift),
+                      UnpackChannel(texel_10, shift), fx);
+    __m128 bottom = Lerp(UnpackChannel(texel_01, shift),
+                         UnpackChannel(texel_11, shift), fx);
+    texel[channel] = _mm_mul_ps(Lerp(top, bottom, fy), tint[channel]);
+  }
+
+  __m128 inv_alpha =
+      _mm_sub_ps(one, _mm_mul_ps(texel[3], _mm_set1_ps(1.0f / 255.0f)));
+  __m128i shaded = _mm_setzero_si128();
+  for (int channel = 0; channel < 4; ++channel) {
+    int shift = channel * 8;
+    __m128 value = _mm_add_ps(
+        texel[channel], _mm_mul_ps(UnpackChannel(dest, shift), inv_alpha));
+    __m128i packed = _mm_cvtps_epi32(_mm_min_ps(value, max_channel));
+    shaded = _mm_or_si128(shaded, _mm_slli_epi32(packed, shift));
+  }
+
+  __m128i result = _mm_or_si128(_mm_and_si128(mask, shaded),
+                                _mm_andnot_si128(mask, dest));
+  return result;
+}
+
+void DrawSprite(GameBuffer *dest, GameBuffer *texture, SpriteBasis *basis,
+                uint32_t color, int clip_min_x, int clip_min_y, int clip_max_x,
+                int clip_max_y) {
+  SpriteBounds bounds = {};
+  SpriteMapping mapping = {};
+  if (!GetSpriteBounds(dest, texture, basis, clip_min_x, clip_min_y,
+                       clip_max_x, clip_max_y, &bounds, &mapping)) {
+    return;
+  }
+
+  __m128 tint[4];
+  for (int channel = 0; channel < 4; ++channel) {
+    tint[channel] =
+        _mm_set1_ps(GetChannel(color, channel * 8) * (1.0f / 255.0f));
+  }
+
+  for (int y = bounds.min_y; y < bounds.max_y; ++y) {
+    uint32_t *row = reinterpret_cast<uint32_t *>(
+        reinterpret_cast<uint8_t *>(dest->memory) + y * dest->pitch);
+    __m128 offset_y = _mm_set1_ps(y + 0.5f - basis->origin_y);
+
+    int x = bounds.min_x;
+    for (; x + 4 <= bounds.max_x; x += 4) {
+      __m128i *pixels = reinterpret_cast<__m128i *>(row + x);
+      __m128i shaded =
+          ShadeSpriteLanes(texture, basis, &mapping, tint, x, bounds.max_x,
+                           offset_y, _mm_loadu_si128(pixels));
+      _mm_storeu_si128(pixels, shaded);
+    }
+
+    // The tail goes through a copy so no lane reads or writes past the clip.
+    if (x < bounds.max_x) {
+      uint32_t tail[4] = {};
+      int tail_count = bounds.max_x - x;
+      for (int i = 0; i < tail_count; ++i) {
+        tail[i] = row[x + i];
+      }
+      __m128i *pixels = reinterpret_cast<__m128i *>(tail);
+      _mm_storeu_si128(
+          pixels, ShadeSpriteLanes(texture, basis, &mapping, tint, x,
+                                   bounds.max_x, offset_y,
+                                   _mm_loadu_si128(pixels)));
+      for (int i = 0; i < tail_count; ++i) {
+        row[x + i] = tail[i];
+      }
+    }
+  }
+}
+
+SpriteBasis MakeSpriteBasis(float center_x, float center_y, float width,
+                            float height, float angle) {
+  float cos_angle = cosf(angle);
+  float sin_angle = sinf(angle);
+
+  SpriteBasis result = {};
+  result.x_axis_x = cos_angle * width;
+  result.x_axis_y = sin_angle * width;
+  result.y_axis_x = -sin_angle * height;
+  result.y_axis_y = cos_angle * height;
+  result.origin_x = center_x - 0.5f * (result.x_axis_x + result.y_axis_x);
+  result.origin_y = center_y - 0.5f * (result.x_axis_y + result.y_axis_y);
+  return result;
+}
+
+// A ring crossed by one bar, so rotation is visible. The outermost texels
+// stay transparent, which keeps bilinear filtering from smearing the edge.
+void FillMarkerTexture(GameBuffer *texture, uint32_t color) {
+  Assert(texture->format == PIXEL_FORMAT_BGRA8);
+
+  float half_width = 0.5f * texture->width;
+  float half_height = 0.5f * texture->height;
+  float edge = 1.0f / half_width;
+  for (int y = 0; y < texture->height; ++y) {
+    for (int x = 0; x < texture->width; ++x) {
+      float dx = (x + 0.5f - half_width) / half_width;
+      float dy = (y + 0.5f - half_height) / half_height;
+      float distance = sqrtf(dx * dx + dy * dy);
+
+      float outer = fminf(fmaxf((0.85f - distance) / edge, 0.0f), 1.0f);
+      float inner = fminf(fmaxf((distance - 0.6f) / edge, 0.0f), 1.0f);
+      float bar = fminf(fmaxf((0.12f - fabsf(dy)) / edge, 0.0f), 1.0f);
+      float coverage = outer * fmaxf(inner, bar);
+
+      uint32_t result = 0;
+      for (int shift = 0; shift < 32; shift += 8) {
+        float channel = GetChannel(color, shift) * coverage;
+        result |= static_cast<uint32_t>(channel + 0.5f) << shift;
+      }
+      *GetTexel(texture, x, y) = result;
+    }
+  }
+}
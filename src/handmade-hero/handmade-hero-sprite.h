@@ -0,0 +1,33 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_SPRITE_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_SPRITE_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+// The sprite covers origin + u * x_axis + v * y_axis for u and v in [0, 1],
+// so the axes carry rotation, scale and shear. All in pixels.
+struct SpriteBasis {
+  float origin_x;
+  float origin_y;
+  float x_axis_x;
+  float x_axis_y;
+  float y_axis_x;
+  float y_axis_y;
+};
+
+// Textures and targets are BGRA8 with premultiplied alpha. color tints the
+// texture and is packed 0xAARRGGBB like everywhere else. Only pixels inside
+// the half-open clip rectangle are touched, so separate tiles of one target
+// can be drawn independently.
+void DrawSprite(GameBuffer *dest, GameBuffer *texture, SpriteBasis *basis,
+                uint32_t color, int clip_min_x, int clip_min_y, int clip_max_x,
+                int clip_max_y);
+void DrawSpriteReference(GameBuffer *dest, GameBuffer *texture,
+                         SpriteBasis *basis, uint32_t color, int clip_min_x,
+                         int clip_min_y, int clip_max_x, int clip_max_y);
+SpriteBasis MakeSpriteBasis(float center_x, float center_y, float width,
+                            float height, float angle);
+void FillMarkerTexture(GameBuffer *texture, uint32_t color);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_SPRITE_H_
@@ -0,0 +1,632 @@
+#include "../../src/handmade-hero/handmade-hero-stream.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero-world.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const uint32_t CHUNK_TILES_SIZE =
+    TILE_CHUNK_DIM * TILE_CHUNK_DIM * sizeof(uint32_t);
+
+static int CompareWorldFileChunks(const void *a, const void *b) {
+  const WorldFileChunk *chunk_a = reinterpret_cast<const WorldFileChunk *>(a);
+  const WorldFileChunk *chunk_b = reinterpret_cast<const WorldFileChunk *>(b);
+  int result = 0;
+  if (chunk_a->chunk_y != chunk_b->chunk_y) {
+    result = chunk_a->chunk_y < chunk_b->chunk_y ? -1 : 1;
+  } else if (chunk_a->chunk_x != chunk_b->chunk_x) {
+    result = chunk_a->chunk_x < chunk_b->chunk_x ? -1 : 1;
+  }
+  return result;
+}
+
+static uint32_t HashChunkTiles(uint32_t *tiles) {
+  uint32_t result = 0x811C9DC5;
+  uint8_t *at = reinterpret_cast<uint8_t *>(tiles);
+  for (uint32_t i = 0; i < CHUNK_TILES_SIZE; ++i) {
+    result = (result ^ at[i]) * 0x01000193;
+  }
+  return result;
+}
+
+static bool IsWorldFileHeaderValid(WorldFileHeader *header) {
+  bool result = header->magic == WORLD_FILE_MAGIC &&
+                header->version == WORLD_FILE_VERSION &&
+                header->chunk_dim == TILE_CHUNK_DIM &&
+                header->chunk_count <= WORLD_MAX_CHUNK_COUNT;
+  return result;
+}
+
+static bool IsWorldDirectoryValid(WorldFileChunk *directory, uint32_t count) {
+  bool result = true;
+  for (uint32_t i = 0; result && i < count; ++i) {
+    WorldFileChunk *entry = &directory[i];
+    result = entry->tiles_size == CHUNK_TILES_SIZE &&
+             (i == 0 || CompareWorldFileChunks(entry - 1, entry) < 0);
+  }
+  return result;
+}
+
+static int32_t FindDirectoryEntry(WorldFileChunk *directory, uint32_t count,
+                                  int32_t chunk_x, int32_t chunk_y) {
+  WorldFileChunk key = {};
+  key.chunk_x = chunk_x;
+  key.chunk_y = chunk_y;
+
+  int32_t min_idx = 0;
+  int32_t max_idx = static_cast<int32_t>(count) - 1;
+  while (min_idx <= max_idx) {
+    int32_t mid_idx = min_idx + (max_idx - min_idx) / 2;
+    int order = CompareWorldFileChunks(&directory[mid_idx], &key);
+    if (order == 0) {
+      return mid_idx;
+    }
+    if (order < 0) {
+      min_idx = mid_idx + 1;
+    } else {
+      max_idx = mid_idx - 1;
+    }
+  }
+  return -1;
+}
+
+bool WriteWorldFile(World *world, PlatformApi *platform, MemoryArena *scratch,
+                    const char *file_name) {
+  if (!platform->WriteEntireFile) {
+    return false;
+  }
+
+  uint32_t chunk_count = 0;
+  for (uint32_t i = 0; i < WORLD_CHUNK_SLOT_COUNT; ++i) {
+    chunk_count += world->slots[i].chunk_idx != WORLD_NULL_CHUNK;
+  }
+
+  uint64_t directory_offset =
+      sizeof(WorldFileHeader) +
+      static_cast<uint64_t>(chunk_count) * CHUNK_TILES_SIZE;
+  uint64_t file_size = directory_offset + chunk_count * sizeof(WorldFileChunk);
+  if (file_size > 0xFFFFFFFF ||
+      scratch->used + file_size + 16 > scratch->size) {
+    return false;
+  }
+
+  uint8_t *file = reinterpret_cast<uint8_t *>(
+      PushSize(scratch, static_cast<size_t>(file_size)));
+  WorldFileChunk *directory =
+      reinterpret_cast<WorldFileChunk *>(file + directory_offset);
+
+  uint32_t directory_count = 0;
+  for (uint32_t i = 0; i < WORLD_CHUNK_SLOT_COUNT; ++i) {
+    TileChunkSlot *slot = &world->slots[i];
+    if (slot->chunk_idx == WORLD_NULL_CHUNK) {
+      continue;
+    }
+
+    WorldFileChunk *entry = &directory[directory_count++];
+    entry->chunk_x = slot->chunk_x;
+    entry->chunk_y = slot->chunk_y;
+    entry->tile_count = world->chunks[slot->chunk_idx].tile_count;
+    entry->tiles_size = CHUNK_TILES_SIZE;
+  }
+  qsort(directory, directory_count, sizeof(WorldFileChunk),
+        CompareWorldFileChunks);
+
+  // Tiles are laid out in directory order so neighbouring rows of chunks sit
+  // close together on disk.
+  for (uint32_t i = 0; i < directory_count; ++i) {
+    WorldFileChunk *entry = &directory[i];
+    TileChunk *chunk = GetTileChunk(world, entry->chunk_x, entry->chunk_y);
+    entry->tiles_offset =
+        sizeof(WorldFileHeader) + static_cast<uint64_t>(i) * CHUNK_TILES_SIZE;
+    entry->tiles_hash = HashChunkTiles(chunk->tiles);
+    memcpy(file + entry->tiles_offset, chunk->tiles, CHUNK_TILES_SIZE);
+  }
+
+  WorldFileHeader *header = reinterpret_cast<WorldFileHeader *>(file);
+  header->magic = WORLD_FILE_MAGIC;
+  header->version = WORLD_FILE_VERSION;
+  header->chunk_dim = TILE_CHUNK_DIM;
+  header->chunk_count = chunk_count;
+  header->directory_offset = directory_offset;
+
+  bool result = platform->WriteEntireFile(
+      file_name, static_cast<uint32_t>(file_size), file);
+  return result;
+}
+
+bool InitChunkStreamer(ChunkStreamer *streamer, MemoryArena *arena,
+                       PlatformApi *platform, const char *file_name) {
+  *streamer = {};
+  if (!platform->OpenFile || !platform->ReadFile || !platform->QueueRead) {
+    return false;
+  }
+
+  void *file = platform->OpenFile(file_name);
+  if (!file) {
+    return false;
+  }
+
+  // Reloads may grow the world, so the arrays are sized for the largest one.
+  WorldFileHeader header = {};
+  bool result = platform->ReadFile(file, 0, sizeof(header), &header) &&
+                IsWorldFileHeaderValid(&header);
+  if (result) {
+    streamer->directory =
+        PushArray(arena, WORLD_MAX_CHUNK_COUNT, WorldFileChunk);
+    streamer->resident = PushArray(arena, WORLD_MAX_CHUNK_COUNT, uint32_t);
+    streamer->resident_hashes =
+        PushArray(arena, WORLD_MAX_CHUNK_COUNT, uint32_t);
+    streamer->directory_count = header.chunk_count;
+    result = platform->ReadFile(
+                 file, header.directory_offset,
+                 header.chunk_count *
+                     static_cast<uint32_t>(sizeof(WorldFileChunk)),
+                 streamer->directory) &&
+             IsWorldDirectoryValid(streamer->directory, header.chunk_count);
+  }
+  platform->CloseFile(file);
+
+  streamer->is_enabled = result;
+  return result;
+}
+
+int32_t FindWorldFileChunk(ChunkStreamer *streamer, int32_t chunk_x,
+                           int32_t chunk_y) {
+  int32_t result = FindDirectoryEntry(
+      streamer->directory, streamer->directory_count, chunk_x, chunk_y);
+  return result;
+}
+
+// A streamed chunk that is not resident has tiles the world does not know
+// yet, unlike a chunk missing from the file, which is empty.
+bool IsChunkStreamed(ChunkStreamer *streamer, int32_t chunk_x,
+                     int32_t chunk_y) {
+  bool result = streamer && streamer->is_enabled &&
+                FindWorldFileChunk(streamer, chunk_x, chunk_y) >= 0;
+  return result;
+}
+
+void EvictAllChunks(ChunkStreamer *streamer, World *world) {
+  for (uint32_t i = 0; i < streamer->directory_count; ++i) {
+    WorldFileChunk *entry = &streamer->directory[i];
+    RemoveTileChunk(world, entry->chunk_x, entry->chunk_y);
+  }
+  streamer->resident_count = 0;
+}
+
+static inline int32_t FloorToChunk(float tile) {
+  int32_t result = static_cast<int32_t>(floorf(tile)) >> TILE_CHUNK_SHIFT;
+  return result;
+}
+
+static ChunkRect GetChunkRect(float min_x, float min_y, float width,
+                              float height, int32_t margin) {
+  ChunkRect result;
+  result.min_x = FloorToChunk(min_x) - margin;
+  result.min_y = FloorToChunk(min_y) - margin;
+  result.max_x = FloorToChunk(min_x + width) + margin;
+  result.max_y = FloorToChunk(min_y + height) + margin;
+  return result;
+}
+
+static ChunkRect GetUnionRect(ChunkRect a, ChunkRect b, int32_t margin) {
+  ChunkRect result;
+  result.min_x = (a.min_x < b.min_x ? a.min_x : b.min_x) - margin;
+  result.min_y = (a.min_y < b.min_y ? a.min_y : b.min_y) - margin;
+  result.max_x = (a.max_x > b.max_x ? a.max_x : b.max_x) + margin;
+  result.max_y = (a.max_y > b.max_y ? a.max_y : b.max_y) + margin;
+  return result;
+}
+
+static inline bool IsInRect(ChunkRect *rect, int32_t chunk_x,
+                            int32_t chunk_y) {
+  bool result = chunk_x >= rect->min_x && chunk_x <= rect->max_x &&
+                chunk_y >= rect->min_y && chunk_y <= rect->max_y;
+  return result;
+}
+
+static ChunkLoad *FindChunkLoad(ChunkLoadQueue *queue, uint32_t directory_idx) {
+  for (int i = 0; i < STREAM_LOAD_SLOT_COUNT; ++i) {
+    ChunkLoad *load = &queue->loads[i];
+    if (load->status != PLATFORM_READ_IDLE &&
+        load->generation == queue->generation &&
+        load->directory_idx == directory_idx) {
+      return load;
+    }
+  }
+  return 0;
+}
+
+static int32_t FindResidentIdx(ChunkStreamer *streamer,
+                               uint32_t directory_idx) {
+  for (uint32_t i = 0; i < streamer->resident_count; ++i) {
+    if (streamer->resident[i] == directory_idx) {
+      return static_cast<int32_t>(i);
+    }
+  }
+  return -1;
+}
+
+static void RemoveResident(ChunkStreamer *streamer, uint32_t resident_idx) {
+  uint32_t last_idx = --streamer->resident_count;
+  streamer->resident[resident_idx] = streamer->resident[last_idx];
+  streamer->resident_hashes[resident_idx] = streamer->resident_hashes[last_idx];
+}
+
+static void IntegrateCompletedLoads(ChunkStreamer *streamer,
+                                    ChunkLoadQueue *queue, World *world) {
+  GameStreamStats *stats = &streamer->stats;
+  for (int i = 0; i < STREAM_LOAD_SLOT_COUNT; ++i) {
+    ChunkLoad *load = &queue->loads[i];
+    int32_t status = load->status;
+    if (status == PLATFORM_READ_FAILED) {
+      ++stats->failed_count;
+      load->status = PLATFORM_READ_IDLE;
+      continue;
+    }
+    if (status != PLATFORM_READ_DONE) {
+      continue;
+    }
+    if (load->generation != queue->generation) {
+      load->status = PLATFORM_READ_IDLE;
+      continue;
+    }
+
+    // Tiles that do not match the directory were read from a file rewritten
+    // since the directory was; they count as a failed read until the reload
+    // brings in the matching directory.
+    WorldFileChunk *entry = &streamer->directory[load->directory_idx];
+    if (HashChunkTiles(load->tiles) != entry->tiles_hash) {
+      ++stats->failed_count;
+      load->status = PLATFORM_READ_IDLE;
+      continue;
+    }
+
+    // Loads that finish after the camera moved on are dropped rather than
+    // inserted and evicted again on the same frame.
+    TileChunk *resident_chunk =
+        GetTileChunk(world, entry->chunk_x, entry->chunk_y);
+    if (resident_chunk) {
+      int32_t resident_idx = FindResidentIdx(streamer, load->directory_idx);
+      if (resident_idx >= 0 &&
+          streamer->resident_hashes[resident_idx] != entry->tiles_hash) {
+        memcpy(resident_chunk->tiles, load->tiles, CHUNK_TILES_SIZE);
+        resident_chunk->tile_count = entry->tile_count;
+        MarkTileChunkChanged(world, entry->chunk_x, entry->chunk_y);
+        streamer->resident_hashes[resident_idx] = entry->tiles_hash;
+        ++stats->refreshed_count;
+      }
+    } else if (IsInRect(&streamer->keep_rect, entry->chunk_x,
+                        entry->chunk_y)) {
+      TileChunk *chunk =
+          GetOrCreateTileChunk(world, entry->chunk_x, entry->chunk_y);
+      if (chunk) {
+        memcpy(chunk->tiles, load->tiles, CHUNK_TILES_SIZE);
+        chunk->tile_count = entry->tile_count;
+        streamer->resident[streamer->resident_count] = load->directory_idx;
+        streamer->resident_hashes[streamer->resident_count] = entry->tiles_hash;
+        ++streamer->resident_count;
+        ++stats->loaded_count;
+        if (load->is_needed) {
+          ++stats->late_count;
+        }
+      } else {
+        ++stats->failed_count;
+      }
+    }
+    load->status = PLATFORM_READ_IDLE;
+  }
+}
+
+static ChunkLoad *AcquireChunkLoad(ChunkStreamer *streamer,
+                                   ChunkLoadQueue *queue, World *world) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    for (int i = 0; i < STREAM_LOAD_SLOT_COUNT; ++i) {
+      if (queue->loads[i].status == PLATFORM_READ_IDLE) {
+        return &queue->loads[i];
+      }
+    }
+    IntegrateCompletedLoads(streamer, queue, world);
+  }
+  return 0;
+}
+
+static bool QueueChunkLoad(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                           World *world, PlatformApi *platform,
+                           uint32_t directory_idx) {
+  ChunkLoad *load = AcquireChunkLoad(streamer, queue, world);
+  if (!load) {
+    return false;
+  }
+
+  WorldFileChunk *entry = &streamer->directory[directory_idx];
+  load->generation = queue->generation;
+  load->directory_idx = directory_idx;
+  load->is_needed = false;
+  load->status = PLATFORM_READ_PENDING;
+  if (!platform->QueueRead(queue->file, entry->tiles_offset, entry->tiles_size,
+                           load->tiles, &load->status)) {
+    load->status = PLATFORM_READ_IDLE;
+    return false;
+  }
+  ++streamer->stats.requested_count;
+  return true;
+}
+
+static void RequestChunks(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                          World *world, PlatformApi *platform,
+                          ChunkRect *rect) {
+  for (int32_t chunk_y = rect->min_y; chunk_y <= rect->max_y; ++chunk_y) {
+    for (int32_t chunk_x = rect->min_x; chunk_x <= rect->max_x; ++chunk_x) {
+      int32_t directory_idx = FindWorldFileChunk(streamer, chunk_x, chunk_y);
+      if (directory_idx < 0 || GetTileChunk(world, chunk_x, chunk_y) ||
+          FindChunkLoad(queue, directory_idx)) {
+        continue;
+      }
+
+      if (!QueueChunkLoad(streamer, queue, world, platform, directory_idx)) {
+        return;
+      }
+    }
+  }
+}
+
+static void RefreshStaleChunks(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                               World *world, PlatformApi *platform) {
+  for (uint32_t i = 0; i < streamer->resident_count; ++i) {
+    uint32_t directory_idx = streamer->resident[i];
+    if (streamer->resident_hashes[i] ==
+            streamer->directory[directory_idx].tiles_hash ||
+        FindChunkLoad(queue, directory_idx)) {
+      continue;
+    }
+
+    if (!QueueChunkLoad(streamer, queue, world, platform, directory_idx)) {
+      return;
+    }
+  }
+}
+
+static void InitChunkLoadQueue(ChunkLoadQueue *queue, PlatformApi *platform,
+                               const char *file_name) {
+  *queue = {};
+  queue->file = platform->OpenFile(file_name);
+  queue->is_init = true;
+}
+
+void ReloadWorldFile(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                     PlatformApi *platform, const char *file_name) {
+  if (!streamer->is_enabled) {
+    return;
+  }
+  if (!queue->is_init) {
+    InitChunkLoadQueue(queue, platform, file_name);
+  }
+  queue->is_reload_queued = true;
+}
+
+// Re-reads the header and directory on a worker. Chunk reads wait until the
+// new directory is swapped in, since the old offsets may no longer match the
+// file.
+static void BeginWorldReload(ChunkLoadQueue *queue, PlatformApi *platform,
+                             const char *file_name) {
+  // Editors often replace the file rather than rewrite it, so it is reopened.
+  // The old handle stays open until no read still uses it.
+  queue->is_reload_queued = false;
+  queue->retired_file = queue->file;
+  queue->file = platform->OpenFile(file_name);
+
+  queue->reload_stage = WORLD_RELOAD_HEADER;
+  queue->reload_status = PLATFORM_READ_PENDING;
+  if (!queue->file ||
+      !platform->QueueRead(queue->file, 0, sizeof(WorldFileHeader),
+                           &queue->reload_header, &queue->reload_status)) {
+    queue->reload_status = PLATFORM_READ_FAILED;
+  }
+}
+
+// Resident chunks keep the hash of the tiles they hold, so only the directory
+// indices need remapping; staleness follows from comparing the hashes. Chunks
+// the file added, dropped or changed are logged as world edits unless they
+// are resident, in which case the refresh logs them once the new tiles land.
+static void SwapWorldDirectory(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                               World *world) {
+  uint32_t directory_count = queue->reload_header.chunk_count;
+  for (uint32_t i = 0; i < directory_count; ++i) {
+    WorldFileChunk *new_entry = &queue->reload_directory[i];
+    int32_t old_idx = FindWorldFileChunk(streamer, new_entry->chunk_x,
+                                         new_entry->chunk_y);
+    if ((old_idx < 0 ||
+         streamer->directory[old_idx].tiles_hash != new_entry->tiles_hash) &&
+        !GetTileChunk(world, new_entry->chunk_x, new_entry->chunk_y)) {
+      MarkTileChunkChanged(world, new_entry->chunk_x, new_entry->chunk_y);
+    }
+  }
+  for (uint32_t i = 0; i < streamer->directory_count; ++i) {
+    WorldFileChunk *old_entry = &streamer->directory[i];
+    if (FindDirectoryEntry(queue->reload_directory, directory_count,
+                           old_entry->chunk_x, old_entry->chunk_y) < 0 &&
+        !GetTileChunk(world, old_entry->chunk_x, old_entry->chunk_y)) {
+      MarkTileChunkChanged(world, old_entry->chunk_x, old_entry->chunk_y);
+    }
+  }
+
+  uint32_t resident_idx = 0;
+  while (resident_idx < streamer->resident_count) {
+    WorldFileChunk *entry =
+        &streamer->directory[streamer->resident[resident_idx]];
+    int32_t directory_idx =
+        FindDirectoryEntry(queue->reload_directory, directory_count,
+                           entry->chunk_x, entry->chunk_y);
+    if (directory_idx < 0) {
+      RemoveTileChunk(world, entry->chunk_x, entry->chunk_y);
+      MarkTileChunkChanged(world, entry->chunk_x, entry->chunk_y);
+      RemoveResident(streamer, resident_idx);
+      ++streamer->stats.evicted_count;
+      continue;
+    }
+
+    streamer->resident[resident_idx++] = directory_idx;
+  }
+
+  memcpy(streamer->directory, queue->reload_directory,
+         directory_count * sizeof(WorldFileChunk));
+  streamer->directory_count = directory_count;
+  ++queue->generation;
+  ++streamer->stats.reload_count;
+}
+
+static void StepWorldReload(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                            World *world, PlatformApi *platform,
+                            const char *file_name) {
+  if (queue->is_reload_queued && !queue->retired_file &&
+      queue->reload_stage == WORLD_RELOAD_IDLE) {
+    BeginWorldReload(queue, platform, file_name);
+  }
+
+  int32_t status = queue->reload_status;
+  if (queue->reload_stage == WORLD_RELOAD_IDLE ||
+      status == PLATFORM_READ_PENDING) {
+    return;
+  }
+
+  if (status == PLATFORM_READ_DONE &&
+      queue->reload_stage == WORLD_RELOAD_HEADER &&
+      IsWorldFileHeaderValid(&queue->reload_header)) {
+    WorldFileHeader *header = &queue->reload_header;
+    queue->reload_stage = WORLD_RELOAD_DIRECTORY;
+    queue->reload_status = PLATFORM_READ_PENDING;
+    if (platform->QueueRead(
+            queue->file, header->directory_offset,
+            header->chunk_count *
+                static_cast<uint32_t>(sizeof(WorldFileChunk)),
+            queue->reload_directory, &queue->reload_status)) {
+      return;
+    }
+    status = PLATFORM_READ_FAILED;
+  }
+
+  if (status == PLATFORM_READ_DONE &&
+      queue->reload_stage == WORLD_RELOAD_DIRECTORY &&
+      IsWorldDirectoryValid(queue->reload_directory,
+                            queue->reload_header.chunk_count)) {
+    SwapWorldDirectory(streamer, queue, world);
+  } else {
+    ++streamer->stats.failed_count;
+  }
+  queue->reload_stage = WORLD_RELOAD_IDLE;
+  queue->reload_status = PLATFORM_READ_IDLE;
+}
+
+static void EvictChunks(ChunkStreamer *streamer, World *world) {
+  uint32_t resident_idx = 0;
+  while (resident_idx < streamer->resident_count) {
+    WorldFileChunk *entry =
+        &streamer->directory[streamer->resident[resident_idx]];
+    if (IsInRect(&streamer->keep_rect, entry->chunk_x, entry->chunk_y)) {
+      ++resident_idx;
+      continue;
+    }
+
+    RemoveTileChunk(world, entry->chunk_x, entry->chunk_y);
+    RemoveResident(streamer, resident_idx);
+    ++streamer->stats.evicted_count;
+  }
+}
+
+static void UpdateCameraVelocity(ChunkStreamer *streamer, float camera_x,
+                                 float camera_y, float view_width,
+                                 float view_height, float dt) {
+  if (streamer->has_camera && dt > 0.0f) {
+    float delta_x = camera_x - streamer->camera_x;
+    float delta_y = camera_y - streamer->camera_y;
+    if (fabsf(delta_x) > view_width || fabsf(delta_y) > view_height) {
+      // A jump this large is a teleport, not motion worth extrapolating.
+      streamer->vel_x = 0.0f;
+      streamer->vel_y = 0.0f;
+    } else {
+      streamer->vel_x +=
+          STREAM_VELOCITY_SMOOTHING * (delta_x / dt - streamer->vel_x);
+      streamer->vel_y +=
+          STREAM_VELOCITY_SMOOTHING * (delta_y / dt - streamer->vel_y);
+    }
+  }
+  streamer->camera_x = camera_x;
+  streamer->camera_y = camera_y;
+  streamer->has_camera = true;
+}
+
+// Visible chunks are requested first, then a ring around them, then the
+// window the camera is heading towards. Anything resident outside a wider
+// keep window goes back on the world's free list.
+void UpdateChunkStreamer(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                         World *world, PlatformApi *platform,
+                         const char *file_name, float camera_x,
+                         float camera_y, float view_width, float view_height,
+                         float dt) {
+  if (!streamer->is_enabled) {
+    return;
+  }
+
+  if (!queue->is_init) {
+    InitChunkLoadQueue(queue, platform, file_name);
+  }
+
+  UpdateCameraVelocity(streamer, camera_x, camera_y, view_width, view_height,
+                       dt);
+
+  ChunkRect view_rect =
+      GetChunkRect(camera_x, camera_y, view_width, view_height, 0);
+  ChunkRect resident_rect =
+      GetChunkRect(camera_x, camera_y, view_width, view_height,
+                   STREAM_RESIDENT_MARGIN_CHUNKS);
+  ChunkRect prefetch_rect = GetChunkRect(
+      camera_x + streamer->vel_x * STREAM_PREFETCH_SEC,
+      camera_y + streamer->vel_y * STREAM_PREFETCH_SEC, view_width,
+      view_height, STREAM_RESIDENT_MARGIN_CHUNKS);
+  streamer->keep_rect =
+      GetUnionRect(resident_rect, prefetch_rect, STREAM_EVICT_MARGIN_CHUNKS);
+
+  IntegrateCompletedLoads(streamer, queue, world);
+  StepWorldReload(streamer, queue, world, platform, file_name);
+  if (queue->file && queue->reload_stage == WORLD_RELOAD_IDLE) {
+    RequestChunks(streamer, queue, world, platform, &view_rect);
+    RefreshStaleChunks(streamer, queue, world, platform);
+    RequestChunks(streamer, queue, world, platform, &resident_rect);
+    RequestChunks(streamer, queue, world, platform, &prefetch_rect);
+  }
+  IntegrateCompletedLoads(streamer, queue, world);
+  EvictChunks(streamer, world);
+
+  GameStreamStats *stats = &streamer->stats;
+  for (int32_t chunk_y = view_rect.min_y; chunk_y <= view_rect.max_y;
+       ++chunk_y) {
+    for (int32_t chunk_x = view_rect.min_x; chunk_x <= view_rect.max_x;
+         ++chunk_x) {
+      int32_t directory_idx = FindWorldFileChunk(streamer, chunk_x, chunk_y);
+      if (directory_idx < 0 || GetTileChunk(world, chunk_x, chunk_y)) {
+        continue;
+      }
+
+      ++stats->missed_count;
+      ChunkLoad *load = FindChunkLoad(queue, directory_idx);
+      if (load) {
+        load->is_needed = true;
+      }
+    }
+  }
+
+  stats->in_flight_count = 0;
+  for (int i = 0; i < STREAM_LOAD_SLOT_COUNT; ++i) {
+    stats->in_flight_count += queue->loads[i].status == PLATFORM_READ_PENDING;
+  }
+  if (queue->retired_file && stats->in_flight_count == 0 &&
+      queue->reload_status != PLATFORM_READ_PENDING) {
+    platform->CloseFile(queue->retired_file);
+    queue->retired_file = 0;
+  }
+  stats->resident_count = streamer->resident_count;
+}
@@ -0,0 +1,120 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_STREAM_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_STREAM_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-world.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const uint32_t WORLD_FILE_MAGIC = 0x57484848;  // "HHHW"
+static const uint32_t WORLD_FILE_VERSION = 2;
+static const char WORLD_FILE_NAME[] = "world-chunks.bin";
+static const int STREAM_LOAD_SLOT_COUNT = 32;
+static const int STREAM_RESIDENT_MARGIN_CHUNKS = 1;
+static const int STREAM_EVICT_MARGIN_CHUNKS = 2;
+static const float STREAM_PREFETCH_SEC = 0.5f;
+static const float STREAM_VELOCITY_SMOOTHING = 0.25f;
+
+// The file is the header, the tiles of every chunk back to back, then the
+// directory sorted by (chunk_y, chunk_x).
+struct WorldFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t chunk_dim;
+  uint32_t chunk_count;
+  uint64_t directory_offset;
+};
+
+// tiles_hash lets a reload tell which resident chunks actually changed.
+struct WorldFileChunk {
+  int32_t chunk_x;
+  int32_t chunk_y;
+  uint32_t tile_count;
+  uint32_t tiles_size;
+  uint64_t tiles_offset;
+  uint32_t tiles_hash;
+  uint32_t reserved;
+};
+
+enum WorldReloadStage {
+  WORLD_RELOAD_IDLE,
+  WORLD_RELOAD_HEADER,
+  WORLD_RELOAD_DIRECTORY,
+};
+
+struct ChunkLoad {
+  volatile int32_t status;
+  uint32_t generation;
+  uint32_t directory_idx;
+  bool is_needed;
+  uint32_t tiles[TILE_CHUNK_DIM * TILE_CHUNK_DIM];
+};
+
+// Worker threads write into the loads, so they live in transient storage,
+// away from the permanent block that save states snapshot and restore.
+// A zeroed queue, e.g. after recovery, reopens the file on the next update.
+// Loads issued before a reload swapped the directory carry an older
+// generation and are dropped when they land.
+struct ChunkLoadQueue {
+  bool is_init;
+  void *file;
+  void *retired_file;
+  uint32_t generation;
+  ChunkLoad loads[STREAM_LOAD_SLOT_COUNT];
+
+  bool is_reload_queued;
+  WorldReloadStage reload_stage;
+  volatile int32_t reload_status;
+  WorldFileHeader reload_header;
+  WorldFileChunk reload_directory[WORLD_MAX_CHUNK_COUNT];
+};
+
+// Inclusive chunk bounds.
+struct ChunkRect {
+  int32_t min_x;
+  int32_t min_y;
+  int32_t max_x;
+  int32_t max_y;
+};
+
+// The world hash is the source of truth for residency; the resident list only
+// exists so eviction does not have to walk every slot. resident_hashes holds
+// the hash of the tiles each resident chunk actually has, so a chunk is stale
+// whenever it differs from its directory entry, however many reloads ago the
+// file changed.
+struct ChunkStreamer {
+  bool is_enabled;
+  WorldFileChunk *directory;
+  uint32_t directory_count;
+  uint32_t *resident;
+  uint32_t *resident_hashes;
+  uint32_t resident_count;
+
+  bool has_camera;
+  float camera_x;
+  float camera_y;
+  float vel_x;
+  float vel_y;
+  ChunkRect keep_rect;
+
+  GameStreamStats stats;
+};
+
+bool WriteWorldFile(World *world, PlatformApi *platform, MemoryArena *scratch,
+                    const char *file_name);
+bool InitChunkStreamer(ChunkStreamer *streamer, MemoryArena *arena,
+                       PlatformApi *platform, const char *file_name);
+int32_t FindWorldFileChunk(ChunkStreamer *streamer, int32_t chunk_x,
+                           int32_t chunk_y);
+bool IsChunkStreamed(ChunkStreamer *streamer, int32_t chunk_x,
+                     int32_t chunk_y);
+void EvictAllChunks(ChunkStreamer *streamer, World *world);
+void ReloadWorldFile(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                     PlatformApi *platform, const char *file_name);
+void UpdateChunkStreamer(ChunkStreamer *streamer, ChunkLoadQueue *queue,
+                         World *world, PlatformApi *platform,
+                         const char *file_name, float camera_x,
+                         float camera_y, float view_width, float view_height,
+                         float dt);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_STREAM_H_
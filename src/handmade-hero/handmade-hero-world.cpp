@@ -0,0 +1,201 @@
+#include "../../src/handmade-hero/handmade-hero-world.h"
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static inline uint32_t HashChunkPosition(int32_t chunk_x, int32_t chunk_y) {
+  uint32_t hash = static_cast<uint32_t>(chunk_x) * 0x9E3779B1u ^
+                  static_cast<uint32_t>(chunk_y) * 0x85EBCA77u;
+  hash ^= hash >> 15;
+  return hash & (WORLD_CHUNK_SLOT_COUNT - 1);
+}
+
+static inline uint32_t FindChunkSlot(World *world, int32_t chunk_x,
+                                     int32_t chunk_y) {
+  uint32_t slot_idx = HashChunkPosition(chunk_x, chunk_y);
+  for (;;) {
+    TileChunkSlot *slot = &world->slots[slot_idx];
+    if (slot->chunk_idx == WORLD_NULL_CHUNK ||
+        (slot->chunk_x == chunk_x && slot->chunk_y == chunk_y)) {
+      return slot_idx;
+    }
+    slot_idx = (slot_idx + 1) & (WORLD_CHUNK_SLOT_COUNT - 1);
+  }
+}
+
+void InitWorld(World *world, MemoryArena *arena) {
+  static_assert((WORLD_CHUNK_SLOT_COUNT & (WORLD_CHUNK_SLOT_COUNT - 1)) == 0,
+                "Chunk slot count must be a power of two");
+
+  world->slots = PushArray(arena, WORLD_CHUNK_SLOT_COUNT, TileChunkSlot);
+  world->chunks = PushArray(arena, WORLD_MAX_CHUNK_COUNT, TileChunk);
+  world->chunk_count = WORLD_MAX_CHUNK_COUNT;
+  world->used_chunk_count = 0;
+  world->first_free_chunk = WORLD_NULL_CHUNK;
+  world->version = 0;
+
+  for (uint32_t i = 0; i < WORLD_CHUNK_SLOT_COUNT; ++i) {
+    world->slots[i].chunk_idx = WORLD_NULL_CHUNK;
+  }
+}
+
+TilePosition GetTilePosition(int32_t abs_tile_x, int32_t abs_tile_y) {
+  TilePosition result = {};
+  result.chunk_x = abs_tile_x >> TILE_CHUNK_SHIFT;
+  result.chunk_y = abs_tile_y >> TILE_CHUNK_SHIFT;
+  result.tile_x = abs_tile_x & TILE_CHUNK_MASK;
+  result.tile_y = abs_tile_y & TILE_CHUNK_MASK;
+  return result;
+}
+
+TileChunk *GetTileChunk(World *world, int32_t chunk_x, int32_t chunk_y) {
+  TileChunkSlot *slot = &world->slots[FindChunkSlot(world, chunk_x, chunk_y)];
+  TileChunk *result = 0;
+  if (slot->chunk_idx != WORLD_NULL_CHUNK) {
+    result = &world->chunks[slot->chunk_idx];
+  }
+  return result;
+}
+
+TileChunk *GetOrCreateTileChunk(World *world, int32_t chunk_x,
+                                int32_t chunk_y) {
+  TileChunkSlot *slot = &world->slots[FindChunkSlot(world, chunk_x, chunk_y)];
+  if (slot->chunk_idx != WORLD_NULL_CHUNK) {
+    return &world->chunks[slot->chunk_idx];
+  }
+
+  uint32_t chunk_idx = world->first_free_chunk;
+  if (chunk_idx != WORLD_NULL_CHUNK) {
+    world->first_free_chunk = world->chunks[chunk_idx].next_free;
+  } else if (world->used_chunk_count < world->chunk_count) {
+    chunk_idx = world->used_chunk_count++;
+  } else {
+    return 0;
+  }
+
+  TileChunk *result = &world->chunks[chunk_idx];
+  *result = {};
+  result->chunk_x = chunk_x;
+  result->chunk_y = chunk_y;
+  result->next_free = WORLD_NULL_CHUNK;
+
+  slot->chunk_x = chunk_x;
+  slot->chunk_y = chunk_y;
+  slot->chunk_idx = chunk_idx;
+
+  return result;
+}
+
+bool RemoveTileChunk(World *world, int32_t chunk_x, int32_t chunk_y) {
+  uint32_t hole_idx = FindChunkSlot(world, chunk_x, chunk_y);
+  TileChunkSlot *hole = &world->slots[hole_idx];
+  if (hole->chunk_idx == WORLD_NULL_CHUNK) {
+    return false;
+  }
+
+  TileChunk *chunk = &world->chunks[hole->chunk_idx];
+  chunk->next_free = world->first_free_chunk;
+  world->first_free_chunk = hole->chunk_idx;
+
+  // Backward-shift deletion keeps probe sequences intact without tombstones.
+  uint32_t mask = WORLD_CHUNK_SLOT_COUNT - 1;
+  uint32_t next_idx = (hole_idx + 1) & mask;
+  while (world->slots[next_idx].chunk_idx != WORLD_NULL_CHUNK) {
+    TileChunkSlot *next = &world->slots[next_idx];
+    uint32_t home_idx = HashChunkPosition(next->chunk_x, next->chunk_y);
+    if (((next_idx - home_idx) & mask) >= ((next_idx - hole_idx) & mask)) {
+      world->slots[hole_idx] = *next;
+      hole_idx = next_idx;
+    }
+    next_idx = (next_idx + 1) & mask;
+  }
+  world->slots[hole_idx].chunk_idx = WORLD_NULL_CHUNK;
+
+  return true;
+}
+
+uint32_t GetTileValue(World *world, int32_t abs_tile_x, int32_t abs_tile_y) {
+  TilePosition position = GetTilePosition(abs_tile_x, abs_tile_y);
+  TileChunk *chunk = GetTileChunk(world, position.chunk_x, position.chunk_y);
+  uint32_t result = 0;
+  if (chunk) {
+    result = chunk->tiles[position.tile_y * TILE_CHUNK_DIM + position.tile_x];
+  }
+  return result;
+}
+
+bool SetTileValue(World *world, int32_t abs_tile_x, int32_t abs_tile_y,
+                  uint32_t value) {
+  TilePosition position = GetTilePosition(abs_tile_x, abs_tile_y);
+  TileChunk *chunk = value
+                         ? GetOrCreateTileChunk(world, position.chunk_x,
+                                                position.chunk_y)
+                         : GetTileChunk(world, position.chunk_x,
+                                        position.chunk_y);
+  if (!chunk) {
+    return value == 0;
+  }
+
+  uint32_t *tile =
+      &chunk->tiles[position.tile_y * TILE_CHUNK_DIM + position.tile_x];
+  if (*tile != value) {
+    MarkWorldChanged(world, abs_tile_x, abs_tile_y, abs_tile_x, abs_tile_y);
+  }
+  if (*tile && !value) {
+    --chunk->tile_count;
+  } else if (!*tile && value) {
+    ++chunk->tile_count;
+  }
+  *tile = value;
+
+  // Chunks only exist where something is populated.
+  if (chunk->tile_count == 0) {
+    RemoveTileChunk(world, position.chunk_x, position.chunk_y);
+  }
+
+  return true;
+}
+
+void MarkWorldChanged(World *world, int32_t min_tile_x, int32_t min_tile_y,
+                      int32_t max_tile_x, int32_t max_tile_y) {
+  uint32_t version = ++world->version;
+  WorldChange *change = &world->changes[version % WORLD_CHANGE_LOG_COUNT];
+  change->version = version;
+  change->min_tile_x = min_tile_x;
+  change->min_tile_y = min_tile_y;
+  change->max_tile_x = max_tile_x;
+  change->max_tile_y = max_tile_y;
+}
+
+void MarkTileChunkChanged(World *world, int32_t chunk_x, int32_t chunk_y) {
+  int32_t min_tile_x = chunk_x * TILE_CHUNK_DIM;
+  int32_t min_tile_y = chunk_y * TILE_CHUNK_DIM;
+  MarkWorldChanged(world, min_tile_x, min_tile_y,
+                   min_tile_x + TILE_CHUNK_MASK, min_tile_y + TILE_CHUNK_MASK);
+}
+
+// Conservative: a version the log no longer reaches back to, or one from the
+// future after a save state was restored, counts as changed everywhere.
+bool HasWorldChanged(World *world, uint32_t since_version, int32_t min_tile_x,
+                     int32_t min_tile_y, int32_t max_tile_x,
+                     int32_t max_tile_y) {
+  if (since_version == world->version) {
+    return false;
+  }
+  if (since_version > world->version ||
+      world->version - since_version > WORLD_CHANGE_LOG_COUNT) {
+    return true;
+  }
+
+  for (uint32_t version = since_version + 1; version <= world->version;
+       ++version) {
+    WorldChange *change = &world->changes[version % WORLD_CHANGE_LOG_COUNT];
+    if (change->min_tile_x <= max_tile_x && change->max_tile_x >= min_tile_x &&
+        change->min_tile_y <= max_tile_y && change->max_tile_y >= min_tile_y) {
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,86 @@
+#ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_WORLD_H_
+#define SRC_HANDMADE_HERO_HANDMADE_HERO_WORLD_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const int TILE_CHUNK_SHIFT = 4;
+static const int TILE_CHUNK_DIM = 1 << TILE_CHUNK_SHIFT;
+static const int TILE_CHUNK_MASK = TILE_CHUNK_DIM - 1;
+static const uint32_t WORLD_MAX_CHUNK_COUNT = 8192;
+static const uint32_t WORLD_CHUNK_SLOT_COUNT = 2 * WORLD_MAX_CHUNK_COUNT;
+static const uint32_t WORLD_NULL_CHUNK = 0xFFFFFFFF;
+static const uint32_t WORLD_CHANGE_LOG_COUNT = 64;
+
+enum TileValue {
+  TILE_VALUE_EMPTY,
+  TILE_VALUE_FLOOR,
+  TILE_VALUE_WALL,
+};
+
+struct TileChunk {
+  int32_t chunk_x;
+  int32_t chunk_y;
+  uint32_t next_free;
+  uint32_t tile_count;
+  uint32_t tiles[TILE_CHUNK_DIM * TILE_CHUNK_DIM];
+};
+
+// Slots keep the chunk coordinates inline so probing never touches chunk
+// memory until the key matches.
+struct TileChunkSlot {
+  int32_t chunk_x;
+  int32_t chunk_y;
+  uint32_t chunk_idx;
+};
+
+// Inclusive tile bounds of one edit.
+struct WorldChange {
+  uint32_t version;
+  int32_t min_tile_x;
+  int32_t min_tile_y;
+  int32_t max_tile_x;
+  int32_t max_tile_y;
+};
+
+// Every edit bumps version and lands in a ring, so caches built from the
+// tiles can tell whether an edit since they were built touched their region.
+// Adding or removing a chunk is not an edit by itself: streaming moves chunks
+// in and out without changing their tiles, so callers that do change tiles
+// record it.
+struct World {
+  TileChunkSlot *slots;
+  TileChunk *chunks;
+  uint32_t chunk_count;
+  uint32_t used_chunk_count;
+  uint32_t first_free_chunk;
+
+  uint32_t version;
+  WorldChange changes[WORLD_CHANGE_LOG_COUNT];
+};
+
+struct TilePosition {
+  int32_t chunk_x;
+  int32_t chunk_y;
+  int32_t tile_x;
+  int32_t tile_y;
+};
+
+void InitWorld(World *world, MemoryArena *arena);
+TilePosition GetTilePosition(int32_t abs_tile_x, int32_t abs_tile_y);
+TileChunk *GetTileChunk(World *world, int32_t chunk_x, int32_t chunk_y);
+TileChunk *GetOrCreateTileChunk(World *world, int32_t chunk_x,
+                                int32_t chunk_y);
+bool RemoveTileChunk(World *world, int32_t chunk_x, int32_t chunk_y);
+uint32_t GetTileValue(World *world, int32_t abs_tile_x, int32_t abs_tile_y);
+bool SetTileValue(World *world, int32_t abs_tile_x, int32_t abs_tile_y,
+                  uint32_t value);
+void MarkWorldChanged(World *world, int32_t min_tile_x, int32_t min_tile_y,
+                      int32_t max_tile_x, int32_t max_tile_y);
+void MarkTileChunkChanged(World *world, int32_t chunk_x, int32_t chunk_y);
+bool HasWorldChanged(World *world, uint32_t since_version, int32_t min_tile_x,
+                     int32_t min_tile_y, int32_t max_tile_x,
+                     int32_t max_tile_y);
+
+#endif  // SRC_HANDMADE_HERO_HANDMADE_HERO_WORLD_H_
@@ -2,9 +2,51 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/handmade-hero/handmade-hero-collision.h"
+#include "../../src/handmade-hero/handmade-hero-entity.h"
+#include "../../src/handmade-hero/handmade-hero-flow.h"
+#include "../../src/handmade-hero/handmade-hero-music.h"
+#include "../../src/handmade-hero/handmade-hero-particle.h"
+#include "../../src/handmade-hero/handmade-hero-pixel.h"
+#include "../../src/handmade-hero/handmade-hero-sprite.h"
+#include "../../src/handmade-hero/handmade-hero-stream.h"
+#include "../../src/handmade-hero/handmade-hero-world.h"
 
 #define PI 3.14159265359f
 
+static const int TILE_SIZE_PIXELS = 32;
+static const int ROOM_WIDTH = 17;
+static const int ROOM_HEIGHT = 9;
+static const int ROOM_COUNT_X = 8;
+static const int ROOM_COUNT_Y = 8;
+static const uint32_t ENTITY_CAPACITY = 32768;
+static const int ENTITY_SPAWN_COUNT_PER_ROOM = 256;
+static const float ENTITY_MAX_SPEED = 4.0f;
+static const int ENTITY_SEEKER_INTERVAL = 4;
+static const float ENTITY_SEEK_SPEED = 3.0f;
+static const float HIGH_FREQUENCY_MARGIN = 16.0f;
+static const int PARTICLE_EMITTER_COUNT = 4;
+static const float PARTICLE_GRAVITY = 9.8f;
+static const BlendSpace PARTICLE_BLEND_SPACE = BLEND_SPACE_LINEAR;
+static const int MARKER_TEXTURE_DIM = 32;
+static const float MARKER_SIZE_TILES = 2.5f;
+static const float MARKER_SPIN_RATE = 1.5f;
+static const int MUSIC_LOOP_SECONDS = 8;
+static const int MUSIC_NOTES_PER_SECOND = 6;
+static const float MUSIC_VOLUME = 0.5f;
+
+// State that must outlive a frame but not a save state sits in front of the
+// per-frame arena. Reads in flight land in the load queues, and flow fields
+// stay cached until the tiles under them change.
+struct TransientState {
+  ChunkLoadQueue load_queue;
+  MusicLoadQueue music_queue;
+  FlowFieldCache flow_cache;
+};
+
 ControllerInput *GetController(GameInput *input, int controller_idx) {
   Assert(controller_idx >= 0);
   Assert(controller_idx < ArraySize(input->controllers));
@@ -12,34 +54,235 @@ ControllerInput *GetController(GameInput *input, int controller_idx) {
   return result;
 }
 
-static void Render(GameBuffer *buffer, GameState *state) {
-  uint8_t *row = reinterpret_cast<uint8_t *>(buffer->memory);
-  for (int y = 0; y < buffer->height; ++y) {
-    uint32_t *pixel = reinterpret_cast<uint32_t *>(row);
-    for (int x = 0; x < buffer->width; ++x) {
-      // uint8_t red = static_cast<uint8_t>(x + state->x_offset);
-      // uint8_t green = 0;
-      // uint8_t blue = static_cast<uint8_t>(y + state->y_offset);
-      // *pixel++ = (red << 16) | (green << 8) | blue;
-
-      *pixel++ = (uint32_t)(0);
+void Render(GameBuffer *buffer, GameState *state) {
+  ClearBuffer(buffer, 0);
+}
+
+static inline int FloorDivide(int value, int divisor) {
+  int result = value / divisor;
+  if ((value % divisor) != 0 && value < 0) {
+    --result;
+  }
+  return result;
+}
+
+static void RenderWorld(GameBuffer *buffer, World *world, int camera_x,
+                        int camera_y) {
+  int min_tile_x = FloorDivide(camera_x, TILE_SIZE_PIXELS);
+  int min_tile_y = FloorDivide(camera_y, TILE_SIZE_PIXELS);
+  int max_tile_x = FloorDivide(camera_x + buffer->width, TILE_SIZE_PIXELS);
+  int max_tile_y = FloorDivide(camera_y + buffer->height, TILE_SIZE_PIXELS);
+
+  for (int tile_y = min_tile_y; tile_y <= max_tile_y; ++tile_y) {
+    for (int tile_x = min_tile_x; tile_x <= max_tile_x; ++tile_x) {
+      uint32_t tile_value = GetTileValue(world, tile_x, tile_y);
+      if (tile_value == TILE_VALUE_EMPTY) {
+        continue;
+      }
+
+      uint32_t color = tile_value == TILE_VALUE_WALL ? 0xFF808080 : 0xFF303030;
+      int min_x = tile_x * TILE_SIZE_PIXELS - camera_x;
+      int min_y = tile_y * TILE_SIZE_PIXELS - camera_y;
+      FillRectangle(buffer, min_x, min_y, min_x + TILE_SIZE_PIXELS,
+                    min_y + TILE_SIZE_PIXELS, color);
     }
-    row += buffer->pitch;
   }
 }
 
-static void OutputGameSound(GameSoundBuffer *sound_buffer, GameState *state) {
-  int16_t *samples = sound_buffer->samples;
-  uint16_t tone_volume = 3000;
+static void RenderEntities(GameBuffer *buffer, EntityStorage *storage,
+                           int camera_x, int camera_y) {
+  EntitySet *set = &storage->sets[ENTITY_SET_HIGH];
+  for (uint32_t i = 0; i < set->count; ++i) {
+    EntityCold *cold = &storage->cold[set->slot_idx[i]];
+    int min_x = static_cast<int>(set->pos_x[i] * TILE_SIZE_PIXELS) - camera_x;
+    int min_y = static_cast<int>(set->pos_y[i] * TILE_SIZE_PIXELS) - camera_y;
+    int width = static_cast<int>(cold->width * TILE_SIZE_PIXELS);
+    int height = static_cast<int>(cold->height * TILE_SIZE_PIXELS);
+    FillRectangle(buffer, min_x, min_y, min_x + width, min_y + height,
+                  cold->color);
+  }
+}
+
+// Emitters are marked with a spinning, tinted sprite.
+static void RenderEmitterMarkers(GameBuffer *buffer, GameState *state,
+                                 int camera_x, int camera_y) {
+  float size = MARKER_SIZE_TILES * TILE_SIZE_PIXELS;
+  for (int i = 0; i < state->emitter_count; ++i) {
+    ParticleEmitter *emitter = &state->emitters[i];
+    SpriteBasis basis = MakeSpriteBasis(
+        emitter->pos_x * TILE_SIZE_PIXELS - camera_x,
+        emitter->pos_y * TILE_SIZE_PIXELS - camera_y, size, size,
+        state->marker_angle + i * 0.25f * PI);
+    uint32_t color = 0xFF000000 |
+                     (static_cast<uint32_t>(emitter->color_r * 255.0f) << 16) |
+                     (static_cast<uint32_t>(emitter->color_g * 255.0f) << 8) |
+                     static_cast<uint32_t>(emitter->color_b * 255.0f);
+    DrawSprite(buffer, state->marker_texture, &basis, color, 0, 0,
+               buffer->width, buffer->height);
+  }
+}
+
+static void SpawnEntities(EntityStorage *storage, uint32_t *random_state) {
+  EntityCold cold = {};
+  cold.width = 0.25f;
+  cold.height = 0.25f;
+  cold.color = 0xFFFFC040;
+
+  for (int room_y = 0; room_y < ROOM_COUNT_Y; ++room_y) {
+    for (int room_x = 0; room_x < ROOM_COUNT_X; ++room_x) {
+      float base_x = static_cast<float>(room_x * ROOM_WIDTH * 4 + 1);
+      float base_y = static_cast<float>(room_y * ROOM_HEIGHT * 4 + 1);
+      for (int i = 0; i < ENTITY_SPAWN_COUNT_PER_ROOM; ++i) {
+        float x = base_x + RandomUnilateral(random_state) * (ROOM_WIDTH - 3);
+        float y = base_y + RandomUnilateral(random_state) * (ROOM_HEIGHT - 3);
+        float vel_x = RandomBilateral(random_state) * ENTITY_MAX_SPEED;
+        float vel_y = RandomBilateral(random_state) * ENTITY_MAX_SPEED;
+        uint32_t flags = ENTITY_FLAG_MOVES | ENTITY_FLAG_COLLIDES;
+        if (i % ENTITY_SEEKER_INTERVAL == 0) {
+          flags |= ENTITY_FLAG_SEEKS_GOAL;
+        }
+        AddEntity(storage, &cold, x, y, vel_x, vel_y, flags);
+      }
+    }
+  }
+}
+
+static void PlaceEmitters(ParticleEmitter *emitters, int emitter_count) {
+  for (int i = 0; i < emitter_count; ++i) {
+    int room_x = i % 2;
+    int room_y = i / 2;
+
+    ParticleEmitter *emitter = &emitters[i];
+    *emitter = {};
+    emitter->pos_x = room_x * ROOM_WIDTH * 4 + 0.5f * ROOM_WIDTH;
+    emitter->pos_y = room_y * ROOM_HEIGHT * 4 + 0.5f * ROOM_HEIGHT;
+    emitter->spawn_rate = 4000.0f;
+    emitter->speed = 8.0f;
+    emitter->lifetime = 1.5f;
+    emitter->color_r = 1.0f;
+    emitter->color_g = 0.25f + 0.25f * i;
+    emitter->color_b = 0.1f;
+  }
+}
+
+// Seekers head for the nearest emitter whose flow field covers them. Every
+// seeker shares one cached field per emitter, so the cost per agent is a
+// lookup rather than a path search.
+static void SteerEntities(EntitySet *set, FlowFieldCache *cache, World *world,
+                          ChunkStreamer *streamer, ParticleEmitter *emitters,
+                          int emitter_count) {
+  FlowField *fields[PARTICLE_EMITTER_COUNT] = {};
+  for (int i = 0; i < emitter_count; ++i) {
+    fields[i] = GetFlowField(cache, world, streamer,
+                             static_cast<int32_t>(floorf(emitters[i].pos_x)),
+                             static_cast<int32_t>(floorf(emitters[i].pos_y)));
+  }
+
+  for (uint32_t i = 0; i < set->count; ++i) {
+    if (!(set->flags[i] & ENTITY_FLAG_SEEKS_GOAL)) {
+      continue;
+    }
+
+    float best_distance_sq = 0.0f;
+    for (int goal_idx = 0; goal_idx < emitter_count; ++goal_idx) {
+      float dir_x = 0.0f;
+      float dir_y = 0.0f;
+      if (!fields[goal_idx] || !GetFlowDirection(fields[goal_idx],
+                                                 set->pos_x[i], set->pos_y[i],
+                                                 &dir_x, &dir_y)) {
+        continue;
+      }
+
+      float dx = emitters[goal_idx].pos_x - set->pos_x[i];
+      float dy = emitters[goal_idx].pos_y - set->pos_y[i];
+      float distance_sq = dx * dx + dy * dy;
+      if (best_distance_sq == 0.0f || distance_sq < best_distance_sq) {
+        best_distance_sq = distance_sq;
+        set->vel_x[i] = dir_x * ENTITY_SEEK_SPEED;
+        set->vel_y[i] = dir_y * ENTITY_SEEK_SPEED;
+      }
+    }
+  }
+}
+
+static void GenerateWorld(World *world) {
+  for (int room_y = 0; room_y < ROOM_COUNT_Y; ++room_y) {
+    for (int room_x = 0; room_x < ROOM_COUNT_X; ++room_x) {
+      // Rooms are spread far apart so the world stays sparse.
+      int base_x = room_x * ROOM_WIDTH * 4;
+      int base_y = room_y * ROOM_HEIGHT * 4;
+      for (int y = 0; y < ROOM_HEIGHT; ++y) {
+        for (int x = 0; x < ROOM_WIDTH; ++x) {
+          bool is_door = x == ROOM_WIDTH / 2 || y == ROOM_HEIGHT / 2;
+          bool is_wall = x == 0 || y == 0 || x == ROOM_WIDTH - 1 ||
+                         y == ROOM_HEIGHT - 1;
+          uint32_t value =
+              (is_wall && !is_door) ? TILE_VALUE_WALL : TILE_VALUE_FLOOR;
+          SetTileValue(world, base_x + x, base_y + y, value);
+        }
+      }
+    }
+  }
+}
+
+// A pentatonic arpeggio stands in for real music until there is some to
+// encode. Each note is a decaying sine with a soft octave, panned left and
+// right in turn.
+static void SynthesizeMusic(int16_t *samples, uint32_t frame_count,
+                            int samples_per_second) {
+  static const float NOTE_HZ[] = {220.0f, 261.63f, 293.66f, 329.63f,
+                                  392.0f, 440.0f,  523.25f, 587.33f};
+  static const int NOTE_SEQUENCE[] = {0, 2, 4, 7, 5, 3, 6, 1,
+                                      0, 4, 2, 5, 7, 6, 3, 4};
+  uint32_t note_frames =
+      static_cast<uint32_t>(samples_per_second / MUSIC_NOTES_PER_SECOND);
+  for (uint32_t frame = 0; frame < frame_count; ++frame) {
+    uint32_t note_idx = frame / note_frames;
+    float hz = NOTE_HZ[NOTE_SEQUENCE[note_idx % ArraySize(NOTE_SEQUENCE)]];
+    float t = static_cast<float>(frame % note_frames) / samples_per_second;
+    float phase = 2.0f * PI * hz * t;
+    float value = (sinf(phase) + 0.3f * sinf(2.0f * phase)) * expf(-6.0f * t);
+    float pan = (note_idx % 2) ? 0.75f : 0.25f;
+    samples[2 * frame] = static_cast<int16_t>(value * (1.0f - pan) * 12000.0f);
+    samples[2 * frame + 1] = static_cast<int16_t>(value * pan * 12000.0f);
+  }
+}
+
+// Bakes the stand-in music to disk the first time, so it streams through the
+// same path as encoded tracks.
+static bool BakeMusicFile(PlatformApi *platform, MemoryArena *scratch,
+                          int samples_per_second) {
+  if (!platform->WriteEntireFile || samples_per_second <= 0) {
+    return false;
+  }
+
+  uint32_t frame_count =
+      static_cast<uint32_t>(samples_per_second * MUSIC_LOOP_SECONDS);
+  int16_t *samples = PushArray(scratch, frame_count * 2, int16_t);
+  uint32_t file_size = GetMusicFileSize(frame_count);
+  uint8_t *file = PushArray(scratch, file_size, uint8_t);
+  SynthesizeMusic(samples, frame_count, samples_per_second);
+
+  bool result =
+      EncodeMusic(samples, frame_count, 2, samples_per_second, file,
+                  file_size) &&
+      platform->WriteEntireFile(MUSIC_FILE_NAME, file_size, file);
+  return result;
+}
+
+void OutputGameSound(GameSoundBuffer *sound_buffer, GameState *state) {
+  float *left_samples = sound_buffer->left_samples;
+  float *right_samples = sound_buffer->right_samples;
+  float tone_volume = 3000.0f / 32767.0f;
 
   sound_buffer->wave_period =
       static_cast<float>(sound_buffer->samples_per_second) / state->tone_hz;
 
   for (int i = 0; i < sound_buffer->sample_count; ++i) {
     float sin_value = sinf(state->t_sin);
-    int16_t sample_value = (int16_t)(sin_value * tone_volume);
-    *samples++ = sample_value;
-    *samples++ = sample_value;
+    float sample_value = sin_value * tone_volume;
+    *left_samples++ = sample_value;
+    *right_samples++ = sample_value;
 
     state->t_sin += 2.0f * PI * 1.0f / sound_buffer->wave_period;
   }
@@ -48,9 +291,85 @@ static void OutputGameSound(GameSoundBuffer *sound_buffer, GameState *state) {
 void UpdateAndRender(GameMemory *memory, GameBuffer *buffer,
                      GameSoundBuffer *sound_buffer, GameInput *input) {
   GameState *state = static_cast<GameState *>(memory->permanent_storage);
+
+  TransientState *transient =
+      static_cast<TransientState *>(memory->transient_storage);
+  ChunkLoadQueue *load_queue = &transient->load_queue;
+  size_t transient_state_size =
+      (sizeof(TransientState) + 15) & ~static_cast<size_t>(15);
+  size_t frame_size = static_cast<size_t>(memory->transient_storage_size) -
+                      transient_state_size;
+  uint8_t *frame_base = reinterpret_cast<uint8_t *>(memory->transient_storage) +
+                        transient_state_size;
+
   if (!memory->is_init) {
     state->t_sin = 0.0f;
     state->tone_hz = 256;
+    InitSRGBTables();
+
+    InitArena(&state->world_arena,
+              memory->permanent_storage_size - sizeof(GameState),
+              reinterpret_cast<uint8_t *>(memory->permanent_storage) +
+                  sizeof(GameState));
+    SetArenaTag(&state->world_arena, MEMORY_TAG_WORLD);
+    state->world = PushStruct(&state->world_arena, World);
+    InitWorld(state->world, &state->world_arena);
+
+    // The world is baked to disk on first run and streamed from then on. If
+    // the file cannot be written either, the whole world stays resident.
+    SetArenaTag(&state->world_arena, MEMORY_TAG_STREAM);
+    state->streamer = PushStruct(&state->world_arena, ChunkStreamer);
+    if (!InitChunkStreamer(state->streamer, &state->world_arena,
+                           &memory->platform, WORLD_FILE_NAME)) {
+      GenerateWorld(state->world);
+      MemoryArena bake_arena = {};
+      InitArena(&bake_arena, frame_size, frame_base);
+      if (WriteWorldFile(state->world, &memory->platform, &bake_arena,
+                         WORLD_FILE_NAME) &&
+          InitChunkStreamer(state->streamer, &state->world_arena,
+                            &memory->platform, WORLD_FILE_NAME)) {
+        EvictAllChunks(state->streamer, state->world);
+      }
+    }
+
+    state->music = PushStruct(&state->world_arena, MusicPlayer);
+    *state->music = {};
+    state->music->volume = MUSIC_VOLUME;
+    void *music_file = memory->platform.OpenFile
+                           ? memory->platform.OpenFile(MUSIC_FILE_NAME)
+                           : 0;
+    if (music_file) {
+      memory->platform.CloseFile(music_file);
+    } else {
+      MemoryArena bake_arena = {};
+      InitArena(&bake_arena, frame_size, frame_base);
+      BakeMusicFile(&memory->platform, &bake_arena,
+                    sound_buffer->samples_per_second);
+    }
+
+    state->random_state = 0x2545F491;
+    SetArenaTag(&state->world_arena, MEMORY_TAG_ENTITY);
+    state->entities = PushStruct(&state->world_arena, EntityStorage);
+    InitEntityStorage(state->entities, &state->world_arena, ENTITY_CAPACITY);
+    SpawnEntities(state->entities, &state->random_state);
+
+    SetArenaTag(&state->world_arena, MEMORY_TAG_PARTICLE);
+    state->particles = PushStruct(&state->world_arena, ParticleSystem);
+    InitParticleSystem(state->particles, &state->world_arena,
+                       PARTICLE_CAPACITY);
+    state->emitter_count = PARTICLE_EMITTER_COUNT;
+    state->emitters =
+        PushArray(&state->world_arena, state->emitter_count, ParticleEmitter);
+    PlaceEmitters(state->emitters, state->emitter_count);
+
+    state->marker_texture = PushStruct(&state->world_arena, GameBuffer);
+    *state->marker_texture = MakeGameBuffer(
+        PushArray(&state->world_arena,
+                  MARKER_TEXTURE_DIM * MARKER_TEXTURE_DIM, uint32_t),
+        MARKER_TEXTURE_DIM, MARKER_TEXTURE_DIM, PIXEL_FORMAT_BGRA8);
+    FillMarkerTexture(state->marker_texture, 0xFFFFFFFF);
+    state->marker_angle = 0.0f;
+
     memory->is_init = true;
   }
 
@@ -73,6 +392,73 @@ void UpdateAndRender(GameMemory *memory, GameBuffer *buffer,
     }
   }
 
+  int camera_x = -state->x_offset;
+  int camera_y = -state->y_offset;
+  float tile_scale = 1.0f / TILE_SIZE_PIXELS;
+
+  GameFileChanges *file_changes = &memory->file_changes;
+  for (int i = 0; i < file_changes->count; ++i) {
+    if (strcmp(file_changes->names[i], WORLD_FILE_NAME) == 0) {
+      ReloadWorldFile(state->streamer, load_queue, &memory->platform,
+                      WORLD_FILE_NAME);
+    }
+  }
+  if (file_changes->is_overflow) {
+    ReloadWorldFile(state->streamer, load_queue, &memory->platform,
+                    WORLD_FILE_NAME);
+  }
+
+  UpdateChunkStreamer(state->streamer, load_queue, state->world,
+                      &memory->platform, WORLD_FILE_NAME,
+                      camera_x * tile_scale, camera_y * tile_scale,
+                      buffer->width * tile_scale, buffer->height * tile_scale,
+                      input->dt_for_frame);
+
+  // Only entities around the camera are simulated each frame.
+  UpdateEntitySets(
+      state->entities, camera_x * tile_scale - HIGH_FREQUENCY_MARGIN,
+      camera_y * tile_scale - HIGH_FREQUENCY_MARGIN,
+      (camera_x + buffer->width) * tile_scale + HIGH_FREQUENCY_MARGIN,
+      (camera_y + buffer->height) * tile_scale + HIGH_FREQUENCY_MARGIN);
+
+  MemoryArena frame_arena = {};
+  InitArena(&frame_arena, frame_size, frame_base);
+  SetArenaTag(&frame_arena, MEMORY_TAG_COLLISION);
+  EntitySet *high_set = &state->entities->sets[ENTITY_SET_HIGH];
+  BeginFlowFieldFrame(&transient->flow_cache);
+  SteerEntities(high_set, &transient->flow_cache, state->world,
+                state->streamer, state->emitters, state->emitter_count);
+  ResolveEntityCollisions(state->entities, high_set, &frame_arena,
+                          input->dt_for_frame);
+  SimulateEntities(high_set, input->dt_for_frame);
+
+  for (int i = 0; i < state->emitter_count; ++i) {
+    EmitParticles(state->particles, &state->emitters[i], input->dt_for_frame,
+                  &state->random_state);
+  }
+  UpdateParticles(state->particles, input->dt_for_frame, PARTICLE_GRAVITY);
+  state->marker_angle += MARKER_SPIN_RATE * input->dt_for_frame;
+
+  UpdateMusicStream(state->music, &transient->music_queue, &memory->platform,
+                    MUSIC_FILE_NAME, sound_buffer->samples_per_second);
   OutputGameSound(sound_buffer, state);
+  MixMusic(state->music, &transient->music_queue, sound_buffer);
   Render(buffer, state);
+  RenderWorld(buffer, state->world, camera_x, camera_y);
+  RenderEntities(buffer, state->entities, camera_x, camera_y);
+  RenderEmitterMarkers(buffer, state, camera_x, camera_y);
+  DrawParticles(buffer, state->particles, camera_x, camera_y,
+                static_cast<float>(TILE_SIZE_PIXELS), PARTICLE_BLEND_SPACE);
+
+  GameMemoryUsage *usage = &memory->usage;
+  usage->permanent_used = sizeof(GameState) + state->world_arena.used;
+  usage->transient_used = transient_state_size + frame_arena.high_water;
+  for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+    usage->tag_sizes[i] =
+        state->world_arena.tag_sizes[i] + frame_arena.tag_sizes[i];
+  }
+  usage->tag_sizes[MEMORY_TAG_STREAM] +=
+      sizeof(ChunkLoadQueue) + sizeof(MusicLoadQueue);
+  usage->tag_sizes[MEMORY_TAG_FLOW] += sizeof(FlowFieldCache);
+  memory->stream_stats = state->streamer->stats;
 }
@@ -1,6 +1,7 @@
 #ifndef SRC_HANDMADE_HERO_HANDMADE_HERO_H_
 #define SRC_HANDMADE_HERO_HANDMADE_HERO_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include "../../src/win32/win32-handmade-hero.h"
@@ -20,6 +21,141 @@
 #define Gigabytes(value) (Megabytes(value) * 1024)
 #define Terabytes(value) (Gigabytes(value) * 1024)
 
+enum MemoryTag {
+  MEMORY_TAG_UNTAGGED,
+  MEMORY_TAG_WORLD,
+  MEMORY_TAG_ENTITY,
+  MEMORY_TAG_PARTICLE,
+  MEMORY_TAG_COLLISION,
+  MEMORY_TAG_STREAM,
+  MEMORY_TAG_FLOW,
+  MEMORY_TAG_COUNT,
+};
+
+// Every push is charged, alignment padding included, to the arena's current
+// tag.
+struct MemoryArena {
+  size_t size;
+  uint8_t *base;
+  size_t used;
+  size_t high_water;
+  MemoryTag tag;
+  size_t tag_sizes[MEMORY_TAG_COUNT];
+};
+
+inline void InitArena(MemoryArena *arena, size_t size, void *base) {
+  *arena = {};
+  arena->size = size;
+  arena->base = reinterpret_cast<uint8_t *>(base);
+}
+
+inline void SetArenaTag(MemoryArena *arena, MemoryTag tag) {
+  arena->tag = tag;
+}
+
+inline void *PushSize(MemoryArena *arena, size_t size) {
+  size_t aligned_used = (arena->used + 15) & ~static_cast<size_t>(15);
+  Assert(aligned_used + size <= arena->size);
+  void *result = arena->base + aligned_used;
+  arena->tag_sizes[arena->tag] += aligned_used + size - arena->used;
+  arena->used = aligned_used + size;
+  if (arena->used > arena->high_water) {
+    arena->high_water = arena->used;
+  }
+  return result;
+}
+
+#define PushStruct(arena, type) \
+  reinterpret_cast<type *>(PushSize(arena, sizeof(type)))
+#define PushArray(arena, count, type) \
+  reinterpret_cast<type *>(PushSize(arena, (count) * sizeof(type)))
+
+inline uint32_t NextRandom(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+inline float RandomUnilateral(uint32_t *state) {
+  float result = static_cast<float>(NextRandom(state) >> 8) / 16777216.0f;
+  return result;
+}
+
+inline float RandomBilateral(uint32_t *state) {
+  float result = 2.0f * RandomUnilateral(state) - 1.0f;
+  return result;
+}
+
+struct ChunkStreamer;
+struct EntityStorage;
+struct GameBuffer;
+struct MusicPlayer;
+struct ParticleEmitter;
+struct ParticleSystem;
+struct World;
+
+enum PlatformReadStatus {
+  PLATFORM_READ_IDLE,
+  PLATFORM_READ_PENDING,
+  PLATFORM_READ_DONE,
+  PLATFORM_READ_FAILED,
+};
+
+// Files are opaque platform handles. A queued read runs on a platform worker
+// thread and publishes PLATFORM_READ_DONE or PLATFORM_READ_FAILED to status
+// once dest is filled, so dest must stay untouched until then.
+typedef void *PlatformOpenFile(const char *file_name);
+typedef void PlatformCloseFile(void *file);
+typedef bool PlatformReadFile(void *file, uint64_t offset, uint32_t size,
+                              void *dest);
+typedef bool PlatformQueueRead(void *file, uint64_t offset, uint32_t size,
+                               void *dest, volatile int32_t *status);
+typedef bool PlatformWriteEntireFile(const char *file_name, uint32_t size,
+                                     void *memory);
+
+struct PlatformApi {
+  PlatformOpenFile *OpenFile;
+  PlatformCloseFile *CloseFile;
+  PlatformReadFile *ReadFile;
+  PlatformQueueRead *QueueRead;
+  PlatformWriteEntireFile *WriteEntireFile;
+};
+
+// Filled in by the game every frame so the platform can report it.
+struct GameMemoryUsage {
+  size_t permanent_used;
+  size_t transient_used;
+  size_t tag_sizes[MEMORY_TAG_COUNT];
+};
+
+static const int FILE_CHANGE_MAX_COUNT = 16;
+static const int FILE_CHANGE_MAX_NAME = 64;
+
+// Files under the working directory that changed on disk and have been quiet
+// since, as paths relative to it. is_overflow means notifications were lost
+// and any file may have changed.
+struct GameFileChanges {
+  int count;
+  bool is_overflow;
+  char names[FILE_CHANGE_MAX_COUNT][FILE_CHANGE_MAX_NAME];
+};
+
+struct GameStreamStats {
+  int64_t requested_count;
+  int64_t loaded_count;
+  int64_t evicted_count;
+  int64_t failed_count;
+  int64_t late_count;
+  int64_t missed_count;
+  int64_t reload_count;
+  int64_t refreshed_count;
+  uint32_t resident_count;
+  uint32_t in_flight_count;
+};
+
 struct GameMemory {
   bool is_init;
   uint64_t permanent_storage_size;
@@ -27,6 +163,11 @@ struct GameMemory {
 
   uint64_t transient_storage_size;
   void *transient_storage;
+
+  PlatformApi platform;
+  GameFileChanges file_changes;
+  GameMemoryUsage usage;
+  GameStreamStats stream_stats;
 };
 
 struct GameState {
@@ -34,6 +175,27 @@ struct GameState {
   int tone_hz;
   int x_offset = 0;
   int y_offset = 0;
+
+  MemoryArena world_arena;
+  World *world;
+  ChunkStreamer *streamer;
+  EntityStorage *entities;
+  ParticleSystem *particles;
+  ParticleEmitter *emitters;
+  int emitter_count;
+  uint32_t random_state;
+  GameBuffer *marker_texture;
+  float marker_angle;
+  MusicPlayer *music;
+};
+
+// Zero is BGRA8 so zero-initialized buffers keep the platform's format.
+enum PixelFormat {
+  PIXEL_FORMAT_BGRA8,
+  PIXEL_FORMAT_RGB565,
+  PIXEL_FORMAT_MASK8,
+  PIXEL_FORMAT_HDR,
+  PIXEL_FORMAT_COUNT,
 };
 
 struct GameBuffer {
@@ -42,13 +204,15 @@ struct GameBuffer {
   int height;
   int pitch;
   int bytes_per_pixel;
+  PixelFormat format;
 };
 
 struct GameSoundBuffer {
   int samples_per_second;
   int sample_count;
   float wave_period;
-  int16_t *samples;
+  float *left_samples;
+  float *right_samples;
 };
 
 struct ButtonState {
@@ -85,15 +249,15 @@ struct ControllerInput {
 };
 
 struct GameInput {
+  float dt_for_frame;
   ControllerInput controllers[5];
 };
 
 ControllerInput *GetController(GameInput *input, int controller_idx);
 
-static inline void Render(GameBuffer *buffer, GameState *state);
+void Render(GameBuffer *buffer, GameState *state);
 
-static inline void OutputGameSound(GameSoundBuffer *sound_buffer,
-                                   GameState *state);
+void OutputGameSound(GameSoundBuffer *sound_buffer, GameState *state);
 
 void UpdateAndRender(GameMemory *memory, GameBuffer *buffer,
                      GameSoundBuffer *sound_buffer, GameInput *input);
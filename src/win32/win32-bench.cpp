@@ -0,0 +1,576 @@
+#include "../../src/win32/win32-bench.h"
+
+#include <windows.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero-collision.h"
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/handmade-hero/handmade-hero-entity.h"
+#include "../../src/handmade-hero/handmade-hero-particle.h"
+#include "../../src/handmade-hero/handmade-hero-pixel.h"
+#include "../../src/handmade-hero/handmade-hero-sprite.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-capture.h"
+#include "../../src/win32/win32-display.h"
+#include "../../src/win32/win32-file-io.h"
+#include "../../src/win32/win32-handmade-hero.h"
+#include "../../src/win32/win32-hash.h"
+#include "../../src/win32/win32-input.h"
+#include "../../src/win32/win32-sound.h"
+#include "../../src/win32/win32-text.h"
+
+#if DEV
+static const int BENCH_SAMPLES_PER_SECOND = 48000;
+static const int BENCH_FPS = 30;
+static const int BENCH_JSON_SIZE = Kilobytes(32);
+static const size_t BENCH_ARENA_SIZE = Megabytes(64);
+static const uint32_t BENCH_COLLISION_ENTITY_COUNTS[BENCH_COLLISION_SET_COUNT] =
+    {1000, 10000, 100000};
+
+struct BenchEntry {
+  const char *name;
+  const char *unit;
+  int64_t units_per_run;
+  BenchKernel *kernel;
+};
+
+static double bench_ns[BENCH_REPETITION_COUNT];
+static double bench_cycles[BENCH_REPETITION_COUNT];
+static char bench_json[BENCH_JSON_SIZE];
+
+static int CompareDoubles(const void *a, const void *b) {
+  double left = *reinterpret_cast<const double *>(a);
+  double right = *reinterpret_cast<const double *>(b);
+  return (left < right) ? -1 : ((left > right) ? 1 : 0);
+}
+
+static inline double GetPercentile(double *sorted, int count,
+                                   double percentile) {
+  int idx = static_cast<int>(percentile * count + 0.999999) - 1;
+  if (idx < 0) {
+    idx = 0;
+  }
+  if (idx >= count) {
+    idx = count - 1;
+  }
+  return sorted[idx];
+}
+
+static GameBuffer GetGameBuffer(Buffer *buffer) {
+  GameBuffer result = {};
+  result.memory = buffer->memory;
+  result.width = buffer->width;
+  result.height = buffer->height;
+  result.pitch = buffer->pitch;
+  result.bytes_per_pixel = buffer->bytes_per_pixel;
+  result.format = PIXEL_FORMAT_BGRA8;
+  return result;
+}
+
+static void BenchRender(BenchContext *context) {
+  GameBuffer game_buffer = GetGameBuffer(&context->render_target);
+  Render(&game_buffer, &context->state);
+}
+
+static void BenchOutputGameSound(BenchContext *context) {
+  OutputGameSound(&context->sound_buffer, &context->state);
+}
+
+static void BenchConvertSoundSamples(BenchContext *context) {
+  ConvertSoundSamples(context->device_samples,
+                      context->sound_buffer.left_samples,
+                      context->sound_buffer.right_samples,
+                      context->sound_buffer.sample_count,
+                      context->sound_output.dither_state);
+}
+
+static void BenchClearSoundRegion(BenchContext *context) {
+  ClearSoundRegion(context->device_samples,
+                   static_cast<DWORD>(context->device_sample_count * 2 *
+                                      sizeof(int16_t)));
+}
+
+static void BenchDebugDrawVertical(BenchContext *context) {
+  Buffer *buffer = &context->render_target;
+  DebugDrawVertical(buffer, context->draw_x, 16, buffer->height - 16,
+                    0xFFFFFFFF);
+  context->draw_x = (context->draw_x + 1) % buffer->width;
+}
+
+static void BenchProcessXInputStickPosition(BenchContext *context) {
+  float sum = 0.0f;
+  for (int i = 0; i < BENCH_STICK_VALUE_COUNT; ++i) {
+    sum += ProcessXInputStickPosition(context->stick_values[i],
+                                      XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+  }
+  context->stick_sink = sum;
+}
+
+static void BenchUpscaleBilinear(BenchContext *context) {
+  UpscaleBuffer(&context->render_target, &context->present_buffer,
+                SCALE_FILTER_BILINEAR);
+}
+
+static void BenchUpscaleNearest(BenchContext *context) {
+  UpscaleBuffer(&context->render_target, &context->present_buffer,
+                SCALE_FILTER_NEAREST);
+}
+
+static void BenchConvertBGRAToI420(BenchContext *context) {
+  ConvertBGRAToI420(&context->render_target, context->capture_planes);
+}
+
+static void BenchHashGameBuffer(BenchContext *context) {
+  Buffer *buffer = &context->render_target;
+  context->hash_sink =
+      HashMemory(buffer->memory, buffer->pitch * buffer->height, 0);
+}
+
+static void BenchResolveCollisions(BenchContext *context, int set_idx) {
+  EntityStorage *storage = &context->collision_storage[set_idx];
+  context->frame_arena.used = 0;
+  context->collision_sink = ResolveEntityCollisions(
+      storage, &storage->sets[ENTITY_SET_HIGH], &context->frame_arena,
+      1.0f / BENCH_FPS);
+}
+
+static void BenchResolveCollisions1k(BenchContext *context) {
+  BenchResolveCollisions(context, 0);
+}
+
+static void BenchResolveCollisions10k(BenchContext *context) {
+  BenchResolveCollisions(context, 1);
+}
+
+static void BenchResolveCollisions100k(BenchContext *context) {
+  BenchResolveCollisions(context, 2);
+}
+
+static void BenchUpdateParticles(BenchContext *context) {
+  UpdateParticles(&context->particles, 1.0f / BENCH_FPS, 0.0f);
+}
+
+static void BenchDrawParticles(BenchContext *context) {
+  GameBuffer game_buffer = GetGameBuffer(&context->render_target);
+  DrawParticles(&game_buffer, &context->particles, 0, 0, 32.0f,
+                BLEND_SPACE_GAMMA);
+}
+
+static void BenchDrawParticlesLinear(BenchContext *context) {
+  GameBuffer game_buffer = GetGameBuffer(&context->render_target);
+  DrawParticles(&game_buffer, &context->particles, 0, 0, 32.0f,
+                BLEND_SPACE_LINEAR);
+}
+
+static void BenchBlendCoverage(BenchContext *context, BlendSpace blend_space) {
+  Buffer *buffer = &context->render_target;
+  uint8_t *row = reinterpret_cast<uint8_t *>(buffer->memory);
+  for (int y = 0; y < buffer->height; ++y) {
+    BlendCoverageSpan(reinterpret_cast<uint32_t *>(row),
+                      context->coverage + y * buffer->width, buffer->width,
+                      0xFFFFC080, blend_space);
+    row += buffer->pitch;
+  }
+}
+
+static void BenchBlendCoverageGamma(BenchContext *context) {
+  BenchBlendCoverage(context, BLEND_SPACE_GAMMA);
+}
+
+static void BenchBlendCoverageLinear(BenchContext *context) {
+  BenchBlendCoverage(context, BLEND_SPACE_LINEAR);
+}
+
+static void BenchClearFormat(BenchContext *context, PixelFormat format) {
+  ClearBuffer(&context->format_buffers[format], 0xFF336699);
+}
+
+static void BenchClearBGRA8(BenchContext *context) {
+  BenchClearFormat(context, PIXEL_FORMAT_BGRA8);
+}
+
+static void BenchClearRGB565(BenchContext *context) {
+  BenchClearFormat(context, PIXEL_FORMAT_RGB565);
+}
+
+static void BenchClearMask8(BenchContext *context) {
+  BenchClearFormat(context, PIXEL_FORMAT_MASK8);
+}
+
+static void BenchClearHDR(BenchContext *context) {
+  BenchClearFormat(context, PIXEL_FORMAT_HDR);
+}
+
+static void BenchConvertHDRToBGRA8(BenchContext *context) {
+  ConvertBuffer(&context->format_buffers[PIXEL_FORMAT_HDR],
+                &context->format_buffers[PIXEL_FORMAT_BGRA8]);
+}
+
+static void BenchConvertBGRA8ToRGB565(BenchContext *context) {
+  ConvertBuffer(&context->format_buffers[PIXEL_FORMAT_BGRA8],
+                &context->format_buffers[PIXEL_FORMAT_RGB565]);
+}
+
+static void BenchBlendMaskBGRA8(BenchContext *context) {
+  BlendMask(&context->format_buffers[PIXEL_FORMAT_BGRA8],
+            &context->coverage_mask, 0, 0, 0xFFFFC080);
+}
+
+static void BenchBlendMaskRGB565(BenchContext *context) {
+  BlendMask(&context->format_buffers[PIXEL_FORMAT_RGB565],
+            &context->coverage_mask, 0, 0, 0xFFFFC080);
+}
+
+// A rotated, non-uniformly scaled sprite in the middle of the target, so the
+// bounding box is about twice the covered area.
+static void BenchDrawSpriteKernel(BenchContext *context, bool is_reference) {
+  GameBuffer *dest = &context->format_buffers[PIXEL_FORMAT_BGRA8];
+  SpriteBasis basis =
+      MakeSpriteBasis(0.5f * dest->width, 0.5f * dest->height,
+                      BENCH_SPRITE_SIZE, 0.75f * BENCH_SPRITE_SIZE, 0.6f);
+  if (is_reference) {
+    DrawSpriteReference(dest, &context->sprite_texture, &basis, 0xFFFFFFFF, 0,
+                        0, dest->width, dest->height);
+  } else {
+    DrawSprite(dest, &context->sprite_texture, &basis, 0xFFFFFFFF, 0, 0,
+               dest->width, dest->height);
+  }
+}
+
+static void BenchDrawSprite(BenchContext *context) {
+  BenchDrawSpriteKernel(context, false);
+}
+
+static void BenchDrawSpriteReference(BenchContext *context) {
+  BenchDrawSpriteKernel(context, true);
+}
+
+static void BenchDrawDebugText(BenchContext *context) {
+  static const char *lines[] = {
+      " 16.67 ms/f    60.0 fps", "  4.21 ms present latency",
+      "render 1920x1080", " 0.012 ms overlay"};
+  int line_height = context->text_cache.atlas.glyph_height;
+  for (int i = 0; i < ArraySize(lines); ++i) {
+    DrawDebugText(&context->render_target, &context->text_cache, 8,
+                  8 + i * line_height, lines[i], 0xFFFFFFFF,
+                  BLEND_SPACE_LINEAR);
+  }
+}
+
+static void BenchLayoutText(BenchContext *context) {
+  char line[TEXT_MAX_LENGTH];
+  snprintf(line, sizeof(line), "%6.2f ms/f  %6.1f fps",
+           0.01f * context->text_counter, 1.0f * context->text_counter);
+  ++context->text_counter;
+  LayoutText(&context->text_cache, line);
+}
+
+// Fills the pool with long-lived, slow particles spread over the render
+// target so repeated runs keep the same count and visibility.
+static void SpawnBenchParticles(ParticleSystem *system, MemoryArena *arena,
+                                Buffer *render_target) {
+  InitParticleSystem(system, arena, PARTICLE_CAPACITY);
+
+  float width = render_target->width / 32.0f;
+  float height = render_target->height / 32.0f;
+  uint32_t random_state = 0x2545F491;
+  for (uint32_t i = 0; i < system->capacity; ++i) {
+    system->pos_x[i] = RandomUnilateral(&random_state) * width;
+    system->pos_y[i] = RandomUnilateral(&random_state) * height;
+    system->vel_x[i] = RandomBilateral(&random_state) * 0.01f;
+    system->vel_y[i] = RandomBilateral(&random_state) * 0.01f;
+    system->color_r[i] = RandomUnilateral(&random_state);
+    system->color_g[i] = RandomUnilateral(&random_state);
+    system->color_b[i] = RandomUnilateral(&random_state);
+    system->life[i] = 1.0e9f;
+    system->inv_lifetime[i] = 1.0e-9f;
+  }
+  system->count = system->capacity;
+}
+
+// Scatters entities at roughly one per square tile, the density of a busy
+// room, and makes them all high frequency.
+static void SpawnBenchEntities(EntityStorage *storage, MemoryArena *arena,
+                               uint32_t entity_count) {
+  InitEntityStorage(storage, arena, entity_count);
+
+  EntityCold cold = {};
+  cold.width = 0.25f;
+  cold.height = 0.25f;
+
+  float side = sqrtf(static_cast<float>(entity_count));
+  uint32_t random_state = 0x2545F491;
+  for (uint32_t i = 0; i < entity_count; ++i) {
+    float values[4];
+    for (int j = 0; j < 4; ++j) {
+      random_state = random_state * 1664525 + 1013904223;
+      values[j] = static_cast<float>(random_state >> 8) / 16777216.0f;
+    }
+    AddEntity(storage, &cold, values[0] * side, values[1] * side,
+              (values[2] - 0.5f) * 8.0f, (values[3] - 0.5f) * 8.0f,
+              ENTITY_FLAG_MOVES | ENTITY_FLAG_COLLIDES);
+  }
+
+  UpdateEntitySets(storage, -side, -side, 2.0f * side, 2.0f * side);
+}
+
+bool ParseBenchMode(char *command_line) {
+  bool result = command_line && strstr(command_line, "-bench") != 0;
+  return result;
+}
+
+BenchResult RunBenchmark(const char *name, const char *unit,
+                         int64_t units_per_run, BenchKernel *kernel,
+                         BenchContext *context, int64_t perf_count_frequency) {
+  for (int i = 0; i < BENCH_WARMUP_COUNT; ++i) {
+    kernel(context);
+  }
+
+  double ns_per_count = 1.0e9 / static_cast<double>(perf_count_frequency);
+  for (int i = 0; i < BENCH_REPETITION_COUNT; ++i) {
+    LARGE_INTEGER start_counter;
+    QueryPerformanceCounter(&start_counter);
+    uint64_t start_cycles = __rdtsc();
+
+    kernel(context);
+
+    uint64_t end_cycles = __rdtsc();
+    LARGE_INTEGER end_counter;
+    QueryPerformanceCounter(&end_counter);
+
+    bench_ns[i] = ns_per_count * static_cast<double>(end_counter.QuadPart -
+                                                     start_counter.QuadPart);
+    bench_cycles[i] = static_cast<double>(end_cycles - start_cycles);
+  }
+
+  qsort(bench_ns, BENCH_REPETITION_COUNT, sizeof(double), CompareDoubles);
+  qsort(bench_cycles, BENCH_REPETITION_COUNT, sizeof(double), CompareDoubles);
+
+  BenchResult result = {};
+  result.name = name;
+  result.unit = unit;
+  result.units_per_run = units_per_run;
+  result.repetition_count = BENCH_REPETITION_COUNT;
+  result.min_ns = bench_ns[0];
+  result.median_ns = GetPercentile(bench_ns, BENCH_REPETITION_COUNT, 0.5);
+  result.p99_ns = GetPercentile(bench_ns, BENCH_REPETITION_COUNT, 0.99);
+  result.max_ns = bench_ns[BENCH_REPETITION_COUNT - 1];
+  result.median_cycles =
+      GetPercentile(bench_cycles, BENCH_REPETITION_COUNT, 0.5);
+  result.cycles_per_unit =
+      result.median_cycles / static_cast<double>(units_per_run);
+  return result;
+}
+
+static bool InitBenchContext(BenchContext *context) {
+  *context = {};
+  context->state.tone_hz = 256;
+
+  ResizeDIBSection(&context->render_target, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+  ResizeDIBSection(&context->present_buffer, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+  SetRenderResolution(&context->render_target,
+                      {DEFAULT_WIDTH / 2, DEFAULT_HEIGHT / 2});
+
+  int samples_per_frame = BENCH_SAMPLES_PER_SECOND / BENCH_FPS;
+  context->sound_buffer.samples_per_second = BENCH_SAMPLES_PER_SECOND;
+  context->sound_buffer.sample_count = samples_per_frame;
+  context->sound_buffer.left_samples = reinterpret_cast<float *>(
+      VirtualAlloc(0, samples_per_frame * 2 * sizeof(float),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  context->sound_buffer.right_samples =
+      context->sound_buffer.left_samples + samples_per_frame;
+
+  context->device_sample_count = BENCH_SAMPLES_PER_SECOND;
+  context->device_samples = reinterpret_cast<int16_t *>(
+      VirtualAlloc(0, context->device_sample_count * 2 * sizeof(int16_t),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+  context->capture_planes = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, DEFAULT_WIDTH * DEFAULT_HEIGHT * 3 / 2,
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+  context->stick_values = reinterpret_cast<SHORT *>(
+      VirtualAlloc(0, BENCH_STICK_VALUE_COUNT * sizeof(SHORT),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+  context->coverage = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, DEFAULT_WIDTH * DEFAULT_HEIGHT, MEM_RESERVE | MEM_COMMIT,
+                   PAGE_READWRITE));
+
+  int width = context->render_target.width;
+  int height = context->render_target.height;
+  size_t format_pixel_size = 0;
+  for (int i = 0; i < PIXEL_FORMAT_COUNT; ++i) {
+    format_pixel_size += GetBytesPerPixel(static_cast<PixelFormat>(i));
+  }
+  size_t sprite_texture_size =
+      BENCH_SPRITE_TEXTURE_DIM * BENCH_SPRITE_TEXTURE_DIM * sizeof(uint32_t);
+  uint8_t *format_memory = reinterpret_cast<uint8_t *>(VirtualAlloc(
+      0, format_pixel_size * width * height + sprite_texture_size,
+      MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+  void *arena_memory = VirtualAlloc(0, 2 * BENCH_ARENA_SIZE,
+                                    MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+  if (!context->render_target.memory || !context->present_buffer.memory ||
+      !context->sound_buffer.left_samples || !context->device_samples ||
+      !context->capture_planes || !context->stick_values ||
+      !context->coverage || !format_memory || !arena_memory) {
+    return false;
+  }
+
+  for (int i = 0; i < PIXEL_FORMAT_COUNT; ++i) {
+    PixelFormat format = static_cast<PixelFormat>(i);
+    context->format_buffers[i] =
+        MakeGameBuffer(format_memory, width, height, format);
+    format_memory += GetBytesPerPixel(format) * width * height;
+  }
+  context->coverage_mask =
+      MakeGameBuffer(context->coverage, width, height, PIXEL_FORMAT_MASK8);
+  context->sprite_texture =
+      MakeGameBuffer(format_memory, BENCH_SPRITE_TEXTURE_DIM,
+                     BENCH_SPRITE_TEXTURE_DIM, PIXEL_FORMAT_BGRA8);
+  FillMarkerTexture(&context->sprite_texture, 0xFFFFC080);
+
+  // Cycles through every coverage value so the empty-span skip in the blend
+  // kernels never kicks in.
+  for (int i = 0; i < DEFAULT_WIDTH * DEFAULT_HEIGHT; ++i) {
+    context->coverage[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  InitArena(&context->entity_arena, BENCH_ARENA_SIZE, arena_memory);
+  InitArena(&context->frame_arena, BENCH_ARENA_SIZE,
+            reinterpret_cast<uint8_t *>(arena_memory) + BENCH_ARENA_SIZE);
+  for (int i = 0; i < BENCH_COLLISION_SET_COUNT; ++i) {
+    SpawnBenchEntities(&context->collision_storage[i], &context->entity_arena,
+                       BENCH_COLLISION_ENTITY_COUNTS[i]);
+  }
+  SpawnBenchParticles(&context->particles, &context->entity_arena,
+                      &context->render_target);
+
+  InitSRGBTables();
+  if (!InitTextCache(&context->text_cache)) {
+    return false;
+  }
+
+  for (int i = 0; i < BENCH_STICK_VALUE_COUNT; ++i) {
+    context->stick_values[i] =
+        static_cast<SHORT>(-32768 + i * (65535 / BENCH_STICK_VALUE_COUNT));
+  }
+
+  return true;
+}
+
+int RunBenchmarks(wchar_t *output_path, int64_t perf_count_frequency) {
+  BenchContext context;
+  if (!InitBenchContext(&context)) {
+    OutputDebugStringW(L"Bench: allocation failed\n");
+    return 1;
+  }
+
+  int64_t render_pixels =
+      static_cast<int64_t>(context.render_target.width) *
+      context.render_target.height;
+  int64_t present_pixels =
+      static_cast<int64_t>(context.present_buffer.width) *
+      context.present_buffer.height;
+  int64_t frame_samples = context.sound_buffer.sample_count;
+  int64_t sprite_pixels = static_cast<int64_t>(
+      BENCH_SPRITE_SIZE * 0.75f * BENCH_SPRITE_SIZE);
+
+  BenchEntry entries[] = {
+      {"Render", "pixel", render_pixels, BenchRender},
+      {"OutputGameSound", "sample", frame_samples, BenchOutputGameSound},
+      {"ConvertSoundSamples", "sample", frame_samples,
+       BenchConvertSoundSamples},
+      {"ClearSoundRegion", "byte",
+       static_cast<int64_t>(context.device_sample_count * 2 *
+                            sizeof(int16_t)),
+       BenchClearSoundRegion},
+      {"DebugDrawVertical", "pixel", context.render_target.height - 32,
+       BenchDebugDrawVertical},
+      {"ProcessXInputStickPosition", "call", BENCH_STICK_VALUE_COUNT,
+       BenchProcessXInputStickPosition},
+      {"UpscaleNearest", "pixel", present_pixels, BenchUpscaleNearest},
+      {"UpscaleBilinear", "pixel", present_pixels, BenchUpscaleBilinear},
+      {"ConvertBGRAToI420", "pixel", render_pixels, BenchConvertBGRAToI420},
+      {"HashGameBuffer", "byte",
+       static_cast<int64_t>(context.render_target.pitch) *
+           context.render_target.height,
+       BenchHashGameBuffer},
+      {"ResolveCollisions1k", "entity", BENCH_COLLISION_ENTITY_COUNTS[0],
+       BenchResolveCollisions1k},
+      {"ResolveCollisions10k", "entity", BENCH_COLLISION_ENTITY_COUNTS[1],
+       BenchResolveCollisions10k},
+      {"ResolveCollisions100k", "entity", BENCH_COLLISION_ENTITY_COUNTS[2],
+       BenchResolveCollisions100k},
+      {"UpdateParticles", "particle", PARTICLE_CAPACITY, BenchUpdateParticles},
+      {"DrawParticles", "particle", PARTICLE_CAPACITY, BenchDrawParticles},
+      {"DrawParticlesLinear", "particle", PARTICLE_CAPACITY,
+       BenchDrawParticlesLinear},
+      {"BlendCoverageGamma", "pixel", render_pixels, BenchBlendCoverageGamma},
+      {"BlendCoverageLinear", "pixel", render_pixels,
+       BenchBlendCoverageLinear},
+      {"ClearBGRA8", "pixel", render_pixels, BenchClearBGRA8},
+      {"ClearRGB565", "pixel", render_pixels, BenchClearRGB565},
+      {"ClearMask8", "pixel", render_pixels, BenchClearMask8},
+      {"ClearHDR", "pixel", render_pixels, BenchClearHDR},
+      {"ConvertHDRToBGRA8", "pixel", render_pixels, BenchConvertHDRToBGRA8},
+      {"ConvertBGRA8ToRGB565", "pixel", render_pixels,
+       BenchConvertBGRA8ToRGB565},
+      {"BlendMaskBGRA8", "pixel", render_pixels, BenchBlendMaskBGRA8},
+      {"BlendMaskRGB565", "pixel", render_pixels, BenchBlendMaskRGB565},
+      {"DrawSprite", "pixel", sprite_pixels, BenchDrawSprite},
+      {"DrawSpriteReference", "pixel", sprite_pixels,
+       BenchDrawSpriteReference},
+      {"DrawDebugText", "line", 4, BenchDrawDebugText},
+      {"LayoutText", "line", 1, BenchLayoutText},
+  };
+
+  char debug_buffer[256];
+  int json_size = snprintf(bench_json, sizeof(bench_json),
+                           "{\n  \"perf_count_frequency\": %lld,\n"
+                           "  \"benchmarks\": [\n",
+                           static_cast<long long>(perf_count_frequency));
+
+  for (int i = 0; i < ArraySize(entries); ++i) {
+    BenchEntry *entry = &entries[i];
+    BenchResult result =
+        RunBenchmark(entry->name, entry->unit, entry->units_per_run,
+                     entry->kernel, &context, perf_count_frequency);
+
+    snprintf(debug_buffer, sizeof(debug_buffer),
+             "%-28s median %10.0f ns  p99 %10.0f ns  %8.3f cycles/%s\n",
+             result.name, result.median_ns, result.p99_ns,
+             result.cycles_per_unit, result.unit);
+    OutputDebugStringA(debug_buffer);
+
+    json_size += snprintf(
+        bench_json + json_size, sizeof(bench_json) - json_size,
+        "    {\"name\": \"%s\", \"unit\": \"%s\", \"units\": %lld, "
+        "\"repetitions\": %d, \"min_ns\": %.1f, \"median_ns\": %.1f, "
+        "\"p99_ns\": %.1f, \"max_ns\": %.1f, \"median_cycles\": %.1f, "
+        "\"cycles_per_unit\": %.4f}%s\n",
+        result.name, result.unit, static_cast<long long>(result.units_per_run),
+        result.repetition_count, result.min_ns, result.median_ns,
+        result.p99_ns, result.max_ns, result.median_cycles,
+        result.cycles_per_unit, (i + 1 < ArraySize(entries)) ? "," : "");
+  }
+
+  json_size += snprintf(bench_json + json_size, sizeof(bench_json) - json_size,
+                        "  ]\n}\n");
+
+  if (!WriteEntireFileDebug(output_path, static_cast<uint32_t>(json_size),
+                            bench_json)) {
+    OutputDebugStringW(L"Bench: failed to write results\n");
+    return 1;
+  }
+
+  return 0;
+}
+#endif
@@ -0,0 +1,71 @@
+#ifndef SRC_WIN32_WIN32_BENCH_H_
+#define SRC_WIN32_WIN32_BENCH_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-entity.h"
+#include "../../src/handmade-hero/handmade-hero-particle.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-display.h"
+#include "../../src/win32/win32-sound.h"
+#include "../../src/win32/win32-text.h"
+
+#if DEV
+static const int BENCH_WARMUP_COUNT = 16;
+static const int BENCH_REPETITION_COUNT = 256;
+static const int BENCH_STICK_VALUE_COUNT = 4096;
+static const int BENCH_COLLISION_SET_COUNT = 3;
+static const int BENCH_SPRITE_TEXTURE_DIM = 64;
+static const float BENCH_SPRITE_SIZE = 384.0f;
+
+struct BenchContext {
+  GameState state;
+  Buffer render_target;
+  Buffer present_buffer;
+  GameSoundBuffer sound_buffer;
+  SoundOutput sound_output;
+  int16_t *device_samples;
+  int device_sample_count;
+  uint8_t *capture_planes;
+  uint8_t *coverage;
+  GameBuffer coverage_mask;
+  GameBuffer format_buffers[PIXEL_FORMAT_COUNT];
+  GameBuffer sprite_texture;
+  SHORT *stick_values;
+  EntityStorage collision_storage[BENCH_COLLISION_SET_COUNT];
+  ParticleSystem particles;
+  TextCache text_cache;
+  int text_counter;
+  MemoryArena entity_arena;
+  MemoryArena frame_arena;
+  int draw_x;
+  volatile float stick_sink;
+  volatile uint64_t hash_sink;
+  volatile uint32_t collision_sink;
+};
+
+typedef void BenchKernel(BenchContext *context);
+
+struct BenchResult {
+  const char *name;
+  const char *unit;
+  int64_t units_per_run;
+  int repetition_count;
+  double min_ns;
+  double median_ns;
+  double p99_ns;
+  double max_ns;
+  double median_cycles;
+  double cycles_per_unit;
+};
+
+bool ParseBenchMode(char *command_line);
+BenchResult RunBenchmark(const char *name, const char *unit,
+                         int64_t units_per_run, BenchKernel *kernel,
+                         BenchContext *context, int64_t perf_count_frequency);
+int RunBenchmarks(wchar_t *output_path, int64_t perf_count_frequency);
+#endif
+
+#endif  // SRC_WIN32_WIN32_BENCH_H_
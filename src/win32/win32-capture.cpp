@@ -0,0 +1,320 @@
+#include "../../src/win32/win32-capture.h"
+
+#include <emmintrin.h>
+#include <windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-clock.h"
+
+static inline void UnpackChannels(uint32_t *pixels, __m128i *red,
+                                  __m128i *green, __m128i *blue) {
+  __m128i mask = _mm_set1_epi32(0xFF);
+  __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i *>(pixels));
+  __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i *>(pixels + 4));
+
+  *blue = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+  *green = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), mask),
+                           _mm_and_si128(_mm_srli_epi32(hi, 8), mask));
+  *red = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), mask),
+                         _mm_and_si128(_mm_srli_epi32(hi, 16), mask));
+}
+
+// BT.601 limited range. The weighted sum stays below 2^16, so it is computed
+// in unsigned 16-bit lanes.
+static inline __m128i ComputeLuma(__m128i red, __m128i green, __m128i blue) {
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(66)),
+                              _mm_mullo_epi16(green, _mm_set1_epi16(129)));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(blue, _mm_set1_epi16(25)));
+  sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+
+  __m128i result = _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+  return result;
+}
+
+// Averages 2x2 blocks of two rows of eight channel values into four values.
+static inline __m128i AverageQuads(__m128i top, __m128i bottom) {
+  __m128i sums = _mm_madd_epi16(_mm_add_epi16(top, bottom), _mm_set1_epi16(1));
+  sums = _mm_srli_epi32(_mm_add_epi32(sums, _mm_set1_epi32(2)), 2);
+
+  __m128i result = _mm_packs_epi32(sums, sums);
+  return result;
+}
+
+static inline __m128i ComputeChroma(__m128i red, __m128i green, __m128i blue,
+                                    short red_weight, short green_weight,
+                                    short blue_weight) {
+  __m128i sum =
+      _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(red_weight)),
+                    _mm_mullo_epi16(green, _mm_set1_epi16(green_weight)));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(blue, _mm_set1_epi16(blue_weight)));
+  sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+
+  __m128i result = _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+  return result;
+}
+
+static inline void ConvertBlockScalar(uint32_t *top, uint32_t *bottom,
+                                      uint8_t *y_top, uint8_t *y_bottom,
+                                      uint8_t *u, uint8_t *v) {
+  uint32_t pixels[4] = {top[0], top[1], bottom[0], bottom[1]};
+  uint8_t *luma[4] = {y_top, y_top + 1, y_bottom, y_bottom + 1};
+
+  int red_sum = 0;
+  int green_sum = 0;
+  int blue_sum = 0;
+  for (int i = 0; i < 4; ++i) {
+    int red = (pixels[i] >> 16) & 0xFF;
+    int green = (pixels[i] >> 8) & 0xFF;
+    int blue = pixels[i] & 0xFF;
+    *luma[i] = static_cast<uint8_t>(
+        ((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16);
+    red_sum += red;
+    green_sum += green;
+    blue_sum += blue;
+  }
+
+  int red = (red_sum + 2) >> 2;
+  int green = (green_sum + 2) >> 2;
+  int blue = (blue_sum + 2) >> 2;
+  *u = static_cast<uint8_t>(((-38 * red - 74 * green + 112 * blue + 128) >> 8) +
+                            128);
+  *v = static_cast<uint8_t>(((112 * red - 94 * green - 18 * blue + 128) >> 8) +
+                            128);
+}
+
+void ConvertBGRAToI420(Buffer *source, uint8_t *planes) {
+  int width = source->width;
+  int height = source->height;
+  int chroma_width = width / 2;
+
+  Assert((width % 2) == 0 && (height % 2) == 0);
+
+  uint8_t *y_plane = planes;
+  uint8_t *u_plane = y_plane + width * height;
+  uint8_t *v_plane = u_plane + chroma_width * (height / 2);
+  uint8_t *source_row = reinterpret_cast<uint8_t *>(source->memory);
+
+  for (int y = 0; y < height; y += 2) {
+    uint32_t *top = reinterpret_cast<uint32_t *>(source_row);
+    uint32_t *bottom = reinterpret_cast<uint32_t *>(source_row + source->pitch);
+    uint8_t *y_top = y_plane + y * width;
+    uint8_t *y_bottom = y_top + width;
+    uint8_t *u = u_plane + (y / 2) * chroma_width;
+    uint8_t *v = v_plane + (y / 2) * chroma_width;
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+      __m128i top_red, top_green, top_blue;
+      __m128i bottom_red, bottom_green, bottom_blue;
+      UnpackChannels(top + x, &top_red, &top_green, &top_blue);
+      UnpackChannels(bottom + x, &bottom_red, &bottom_green, &bottom_blue);
+
+      __m128i luma_top = ComputeLuma(top_red, top_green, top_blue);
+      __m128i luma_bottom = ComputeLuma(bottom_red, bottom_green, bottom_blue);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(y_top + x),
+                       _mm_packus_epi16(luma_top, luma_top));
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(y_bottom + x),
+                       _mm_packus_epi16(luma_bottom, luma_bottom));
+
+      __m128i red = AverageQuads(top_red, bottom_red);
+      __m128i green = AverageQuads(top_green, bottom_green);
+      __m128i blue = AverageQuads(top_blue, bottom_blue);
+
+      __m128i chroma_u = ComputeChroma(red, green, blue, -38, -74, 112);
+      __m128i chroma_v = ComputeChroma(red, green, blue, 112, -94, -18);
+      *reinterpret_cast<int32_t *>(u + x / 2) =
+          _mm_cvtsi128_si32(_mm_packus_epi16(chroma_u, chroma_u));
+      *reinterpret_cast<int32_t *>(v + x / 2) =
+          _mm_cvtsi128_si32(_mm_packus_epi16(chroma_v, chroma_v));
+    }
+
+    for (; x < width; x += 2) {
+      ConvertBlockScalar(top + x, bottom + x, y_top + x, y_bottom + x,
+                         u + x / 2, v + x / 2);
+    }
+
+    source_row += 2 * source->pitch;
+  }
+}
+
+static bool WriteCaptureData(CaptureQueue *queue, void *data, DWORD size) {
+  DWORD bytes_written = 0;
+  if (!WriteFile(queue->file, data, size, &bytes_written, 0) ||
+      bytes_written != size) {
+    return false;
+  }
+
+  queue->stats.bytes_written += bytes_written;
+  return true;
+}
+
+static DWORD WINAPI CaptureThreadProc(LPVOID parameter) {
+  CaptureQueue *queue = reinterpret_cast<CaptureQueue *>(parameter);
+
+  while (true) {
+    WaitForSingleObject(queue->ready_semaphore, INFINITE);
+    if (queue->pending_count == 0) {
+      if (!queue->is_running) {
+        break;
+      }
+      continue;
+    }
+
+    CaptureFrame *frame = &queue->slots[queue->read_idx];
+    queue->read_idx = (queue->read_idx + 1) % CAPTURE_SLOT_COUNT;
+
+    if (!queue->is_header_written) {
+      char header[128];
+      int header_size =
+          snprintf(header, sizeof(header),
+                   "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg "
+                   "XCOLORRANGE=LIMITED\n",
+                   frame->width, frame->height, queue->fps);
+      WriteCaptureData(queue, header, static_cast<DWORD>(header_size));
+      queue->is_header_written = true;
+    }
+
+    LARGE_INTEGER convert_start = GetWallClock();
+    Buffer source = {};
+    source.memory = frame->pixels;
+    source.width = frame->width;
+    source.height = frame->height;
+    source.pitch = frame->width * 4;
+    source.bytes_per_pixel = 4;
+    ConvertBGRAToI420(&source, queue->planes);
+    queue->stats.last_convert_ms =
+        1000.0f * GetSecondsElapsed(convert_start, GetWallClock(),
+                                    queue->perf_count_frequency);
+
+    char frame_marker[] = "FRAME\n";
+    DWORD planes_size =
+        static_cast<DWORD>(frame->width * frame->height * 3 / 2);
+    if (WriteCaptureData(queue, frame_marker, sizeof(frame_marker) - 1) &&
+        WriteCaptureData(queue, queue->planes, planes_size)) {
+      ++queue->stats.frames_written;
+    }
+
+    InterlockedDecrement(&queue->pending_count);
+    ReleaseSemaphore(queue->free_semaphore, 1, 0);
+  }
+
+  return 0;
+}
+
+bool StartCapture(CaptureQueue *queue, wchar_t *file_path, int max_width,
+                  int max_height, int fps, CapturePolicy policy,
+                  int64_t perf_count_frequency) {
+  *queue = {};
+  queue->max_width = max_width;
+  queue->max_height = max_height;
+  queue->fps = fps;
+  queue->policy = policy;
+  queue->perf_count_frequency = perf_count_frequency;
+
+  size_t slot_size = static_cast<size_t>(max_width) * max_height * 4;
+  for (int i = 0; i < CAPTURE_SLOT_COUNT; ++i) {
+    queue->slots[i].pixels = reinterpret_cast<uint32_t *>(VirtualAlloc(
+        0, slot_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    if (!queue->slots[i].pixels) {
+      return false;
+    }
+  }
+
+  size_t planes_size = static_cast<size_t>(max_width) * max_height * 3 / 2;
+  queue->planes = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, planes_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!queue->planes) {
+    return false;
+  }
+
+  queue->file =
+      CreateFileW(file_path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+  if (queue->file == INVALID_HANDLE_VALUE) {
+    queue->file = 0;
+    return false;
+  }
+
+  queue->free_semaphore = CreateSemaphoreExW(
+      0, CAPTURE_SLOT_COUNT, CAPTURE_SLOT_COUNT, 0, 0, SEMAPHORE_ALL_ACCESS);
+  queue->ready_semaphore = CreateSemaphoreExW(
+      0, 0, CAPTURE_SLOT_COUNT + 1, 0, 0, SEMAPHORE_ALL_ACCESS);
+  if (!queue->free_semaphore || !queue->ready_semaphore) {
+    return false;
+  }
+
+  queue->is_running = true;
+  queue->thread = CreateThread(0, 0, CaptureThreadProc, queue, 0, 0);
+  if (!queue->thread) {
+    queue->is_running = false;
+    return false;
+  }
+
+  return true;
+}
+
+void CaptureBuffer(CaptureQueue *queue, Buffer *buffer) {
+  if (!queue->is_running) {
+    return;
+  }
+
+  if (!queue->stream_width) {
+    queue->stream_width = buffer->width;
+    queue->stream_height = buffer->height;
+  }
+
+  // Y4M streams have a fixed frame size, so frames rendered at another
+  // internal resolution are skipped rather than rescaled.
+  if (buffer->width != queue->stream_width ||
+      buffer->height != queue->stream_height) {
+    ++queue->stats.frames_skipped;
+    return;
+  }
+
+  DWORD timeout = (queue->policy == CAPTURE_POLICY_BLOCK) ? INFINITE : 0;
+  if (WaitForSingleObject(queue->free_semaphore, timeout) != WAIT_OBJECT_0) {
+    ++queue->stats.frames_dropped;
+    return;
+  }
+
+  LARGE_INTEGER copy_start = GetWallClock();
+
+  CaptureFrame *frame = &queue->slots[queue->write_idx];
+  queue->write_idx = (queue->write_idx + 1) % CAPTURE_SLOT_COUNT;
+  frame->width = buffer->width;
+  frame->height = buffer->height;
+  uint8_t *source_row = reinterpret_cast<uint8_t *>(buffer->memory);
+  uint32_t *dest_row = frame->pixels;
+  for (int y = 0; y < buffer->height; ++y) {
+    memcpy(dest_row, source_row, buffer->width * sizeof(uint32_t));
+    source_row += buffer->pitch;
+    dest_row += buffer->width;
+  }
+
+  queue->stats.last_copy_ms =
+      1000.0f * GetSecondsElapsed(copy_start, GetWallClock(),
+                                  queue->perf_count_frequency);
+  ++queue->stats.frames_captured;
+
+  InterlockedIncrement(&queue->pending_count);
+  ReleaseSemaphore(queue->ready_semaphore, 1, 0);
+}
+
+void StopCapture(CaptureQueue *queue) {
+  if (queue->thread) {
+    queue->is_running = false;
+    ReleaseSemaphore(queue->ready_semaphore, 1, 0);
+    WaitForSingleObject(queue->thread, INFINITE);
+    CloseHandle(queue->thread);
+    queue->thread = 0;
+  }
+
+  if (queue->file) {
+    FlushFileBuffers(queue->file);
+    CloseHandle(queue->file);
+    queue->file = 0;
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef SRC_WIN32_WIN32_CAPTURE_H_
+#define SRC_WIN32_WIN32_CAPTURE_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/win32/win32-display.h"
+
+static const int CAPTURE_SLOT_COUNT = 8;
+
+enum CapturePolicy {
+  CAPTURE_POLICY_DROP,
+  CAPTURE_POLICY_BLOCK,
+};
+
+struct CaptureFrame {
+  uint32_t *pixels;
+  int width;
+  int height;
+};
+
+struct CaptureStats {
+  int64_t frames_captured;
+  int64_t frames_written;
+  int64_t frames_dropped;
+  int64_t frames_skipped;
+  int64_t bytes_written;
+  float last_copy_ms;
+  float last_convert_ms;
+};
+
+// The calling thread only copies frames into a bounded ring of preallocated
+// slots. The writer thread converts them to I420 and writes them, so the frame
+// loop never pays for the conversion or waits on the disk unless
+// CAPTURE_POLICY_BLOCK asks it to.
+struct CaptureQueue {
+  CaptureFrame slots[CAPTURE_SLOT_COUNT];
+  uint8_t *planes;
+  int max_width;
+  int max_height;
+  int stream_width;
+  int stream_height;
+  int fps;
+  CapturePolicy policy;
+  int64_t perf_count_frequency;
+
+  HANDLE file;
+  HANDLE free_semaphore;
+  HANDLE ready_semaphore;
+  HANDLE thread;
+
+  int write_idx;
+  int read_idx;
+  volatile LONG pending_count;
+  volatile bool is_running;
+  bool is_header_written;
+
+  CaptureStats stats;
+};
+
+bool StartCapture(CaptureQueue *queue, wchar_t *file_path, int max_width,
+                  int max_height, int fps, CapturePolicy policy,
+                  int64_t perf_count_frequency);
+void ConvertBGRAToI420(Buffer *source, uint8_t *planes);
+void CaptureBuffer(CaptureQueue *queue, Buffer *buffer);
+void StopCapture(CaptureQueue *queue);
+
+#endif  // SRC_WIN32_WIN32_CAPTURE_H_
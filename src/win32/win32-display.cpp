@@ -1,9 +1,17 @@
 #include "../../src/win32/win32-display.h"
 
+#include <emmintrin.h>
 #include <windows.h>
 
+#include <cstdint>
+
 #include "../../src/handmade-hero/handmade-hero.h"
 
+static const float RESOLUTION_DOWNSCALE_THRESHOLD = 0.9f;
+static const float RESOLUTION_UPSCALE_THRESHOLD = 0.6f;
+static const int RESOLUTION_DOWNSCALE_FRAMES = 3;
+static const int RESOLUTION_UPSCALE_FRAMES = 60;
+
 Dimensions GetDimensions(HWND window) {
   RECT rect;
   GetClientRect(window, &rect);
@@ -19,6 +27,8 @@ void ResizeDIBSection(Buffer *buffer, int width, int height) {
 
   buffer->width = width;
   buffer->height = height;
+  buffer->max_width = width;
+  buffer->max_height = height;
   buffer->bytes_per_pixel = 4;
 
   Assert(buffer->width && buffer->height && buffer->bytes_per_pixel);
@@ -38,9 +48,288 @@ void ResizeDIBSection(Buffer *buffer, int width, int height) {
   buffer->pitch = buffer->width * buffer->bytes_per_pixel;
 }
 
+void SetRenderResolution(Buffer *buffer, Dimensions resolution) {
+  Assert(resolution.width > 0 && resolution.width <= buffer->max_width);
+  Assert(resolution.height > 0 && resolution.height <= buffer->max_height);
+
+  // The pitch and the bitmap header keep describing the whole allocation, so
+  // the active area is just the top-left corner of it.
+  buffer->width = resolution.width;
+  buffer->height = resolution.height;
+}
+
+void InitRenderResolution(RenderResolution *resolution, int max_width,
+                          int max_height, int level, bool is_dynamic,
+                          ScaleFilter filter) {
+  static const int numerators[RESOLUTION_LEVEL_COUNT] = {1, 3, 2, 1};
+  static const int denominators[RESOLUTION_LEVEL_COUNT] = {1, 4, 3, 2};
+
+  *resolution = {};
+  for (int i = 0; i < RESOLUTION_LEVEL_COUNT; ++i) {
+    resolution->levels[i].width = max_width * numerators[i] / denominators[i];
+    resolution->levels[i].height = max_height * numerators[i] / denominators[i];
+  }
+
+  Assert(level >= 0 && level < RESOLUTION_LEVEL_COUNT);
+  resolution->level = level;
+  resolution->is_dynamic = is_dynamic;
+  resolution->filter = filter;
+}
+
+bool UpdateRenderResolution(RenderResolution *resolution,
+                            float work_sec_per_frame,
+                            float target_sec_per_frame) {
+  if (!resolution->is_dynamic) {
+    return false;
+  }
+
+  int old_level = resolution->level;
+
+  if (work_sec_per_frame >
+      RESOLUTION_DOWNSCALE_THRESHOLD * target_sec_per_frame) {
+    resolution->under_budget_frames = 0;
+    if (++resolution->over_budget_frames >= RESOLUTION_DOWNSCALE_FRAMES &&
+        resolution->level < RESOLUTION_LEVEL_COUNT - 1) {
+      ++resolution->level;
+      resolution->over_budget_frames = 0;
+    }
+  } else if (work_sec_per_frame <
+             RESOLUTION_UPSCALE_THRESHOLD * target_sec_per_frame) {
+    resolution->over_budget_frames = 0;
+    if (++resolution->under_budget_frames >= RESOLUTION_UPSCALE_FRAMES &&
+        resolution->level > 0) {
+      --resolution->level;
+      resolution->under_budget_frames = 0;
+    }
+  } else {
+    resolution->over_budget_frames = 0;
+    resolution->under_budget_frames = 0;
+  }
+
+  return resolution->level != old_level;
+}
+
+Dimensions GetRenderResolution(RenderResolution *resolution) {
+  Dimensions result = resolution->levels[resolution->level];
+  return result;
+}
+
+static inline void CopyRow(uint32_t *dest, uint32_t *source, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i pixels =
+        _mm_loadu_si128(reinterpret_cast<__m128i *>(source + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), pixels);
+  }
+  for (; i < count; ++i) {
+    dest[i] = source[i];
+  }
+}
+
+static inline void DoubleRow(uint32_t *dest, uint32_t *source,
+                             int source_count) {
+  int i = 0;
+  for (; i + 4 <= source_count; i += 4) {
+    __m128i pixels =
+        _mm_loadu_si128(reinterpret_cast<__m128i *>(source + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 2 * i),
+                     _mm_unpacklo_epi32(pixels, pixels));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 2 * i + 4),
+                     _mm_unpackhi_epi32(pixels, pixels));
+  }
+  for (; i < source_count; ++i) {
+    dest[2 * i] = source[i];
+    dest[2 * i + 1] = source[i];
+  }
+}
+
+static void UpscaleNearest(Buffer *source, Buffer *dest) {
+  uint32_t step_x = (static_cast<uint32_t>(source->width) << 16) /
+                    static_cast<uint32_t>(dest->width);
+  uint32_t step_y = (static_cast<uint32_t>(source->height) << 16) /
+                    static_cast<uint32_t>(dest->height);
+  bool is_doubled = dest->width == 2 * source->width;
+
+  uint8_t *source_memory = reinterpret_cast<uint8_t *>(source->memory);
+  uint8_t *dest_row = reinterpret_cast<uint8_t *>(dest->memory);
+  uint32_t *last_source_row = 0;
+  uint32_t *last_dest_row = 0;
+
+  uint32_t fixed_y = step_y >> 1;
+  for (int y = 0; y < dest->height; ++y) {
+    uint32_t *source_row = reinterpret_cast<uint32_t *>(
+        source_memory + (fixed_y >> 16) * source->pitch);
+    uint32_t *dest_pixel = reinterpret_cast<uint32_t *>(dest_row);
+
+    if (source_row == last_source_row) {
+      CopyRow(dest_pixel, last_dest_row, dest->width);
+    } else if (is_doubled) {
+      DoubleRow(dest_pixel, source_row, source->width);
+    } else {
+      uint32_t fixed_x = step_x >> 1;
+      int x = 0;
+      for (; x + 4 <= dest->width; x += 4) {
+        uint32_t p0 = source_row[fixed_x >> 16];
+        uint32_t p1 = source_row[(fixed_x + step_x) >> 16];
+        uint32_t p2 = source_row[(fixed_x + 2 * step_x) >> 16];
+        uint32_t p3 = source_row[(fixed_x + 3 * step_x) >> 16];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest_pixel + x),
+                         _mm_setr_epi32(p0, p1, p2, p3));
+        fixed_x += 4 * step_x;
+      }
+      for (; x < dest->width; ++x) {
+        dest_pixel[x] = source_row[fixed_x >> 16];
+        fixed_x += step_x;
+      }
+    }
+
+    last_source_row = source_row;
+    last_dest_row = dest_pixel;
+    fixed_y += step_y;
+    dest_row += dest->pitch;
+  }
+}
+
+// Maps a destination texel center onto the source grid and returns the left
+// (or top) source index plus an 8-bit blend weight towards the next texel.
+static inline int GetBilinearTap(int32_t fixed, int source_size,
+                                 int *weight) {
+  if (fixed < 0) {
+    fixed = 0;
+  }
+
+  int index = fixed >> 16;
+  *weight = (fixed >> 8) & 0xFF;
+  if (index >= source_size - 1) {
+    index = source_size - 2;
+    *weight = 256;
+  }
+  return index;
+}
+
+static inline __m128i SampleHorizontalPair(uint32_t *row, int index_a,
+                                           int weight_a, int index_b,
+                                           int weight_b) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i a = _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<__m128i *>(row + index_a)), zero);
+  __m128i b = _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<__m128i *>(row + index_b)), zero);
+
+  short inverse_a = static_cast<short>(256 - weight_a);
+  short inverse_b = static_cast<short>(256 - weight_b);
+  short forward_a = static_cast<short>(weight_a);
+  short forward_b = static_cast<short>(weight_b);
+
+  a = _mm_mullo_epi16(a, _mm_setr_epi16(inverse_a, inverse_a, inverse_a,
+                                        inverse_a, forward_a, forward_a,
+                                        forward_a, forward_a));
+  b = _mm_mullo_epi16(b, _mm_setr_epi16(inverse_b, inverse_b, inverse_b,
+                                        inverse_b, forward_b, forward_b,
+                                        forward_b, forward_b));
+  a = _mm_add_epi16(a, _mm_srli_si128(a, 8));
+  b = _mm_add_epi16(b, _mm_srli_si128(b, 8));
+
+  __m128i result = _mm_srli_epi16(_mm_unpacklo_epi64(a, b), 8);
+  return result;
+}
+
+static void UpscaleBilinear(Buffer *source, Buffer *dest) {
+  int32_t step_x = static_cast<int32_t>(
+      (static_cast<uint32_t>(source->width) << 16) / dest->width);
+  int32_t step_y = static_cast<int32_t>(
+      (static_cast<uint32_t>(source->height) << 16) / dest->height);
+
+  uint8_t *source_memory = reinterpret_cast<uint8_t *>(source->memory);
+  uint8_t *dest_row = reinterpret_cast<uint8_t *>(dest->memory);
+
+  int32_t fixed_y = (step_y >> 1) - 0x8000;
+  for (int y = 0; y < dest->height; ++y) {
+    int weight_y;
+    int source_y = GetBilinearTap(fixed_y, source->height, &weight_y);
+    uint32_t *top_row = reinterpret_cast<uint32_t *>(
+        source_memory + source_y * source->pitch);
+    uint32_t *bottom_row = reinterpret_cast<uint32_t *>(
+        source_memory + (source_y + 1) * source->pitch);
+    uint32_t *dest_pixel = reinterpret_cast<uint32_t *>(dest_row);
+
+    __m128i inverse_y = _mm_set1_epi16(static_cast<short>(256 - weight_y));
+    __m128i forward_y = _mm_set1_epi16(static_cast<short>(weight_y));
+
+    int32_t fixed_x = (step_x >> 1) - 0x8000;
+    for (int x = 0; x < dest->width; x += 2) {
+      int weight_a;
+      int weight_b;
+      int index_a = GetBilinearTap(fixed_x, source->width, &weight_a);
+      int index_b =
+          GetBilinearTap(fixed_x + step_x, source->width, &weight_b);
+
+      __m128i top = SampleHorizontalPair(top_row, index_a, weight_a, index_b,
+                                         weight_b);
+      __m128i bottom = SampleHorizontalPair(bottom_row, index_a, weight_a,
+                                            index_b, weight_b);
+      __m128i blended =
+          _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top, inverse_y),
+                                       _mm_mullo_epi16(bottom, forward_y)),
+                         8);
+      __m128i packed = _mm_packus_epi16(blended, blended);
+
+      if (x + 1 < dest->width) {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dest_pixel + x), packed);
+      } else {
+        dest_pixel[x] = static_cast<uint32_t>(_mm_cvtsi128_si32(packed));
+      }
+
+      fixed_x += 2 * step_x;
+    }
+
+    fixed_y += step_y;
+    dest_row += dest->pitch;
+  }
+}
+
+void UpscaleBuffer(Buffer *source, Buffer *dest, ScaleFilter filter) {
+  Assert(source->bytes_per_pixel == 4 && dest->bytes_per_pixel == 4);
+
+  if (filter == SCALE_FILTER_BILINEAR && source->width > 1 &&
+      source->height > 1) {
+    UpscaleBilinear(source, dest);
+  } else {
+    UpscaleNearest(source, dest);
+  }
+}
+
 void DisplayBuffer(HDC device_context, int window_x, int window_y,
                    int window_width, int window_height, Buffer *buffer) {
   StretchDIBits(device_context, window_x, window_y, window_width, window_height,
                 0, 0, buffer->width, buffer->height, buffer->memory,
                 &buffer->info, DIB_RGB_COLORS, SRCCOPY);
 }
+
+void PresentBuffer(HDC device_context, Dimensions window_dimensions,
+                   Buffer *render_target, Buffer *present_buffer,
+                   ScaleFilter filter) {
+  if (window_dimensions.width <= 0 || window_dimensions.height <= 0) {
+    return;
+  }
+
+  if (filter == SCALE_FILTER_STRETCH) {
+    DisplayBuffer(device_context, 0, 0, window_dimensions.width,
+                  window_dimensions.height, render_target);
+    return;
+  }
+
+  if (present_buffer->max_width != window_dimensions.width ||
+      present_buffer->max_height != window_dimensions.height) {
+    ResizeDIBSection(present_buffer, window_dimensions.width,
+                     window_dimensions.height);
+  }
+
+  if (!present_buffer->memory) {
+    return;
+  }
+
+  UpscaleBuffer(render_target, present_buffer, filter);
+  DisplayBuffer(device_context, 0, 0, window_dimensions.width,
+                window_dimensions.height, present_buffer);
+}
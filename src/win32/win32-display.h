@@ -10,6 +10,8 @@ struct Buffer {
   int height;
   int pitch;
   int bytes_per_pixel;
+  int max_width;
+  int max_height;
 };
 
 struct Dimensions {
@@ -17,11 +19,45 @@ struct Dimensions {
   int height;
 };
 
+enum ScaleFilter {
+  SCALE_FILTER_STRETCH,
+  SCALE_FILTER_NEAREST,
+  SCALE_FILTER_BILINEAR,
+};
+
+static const int RESOLUTION_LEVEL_COUNT = 4;
+
+// Internal render resolution ladder. Level 0 is the full buffer size, every
+// level after that is cheaper to fill. In dynamic mode the level is picked
+// from the measured work time of recent frames.
+struct RenderResolution {
+  Dimensions levels[RESOLUTION_LEVEL_COUNT];
+  int level;
+  bool is_dynamic;
+  ScaleFilter filter;
+  int over_budget_frames;
+  int under_budget_frames;
+};
+
 Dimensions GetDimensions(HWND window);
 
 void ResizeDIBSection(Buffer *buffer, int width, int height);
+void SetRenderResolution(Buffer *buffer, Dimensions resolution);
+
+void InitRenderResolution(RenderResolution *resolution, int max_width,
+                          int max_height, int level, bool is_dynamic,
+                          ScaleFilter filter);
+bool UpdateRenderResolution(RenderResolution *resolution,
+                            float work_sec_per_frame,
+                            float target_sec_per_frame);
+Dimensions GetRenderResolution(RenderResolution *resolution);
+
+void UpscaleBuffer(Buffer *source, Buffer *dest, ScaleFilter filter);
 
 void DisplayBuffer(HDC device_context, int window_x, int window_y,
                    int window_width, int window_height, Buffer *buffer);
+void PresentBuffer(HDC device_context, Dimensions window_dimensions,
+                   Buffer *render_target, Buffer *present_buffer,
+                   ScaleFilter filter);
 
 #endif  // SRC_WIN32_WIN32_DISPLAY_H_
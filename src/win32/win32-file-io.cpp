@@ -2,6 +2,7 @@
 
 #include "../../src/handmade-hero/handmade-hero.h"
 
+#if DEV
 FileResult ReadEntireFileDebug(wchar_t *file_path) {
   FileResult result = {};
 
@@ -73,3 +74,4 @@ bool WriteEntireFileDebug(wchar_t *file_path, uint32_t memory_size,
   CloseHandle(file_handle);
   return bytes_written == memory_size;
 }
+#endif
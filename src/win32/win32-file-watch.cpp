@@ -0,0 +1,232 @@
+#include "../../src/win32/win32-file-watch.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-clock.h"
+#include "../../src/win32/win32-log.h"
+
+#if DEV
+static void PushFileWatchOverflow(FileWatcher *watcher) {
+  InterlockedIncrement(&watcher->overflow_count);
+}
+
+static void PushFileWatchEvent(FileWatcher *watcher,
+                               FILE_NOTIFY_INFORMATION *info) {
+  int name_length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+  LONG write_idx = watcher->write_idx;
+  if (write_idx - watcher->read_idx >= FILE_WATCH_EVENT_COUNT) {
+    PushFileWatchOverflow(watcher);
+    return;
+  }
+
+  // A name that does not fit cannot be matched, so it counts as lost.
+  FileWatchEvent *event = &watcher->events[write_idx % FILE_WATCH_EVENT_COUNT];
+  int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, name_length,
+                                 event->name, FILE_CHANGE_MAX_NAME - 1, 0, 0);
+  if (size <= 0) {
+    PushFileWatchOverflow(watcher);
+    return;
+  }
+  event->name[size] = 0;
+
+  InterlockedExchange(&watcher->write_idx, write_idx + 1);
+}
+
+static DWORD WINAPI FileWatchThreadProc(LPVOID parameter) {
+  FileWatcher *watcher = reinterpret_cast<FileWatcher *>(parameter);
+  DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE |
+                 FILE_NOTIFY_CHANGE_SIZE;
+
+  while (true) {
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = watcher->change_event;
+    if (!ReadDirectoryChangesW(watcher->directory, watcher->notify_buffer,
+                               FILE_WATCH_BUFFER_SIZE, TRUE, filter, 0,
+                               &overlapped, 0)) {
+      break;
+    }
+
+    HANDLE handles[2] = {watcher->stop_event, watcher->change_event};
+    DWORD wait_result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+    DWORD bytes_returned = 0;
+    if (wait_result != WAIT_OBJECT_0 + 1) {
+      CancelIo(watcher->directory);
+      GetOverlappedResult(watcher->directory, &overlapped, &bytes_returned,
+                          TRUE);
+      break;
+    }
+
+    // Zero bytes means the system buffer overflowed and changes were lost.
+    if (!GetOverlappedResult(watcher->directory, &overlapped, &bytes_returned,
+                             FALSE) ||
+        bytes_returned == 0) {
+      PushFileWatchOverflow(watcher);
+      continue;
+    }
+
+    uint8_t *at = reinterpret_cast<uint8_t *>(watcher->notify_buffer);
+    for (;;) {
+      FILE_NOTIFY_INFORMATION *info =
+          reinterpret_cast<FILE_NOTIFY_INFORMATION *>(at);
+      if (info->Action != FILE_ACTION_REMOVED &&
+          info->Action != FILE_ACTION_RENAMED_OLD_NAME) {
+        PushFileWatchEvent(watcher, info);
+      }
+      if (!info->NextEntryOffset) {
+        break;
+      }
+      at += info->NextEntryOffset;
+    }
+  }
+
+  return 0;
+}
+
+bool StartFileWatcher(FileWatcher *watcher, wchar_t *directory_path,
+                      int64_t perf_count_frequency) {
+  *watcher = {};
+  watcher->perf_count_frequency = perf_count_frequency;
+
+  size_t events_size = FILE_WATCH_EVENT_COUNT * sizeof(FileWatchEvent);
+  uint8_t *memory = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, FILE_WATCH_BUFFER_SIZE + events_size,
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!memory) {
+    return false;
+  }
+  watcher->notify_buffer = reinterpret_cast<DWORD *>(memory);
+  watcher->events =
+      reinterpret_cast<FileWatchEvent *>(memory + FILE_WATCH_BUFFER_SIZE);
+
+  watcher->directory = CreateFileW(
+      directory_path, FILE_LIST_DIRECTORY,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0, OPEN_EXISTING,
+      FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0);
+  if (watcher->directory == INVALID_HANDLE_VALUE) {
+    watcher->directory = 0;
+    return false;
+  }
+
+  watcher->change_event = CreateEventW(0, FALSE, FALSE, 0);
+  watcher->stop_event = CreateEventW(0, FALSE, FALSE, 0);
+  if (!watcher->change_event || !watcher->stop_event) {
+    return false;
+  }
+
+  watcher->thread = CreateThread(0, 0, FileWatchThreadProc, watcher, 0, 0);
+  if (!watcher->thread) {
+    return false;
+  }
+
+  return true;
+}
+
+static void AddPendingChange(FileWatcher *watcher, char *name,
+                             int64_t counter) {
+  for (int i = 0; i < watcher->pending_count; ++i) {
+    FileWatchPending *pending = &watcher->pending[i];
+    if (strcmp(pending->name, name) == 0) {
+      pending->last_counter = counter;
+      return;
+    }
+  }
+
+  if (watcher->pending_count == FILE_WATCH_MAX_PENDING) {
+    watcher->is_overflow_pending = true;
+    watcher->overflow_counter = counter;
+    return;
+  }
+
+  FileWatchPending *pending = &watcher->pending[watcher->pending_count++];
+  memcpy(pending->name, name, FILE_CHANGE_MAX_NAME);
+  pending->last_counter = counter;
+}
+
+// Called once per frame before the game update. Changes are published at this
+// frame boundary only, so the game never sees a batch change mid-frame.
+void PollFileWatcher(FileWatcher *watcher, GameFileChanges *changes) {
+  changes->count = 0;
+  changes->is_overflow = false;
+  if (!watcher->thread) {
+    return;
+  }
+
+  int64_t counter = GetWallClock().QuadPart;
+  LONG write_idx = watcher->write_idx;
+  while (watcher->read_idx != write_idx) {
+    FileWatchEvent *event =
+        &watcher->events[watcher->read_idx % FILE_WATCH_EVENT_COUNT];
+    AddPendingChange(watcher, event->name, counter);
+    InterlockedIncrement(&watcher->read_idx);
+    ++watcher->stats.event_count;
+  }
+
+  LONG overflow_count = watcher->overflow_count;
+  if (overflow_count != watcher->reported_overflow_count) {
+    watcher->stats.overflow_count +=
+        overflow_count - watcher->reported_overflow_count;
+    watcher->reported_overflow_count = overflow_count;
+    watcher->is_overflow_pending = true;
+    watcher->overflow_counter = counter;
+  }
+
+  int64_t settle_count =
+      static_cast<int64_t>(FILE_WATCH_SETTLE_SEC *
+                           static_cast<float>(watcher->perf_count_frequency));
+  int pending_idx = 0;
+  while (pending_idx < watcher->pending_count &&
+         changes->count < FILE_CHANGE_MAX_COUNT) {
+    FileWatchPending *pending = &watcher->pending[pending_idx];
+    if (counter - pending->last_counter < settle_count) {
+      ++pending_idx;
+      continue;
+    }
+
+    memcpy(changes->names[changes->count++], pending->name,
+           FILE_CHANGE_MAX_NAME);
+    *pending = watcher->pending[--watcher->pending_count];
+  }
+
+  if (watcher->is_overflow_pending &&
+      counter - watcher->overflow_counter >= settle_count) {
+    changes->is_overflow = true;
+    watcher->is_overflow_pending = false;
+    Log(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET,
+        "File change notifications were lost; reloading everything");
+  }
+
+  if (changes->count || changes->is_overflow) {
+    ++watcher->stats.batch_count;
+  }
+}
+
+void StopFileWatcher(FileWatcher *watcher) {
+  if (watcher->thread) {
+    SetEvent(watcher->stop_event);
+    WaitForSingleObject(watcher->thread, INFINITE);
+    CloseHandle(watcher->thread);
+    watcher->thread = 0;
+  }
+
+  if (watcher->change_event) {
+    CloseHandle(watcher->change_event);
+    watcher->change_event = 0;
+  }
+  if (watcher->stop_event) {
+    CloseHandle(watcher->stop_event);
+    watcher->stop_event = 0;
+  }
+  if (watcher->directory) {
+    CloseHandle(watcher->directory);
+    watcher->directory = 0;
+  }
+  if (watcher->notify_buffer) {
+    VirtualFree(watcher->notify_buffer, 0, MEM_RELEASE);
+    watcher->notify_buffer = 0;
+  }
+}
+#endif
@@ -0,0 +1,63 @@
+#ifndef SRC_WIN32_WIN32_FILE_WATCH_H_
+#define SRC_WIN32_WIN32_FILE_WATCH_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+#if DEV
+static const DWORD FILE_WATCH_BUFFER_SIZE = 16 * 1024;
+static const int FILE_WATCH_EVENT_COUNT = 256;
+static const int FILE_WATCH_MAX_PENDING = 32;
+static const float FILE_WATCH_SETTLE_SEC = 0.15f;
+
+struct FileWatchEvent {
+  char name[FILE_CHANGE_MAX_NAME];
+};
+
+struct FileWatchPending {
+  char name[FILE_CHANGE_MAX_NAME];
+  int64_t last_counter;
+};
+
+struct FileWatchStats {
+  int64_t event_count;
+  int64_t batch_count;
+  int64_t overflow_count;
+};
+
+// A watcher thread blocks in ReadDirectoryChangesW and hands file names to the
+// frame loop through a single-producer ring. Editors save in several steps,
+// so a name is only published once it has been quiet for
+// FILE_WATCH_SETTLE_SEC, and repeated writes collapse into one change.
+struct FileWatcher {
+  HANDLE directory;
+  HANDLE change_event;
+  HANDLE stop_event;
+  HANDLE thread;
+  DWORD *notify_buffer;
+
+  FileWatchEvent *events;
+  volatile LONG write_idx;
+  volatile LONG read_idx;
+  volatile LONG overflow_count;
+  LONG reported_overflow_count;
+
+  FileWatchPending pending[FILE_WATCH_MAX_PENDING];
+  int pending_count;
+  bool is_overflow_pending;
+  int64_t overflow_counter;
+
+  int64_t perf_count_frequency;
+  FileWatchStats stats;
+};
+
+bool StartFileWatcher(FileWatcher *watcher, wchar_t *directory_path,
+                      int64_t perf_count_frequency);
+void PollFileWatcher(FileWatcher *watcher, GameFileChanges *changes);
+void StopFileWatcher(FileWatcher *watcher);
+#endif
+
+#endif  // SRC_WIN32_WIN32_FILE_WATCH_H_
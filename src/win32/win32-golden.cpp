@@ -0,0 +1,470 @@
+#include "../../src/win32/win32-golden.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-display.h"
+#include "../../src/win32/win32-file-io.h"
+#include "../../src/win32/win32-hash.h"
+#include "../../src/win32/win32-sound.h"
+
+void GetScriptedInput(int frame_idx, GameInput *old_input,
+                      GameInput *new_input) {
+  *new_input = {};
+  new_input->dt_for_frame = 1.0f / GOLDEN_FPS;
+
+  ControllerInput *old_keyboard = GetController(old_input, 0);
+  ControllerInput *keyboard = GetController(new_input, 0);
+  keyboard->is_connected = true;
+  keyboard->action_down.ended_down = ((frame_idx / 15) % 2) == 1;
+  keyboard->action_down.half_transition_count =
+      (keyboard->action_down.ended_down !=
+       old_keyboard->action_down.ended_down)
+          ? 1
+          : 0;
+
+  int phase = frame_idx % 120;
+  int ramp = (phase < 60) ? phase : 120 - phase;
+
+  ControllerInput *gamepad = GetController(new_input, 1);
+  gamepad->is_connected = true;
+  gamepad->is_analog = true;
+  gamepad->stick_avg_x = static_cast<float>(ramp - 30) / 30.0f;
+  gamepad->stick_avg_y = ((frame_idx % 90) < 45) ? 0.5f : -0.5f;
+}
+
+static HarnessFile HARNESS_FILES[HARNESS_FILE_COUNT];
+
+static HarnessFile *FindHarnessFile(const char *file_name) {
+  for (int i = 0; i < HARNESS_FILE_COUNT; ++i) {
+    if (HARNESS_FILES[i].content &&
+        strcmp(HARNESS_FILES[i].name, file_name) == 0) {
+      return &HARNESS_FILES[i];
+    }
+  }
+  return 0;
+}
+
+static void *OpenHarnessFile(const char *file_name) {
+  return FindHarnessFile(file_name);
+}
+
+static void CloseHarnessFile(void *file) {}
+
+static bool ReadHarnessFile(void *file, uint64_t offset, uint32_t size,
+                            void *dest) {
+  HarnessFile *harness_file = reinterpret_cast<HarnessFile *>(file);
+  if (!harness_file || offset > harness_file->size ||
+      size > harness_file->size - offset) {
+    return false;
+  }
+  memcpy(dest, harness_file->content + offset, size);
+  return true;
+}
+
+static bool QueueHarnessRead(void *file, uint64_t offset, uint32_t size,
+                             void *dest, volatile int32_t *status) {
+  bool is_read = ReadHarnessFile(file, offset, size, dest);
+  *status = is_read ? PLATFORM_READ_DONE : PLATFORM_READ_FAILED;
+  return true;
+}
+
+static bool WriteEntireHarnessFile(const char *file_name, uint32_t size,
+                                   void *memory) {
+  size_t name_size = strlen(file_name) + 1;
+  if (!size || name_size > HARNESS_FILE_MAX_NAME) {
+    return false;
+  }
+
+  HarnessFile *file = FindHarnessFile(file_name);
+  for (int i = 0; !file && i < HARNESS_FILE_COUNT; ++i) {
+    if (!HARNESS_FILES[i].content) {
+      file = &HARNESS_FILES[i];
+    }
+  }
+  if (!file) {
+    return false;
+  }
+
+  uint8_t *content = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!content) {
+    return false;
+  }
+  memcpy(content, memory, size);
+
+  if (file->content) {
+    VirtualFree(file->content, 0, MEM_RELEASE);
+  }
+  memcpy(file->name, file_name, name_size);
+  file->content = content;
+  file->size = size;
+  return true;
+}
+
+void InitHarnessPlatformApi(PlatformApi *platform) {
+  for (int i = 0; i < HARNESS_FILE_COUNT; ++i) {
+    if (HARNESS_FILES[i].content) {
+      VirtualFree(HARNESS_FILES[i].content, 0, MEM_RELEASE);
+    }
+    HARNESS_FILES[i] = {};
+  }
+
+  platform->OpenFile = OpenHarnessFile;
+  platform->CloseFile = CloseHarnessFile;
+  platform->ReadFile = ReadHarnessFile;
+  platform->QueueRead = QueueHarnessRead;
+  platform->WriteEntireFile = WriteEntireHarnessFile;
+}
+
+bool AllocateGameMemory(GameMemory *memory, void *base_address) {
+  *memory = {};
+  memory->permanent_storage_size = Megabytes(64);
+  memory->transient_storage_size = Gigabytes((uint64_t)1);
+  uint64_t total_memory_size =
+      memory->permanent_storage_size + memory->transient_storage_size;
+  memory->permanent_storage =
+      VirtualAlloc(base_address, static_cast<size_t>(total_memory_size),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  if (!memory->permanent_storage) {
+    return false;
+  }
+  memory->transient_storage =
+      reinterpret_cast<uint8_t *>(memory->permanent_storage) +
+      memory->permanent_storage_size;
+  InitHarnessPlatformApi(&memory->platform);
+  return true;
+}
+
+bool ParseTrainingMode(char *command_line) {
+  bool result = command_line && strstr(command_line, "-train") != 0;
+  return result;
+}
+
+// Headless scripted run of the frame loop. It is compiled into every build so
+// that the instrumented binary of a profile-guided build has a repeatable
+// training workload.
+int RunTrainingFrames(int frame_count, int width, int height) {
+  GameMemory memory;
+  if (!AllocateGameMemory(&memory, 0)) {
+    OutputDebugStringW(L"Training: memory allocation failed\n");
+    return 1;
+  }
+
+  Buffer buffer = {};
+  ResizeDIBSection(&buffer, width, height);
+
+  int samples_per_frame = GOLDEN_SAMPLES_PER_SECOND / GOLDEN_FPS;
+  float *samples = reinterpret_cast<float *>(
+      VirtualAlloc(0, samples_per_frame * 2 * sizeof(float),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  int16_t *device_samples = reinterpret_cast<int16_t *>(
+      VirtualAlloc(0, samples_per_frame * 2 * sizeof(int16_t),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!buffer.memory || !samples || !device_samples) {
+    OutputDebugStringW(L"Training: buffer allocation failed\n");
+    return 1;
+  }
+
+  GameInput old_input = {};
+  GameInput new_input = {};
+  uint32_t dither_state[4] = {0x2545F491, 0x9E3779B9, 0x85EBCA6B, 0xC2B2AE35};
+
+  for (int frame_idx = 0; frame_idx < frame_count; ++frame_idx) {
+    GetScriptedInput(frame_idx, &old_input, &new_input);
+
+    GameBuffer game_buffer = {};
+    game_buffer.memory = buffer.memory;
+    game_buffer.width = buffer.width;
+    game_buffer.height = buffer.height;
+    game_buffer.pitch = buffer.pitch;
+    game_buffer.bytes_per_pixel = buffer.bytes_per_pixel;
+    game_buffer.format = PIXEL_FORMAT_BGRA8;
+
+    GameSoundBuffer game_sound_buffer = {};
+    game_sound_buffer.samples_per_second = GOLDEN_SAMPLES_PER_SECOND;
+    game_sound_buffer.sample_count = samples_per_frame;
+    game_sound_buffer.left_samples = samples;
+    game_sound_buffer.right_samples = samples + samples_per_frame;
+
+    UpdateAndRender(&memory, &game_buffer, &game_sound_buffer, &new_input);
+    ConvertSoundSamples(device_samples, game_sound_buffer.left_samples,
+                        game_sound_buffer.right_samples,
+                        game_sound_buffer.sample_count, dither_state);
+    old_input = new_input;
+  }
+
+  return 0;
+}
+
+#if DEV
+static const int GOLDEN_MAX_DUMPS = 4;
+
+#pragma pack(push, 1)
+struct BitmapHeader {
+  uint16_t file_type;
+  uint32_t file_size;
+  uint16_t reserved1;
+  uint16_t reserved2;
+  uint32_t bitmap_offset;
+  uint32_t size;
+  int32_t width;
+  int32_t height;
+  uint16_t planes;
+  uint16_t bits_per_pixel;
+  uint32_t compression;
+  uint32_t size_of_bitmap;
+  int32_t horz_resolution;
+  int32_t vert_resolution;
+  uint32_t colors_used;
+  uint32_t colors_important;
+};
+
+struct WaveHeader {
+  uint32_t riff_id;
+  uint32_t riff_size;
+  uint32_t wave_id;
+  uint32_t fmt_id;
+  uint32_t fmt_size;
+  uint16_t format_tag;
+  uint16_t channels;
+  uint32_t samples_per_second;
+  uint32_t avg_bytes_per_second;
+  uint16_t block_align;
+  uint16_t bits_per_sample;
+  uint32_t data_id;
+  uint32_t data_size;
+};
+#pragma pack(pop)
+
+GoldenMode ParseGoldenMode(char *command_line) {
+  if (!command_line) {
+    return GOLDEN_MODE_OFF;
+  }
+
+  if (strstr(command_line, "-golden-record")) {
+    return GOLDEN_MODE_RECORD;
+  }
+
+  if (strstr(command_line, "-golden-verify")) {
+    return GOLDEN_MODE_VERIFY;
+  }
+
+  return GOLDEN_MODE_OFF;
+}
+
+uint64_t HashGameBuffer(GameBuffer *buffer) {
+  uint64_t hash = 0;
+  size_t row_size =
+      static_cast<size_t>(buffer->width) * buffer->bytes_per_pixel;
+
+  uint8_t *row = reinterpret_cast<uint8_t *>(buffer->memory);
+  for (int y = 0; y < buffer->height; ++y) {
+    hash = HashMemory(row, row_size, hash);
+    row += buffer->pitch;
+  }
+
+  return hash;
+}
+
+uint64_t HashGameSound(GameSoundBuffer *sound_buffer) {
+  size_t size = static_cast<size_t>(sound_buffer->sample_count) *
+                sizeof(*sound_buffer->left_samples);
+  uint64_t result = HashMemory(sound_buffer->left_samples, size, 0);
+  result = HashMemory(sound_buffer->right_samples, size, result);
+  return result;
+}
+
+static void DumpFrame(int frame_idx, GameBuffer *buffer,
+                      GameSoundBuffer *sound_buffer) {
+  uint32_t pixels_size =
+      static_cast<uint32_t>(buffer->width * buffer->height * 4);
+  uint32_t bitmap_size =
+      static_cast<uint32_t>(sizeof(BitmapHeader)) + pixels_size;
+  uint8_t *bitmap = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, bitmap_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (bitmap) {
+    BitmapHeader *header = reinterpret_cast<BitmapHeader *>(bitmap);
+    header->file_type = 0x4D42;
+    header->file_size = bitmap_size;
+    header->bitmap_offset = sizeof(BitmapHeader);
+    header->size = sizeof(BitmapHeader) - 14;
+    header->width = buffer->width;
+    header->height = -buffer->height;
+    header->planes = 1;
+    header->bits_per_pixel = 32;
+    header->size_of_bitmap = pixels_size;
+
+    uint8_t *dest_row = bitmap + sizeof(BitmapHeader);
+    uint8_t *source_row = reinterpret_cast<uint8_t *>(buffer->memory);
+    for (int y = 0; y < buffer->height; ++y) {
+      memcpy(dest_row, source_row, buffer->width * 4);
+      dest_row += buffer->width * 4;
+      source_row += buffer->pitch;
+    }
+
+    wchar_t bitmap_path[64];
+    swprintf(bitmap_path, ArraySize(bitmap_path),
+             L"golden-mismatch-%04d.bmp", frame_idx);
+    WriteEntireFileDebug(bitmap_path, bitmap_size, bitmap);
+    VirtualFree(bitmap, 0, MEM_RELEASE);
+  }
+
+  uint32_t samples_size = static_cast<uint32_t>(sound_buffer->sample_count *
+                                                2 * sizeof(int16_t));
+  uint32_t wave_size =
+      static_cast<uint32_t>(sizeof(WaveHeader)) + samples_size;
+  uint8_t *wave = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, wave_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (wave) {
+    WaveHeader *header = reinterpret_cast<WaveHeader *>(wave);
+    header->riff_id = 0x46464952;  // "RIFF"
+    header->riff_size = wave_size - 8;
+    header->wave_id = 0x45564157;  // "WAVE"
+    header->fmt_id = 0x20746D66;   // "fmt "
+    header->fmt_size = 16;
+    header->format_tag = 1;
+    header->channels = 2;
+    header->samples_per_second = sound_buffer->samples_per_second;
+    header->block_align = 2 * sizeof(int16_t);
+    header->avg_bytes_per_second =
+        header->samples_per_second * header->block_align;
+    header->bits_per_sample = 16;
+    header->data_id = 0x61746164;  // "data"
+    header->data_size = samples_size;
+    ConvertSoundSamples(reinterpret_cast<int16_t *>(wave + sizeof(WaveHeader)),
+                        sound_buffer->left_samples, sound_buffer->right_samples,
+                        sound_buffer->sample_count, 0);
+
+    wchar_t wave_path[64];
+    swprintf(wave_path, ArraySize(wave_path), L"golden-mismatch-%04d.wav",
+             frame_idx);
+    WriteEntireFileDebug(wave_path, wave_size, wave);
+    VirtualFree(wave, 0, MEM_RELEASE);
+  }
+}
+
+int RunGoldenFrames(GoldenMode mode, wchar_t *golden_file_path,
+                    int frame_count, int width, int height) {
+  char debug_buffer[256];
+
+  GameMemory memory;
+  if (!AllocateGameMemory(&memory, 0)) {
+    OutputDebugStringW(L"Golden: memory allocation failed\n");
+    return 1;
+  }
+
+  Buffer buffer = {};
+  ResizeDIBSection(&buffer, width, height);
+
+  int samples_per_frame = GOLDEN_SAMPLES_PER_SECOND / GOLDEN_FPS;
+  float *samples = reinterpret_cast<float *>(
+      VirtualAlloc(0, samples_per_frame * 2 * sizeof(float),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+  uint32_t golden_size = static_cast<uint32_t>(
+      sizeof(GoldenFileHeader) + frame_count * sizeof(GoldenFrameHash));
+  uint8_t *golden = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, golden_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!buffer.memory || !samples || !golden) {
+    OutputDebugStringW(L"Golden: buffer allocation failed\n");
+    return 1;
+  }
+
+  GoldenFileHeader *header = reinterpret_cast<GoldenFileHeader *>(golden);
+  header->magic = GOLDEN_FILE_MAGIC;
+  header->version = GOLDEN_FILE_VERSION;
+  header->frame_count = frame_count;
+  header->width = width;
+  header->height = height;
+  header->samples_per_frame = samples_per_frame;
+  GoldenFrameHash *hashes =
+      reinterpret_cast<GoldenFrameHash *>(golden + sizeof(GoldenFileHeader));
+
+  FileResult expected = {};
+  GoldenFrameHash *expected_hashes = 0;
+  if (mode == GOLDEN_MODE_VERIFY) {
+    expected = ReadEntireFileDebug(golden_file_path);
+    GoldenFileHeader *expected_header =
+        reinterpret_cast<GoldenFileHeader *>(expected.content);
+    if (!expected.content || expected.file_size != golden_size ||
+        memcmp(expected_header, header, sizeof(GoldenFileHeader)) != 0) {
+      OutputDebugStringW(L"Golden: missing or incompatible golden file\n");
+      FreeFileMemoryDebug(&expected.content);
+      return 1;
+    }
+    expected_hashes = reinterpret_cast<GoldenFrameHash *>(
+        reinterpret_cast<uint8_t *>(expected.content) +
+        sizeof(GoldenFileHeader));
+  }
+
+  GameInput old_input = {};
+  GameInput new_input = {};
+  int mismatch_count = 0;
+
+  for (int frame_idx = 0; frame_idx < frame_count; ++frame_idx) {
+    GetScriptedInput(frame_idx, &old_input, &new_input);
+
+    GameBuffer game_buffer = {};
+    game_buffer.memory = buffer.memory;
+    game_buffer.width = buffer.width;
+    game_buffer.height = buffer.height;
+    game_buffer.pitch = buffer.pitch;
+    game_buffer.bytes_per_pixel = buffer.bytes_per_pixel;
+    game_buffer.format = PIXEL_FORMAT_BGRA8;
+
+    GameSoundBuffer game_sound_buffer = {};
+    game_sound_buffer.samples_per_second = GOLDEN_SAMPLES_PER_SECOND;
+    game_sound_buffer.sample_count = samples_per_frame;
+    game_sound_buffer.left_samples = samples;
+    game_sound_buffer.right_samples = samples + samples_per_frame;
+
+    UpdateAndRender(&memory, &game_buffer, &game_sound_buffer, &new_input);
+    old_input = new_input;
+
+    GoldenFrameHash *hash = &hashes[frame_idx];
+    hash->frame_hash = HashGameBuffer(&game_buffer);
+    hash->sound_hash = HashGameSound(&game_sound_buffer);
+
+    if (expected_hashes) {
+      GoldenFrameHash *expected_hash = &expected_hashes[frame_idx];
+      bool is_frame_equal = hash->frame_hash == expected_hash->frame_hash;
+      bool is_sound_equal = hash->sound_hash == expected_hash->sound_hash;
+      if (!is_frame_equal || !is_sound_equal) {
+        snprintf(debug_buffer, sizeof(debug_buffer),
+                 "Golden: frame %d mismatch (frame %s, sound %s)\n", frame_idx,
+                 is_frame_equal ? "ok" : "differs",
+                 is_sound_equal ? "ok" : "differs");
+        OutputDebugStringA(debug_buffer);
+
+        if (mismatch_count < GOLDEN_MAX_DUMPS) {
+          DumpFrame(frame_idx, &game_buffer, &game_sound_buffer);
+        }
+        ++mismatch_count;
+      }
+    }
+  }
+
+  int result = 0;
+  if (mode == GOLDEN_MODE_RECORD) {
+    if (!WriteEntireFileDebug(golden_file_path, golden_size, golden)) {
+      OutputDebugStringW(L"Golden: failed to write golden file\n");
+      result = 1;
+    }
+  } else {
+    snprintf(debug_buffer, sizeof(debug_buffer),
+             "Golden: %d of %d frames mismatched\n", mismatch_count,
+             frame_count);
+    OutputDebugStringA(debug_buffer);
+    result = (mismatch_count == 0) ? 0 : 1;
+    FreeFileMemoryDebug(&expected.content);
+  }
+
+  return result;
+}
+#endif
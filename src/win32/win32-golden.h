@@ -0,0 +1,65 @@
+#ifndef SRC_WIN32_WIN32_GOLDEN_H_
+#define SRC_WIN32_WIN32_GOLDEN_H_
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const int GOLDEN_FPS = 30;
+static const int GOLDEN_SAMPLES_PER_SECOND = 48000;
+static const int TRAINING_FRAME_COUNT = 1800;
+static const int HARNESS_FILE_COUNT = 4;
+static const int HARNESS_FILE_MAX_NAME = 64;
+
+// Files the game writes during a harness run stay in memory, and only those
+// can be opened again. Every run therefore bakes and streams the same world
+// and music, whatever is on disk and whether or not it ran before.
+struct HarnessFile {
+  char name[HARNESS_FILE_MAX_NAME];
+  uint8_t *content;
+  uint32_t size;
+};
+
+void GetScriptedInput(int frame_idx, GameInput *old_input,
+                      GameInput *new_input);
+void InitHarnessPlatformApi(PlatformApi *platform);
+bool AllocateGameMemory(GameMemory *memory, void *base_address);
+bool ParseTrainingMode(char *command_line);
+int RunTrainingFrames(int frame_count, int width, int height);
+
+#if DEV
+// Pointers inside the game state only hash and restore identically when
+// permanent storage lands at the same address every run.
+static const uint64_t DEV_MEMORY_BASE_ADDRESS = Terabytes((uint64_t)2);
+static const int GOLDEN_FRAME_COUNT = 300;
+static const uint32_t GOLDEN_FILE_MAGIC = 0x46474848;  // "HHGF"
+static const uint32_t GOLDEN_FILE_VERSION = 3;
+
+enum GoldenMode {
+  GOLDEN_MODE_OFF,
+  GOLDEN_MODE_RECORD,
+  GOLDEN_MODE_VERIFY,
+};
+
+struct GoldenFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  int32_t frame_count;
+  int32_t width;
+  int32_t height;
+  int32_t samples_per_frame;
+};
+
+struct GoldenFrameHash {
+  uint64_t frame_hash;
+  uint64_t sound_hash;
+};
+
+GoldenMode ParseGoldenMode(char *command_line);
+uint64_t HashGameBuffer(GameBuffer *buffer);
+uint64_t HashGameSound(GameSoundBuffer *sound_buffer);
+int RunGoldenFrames(GoldenMode mode, wchar_t *golden_file_path,
+                    int frame_count, int width, int height);
+#endif
+
+#endif  // SRC_WIN32_WIN32_GOLDEN_H_
@@ -11,11 +11,24 @@
 #include <cstdio>
 
 #include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-bench.h"
+#include "../../src/win32/win32-capture.h"
 #include "../../src/win32/win32-clock.h"
 #include "../../src/win32/win32-display.h"
 #include "../../src/win32/win32-file-io.h"
+#include "../../src/win32/win32-file-watch.h"
+#include "../../src/win32/win32-golden.h"
 #include "../../src/win32/win32-input.h"
+#include "../../src/win32/win32-latency.h"
+#include "../../src/win32/win32-memory.h"
+#include "../../src/win32/win32-music.h"
+#include "../../src/win32/win32-present.h"
+#include "../../src/win32/win32-replay.h"
+#include "../../src/win32/win32-save-state.h"
 #include "../../src/win32/win32-sound.h"
+#include "../../src/win32/win32-stream.h"
+#include "../../src/win32/win32-telemetry.h"
+#include "../../src/win32/win32-text.h"
 
 void DebugDrawVertical(Buffer *buffer, int x, int top, int bottom,
                        uint32_t color) {
@@ -99,14 +112,11 @@ static inline LRESULT CALLBACK MainWindowCallback(HWND window, UINT message,
 
     case WM_PAINT: {
       PAINTSTRUCT paint;
-      HDC device_context = BeginPaint(window, &paint);
-
-      Dimensions window_dimensions = GetDimensions(window);
-      DisplayBuffer(device_context, 0, 0, window_dimensions.width,
-                    window_dimensions.height, &BUFFER);
-
+      BeginPaint(window, &paint);
       EndPaint(window, &paint);
 
+      RequestRepaint(&PRESENT_QUEUE);
+
       break;
     }
 
@@ -171,11 +181,58 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
   QueryPerformanceFrequency(&perf_count_frequency_result);
   perf_count_frequency = perf_count_frequency_result.QuadPart;
 
+  if (ParseTrainingMode(command_line)) {
+    return RunTrainingFrames(TRAINING_FRAME_COUNT, DEFAULT_WIDTH,
+                             DEFAULT_HEIGHT);
+  }
+
+#if DEV
+  GoldenMode golden_mode = ParseGoldenMode(command_line);
+  if (golden_mode != GOLDEN_MODE_OFF) {
+    wchar_t golden_file_path[] = L"golden-frames.bin";
+    return RunGoldenFrames(golden_mode, golden_file_path, GOLDEN_FRAME_COUNT,
+                           DEFAULT_WIDTH, DEFAULT_HEIGHT);
+  }
+
+  if (ParseBenchMode(command_line)) {
+    wchar_t bench_file_path[] = L"bench.json";
+    return RunBenchmarks(bench_file_path, perf_count_frequency);
+  }
+
+  if (ParseLatencySimMode(command_line)) {
+    return RunLatencySimulation();
+  }
+
+  if (ParseEncodeMusicMode(command_line)) {
+    wchar_t wave_file_path[] = L"music.wav";
+    return RunEncodeMusic(wave_file_path);
+  }
+
+  ReplayMode replay_mode = ParseReplayMode(command_line);
+  if (replay_mode != REPLAY_MODE_OFF) {
+    wchar_t replay_file_path[] = L"replay.bin";
+    if (replay_mode == REPLAY_MODE_SCRIPT) {
+      return RunScriptedReplay(replay_file_path, GOLDEN_FRAME_COUNT,
+                               DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    }
+    return RunReplayVerify(replay_file_path);
+  }
+
+  wchar_t log_file_path[] = L"handmade-hero.log";
+  if (!StartLog(DEBUG_LOG_SINK, log_file_path, DEBUG_LOG_LEVEL,
+                perf_count_frequency)) {
+    OutputDebugStringW(L"Log initialization failed\n");
+  }
+#endif
+
   if (!InitXInput()) {
     OutputDebugStringW(L"XInput initialization failed\n");
     return ERROR_DEVICE_NOT_CONNECTED;
   }
-  ResizeDIBSection(&BUFFER, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+  InitRenderResolution(&RENDER_RESOLUTION, DEFAULT_WIDTH, DEFAULT_HEIGHT,
+                       DEFAULT_RESOLUTION_LEVEL,
+                       DYNAMIC_RESOLUTION && !CAPTURE_ENABLED,
+                       DEFAULT_SCALE_FILTER);
 
   HWND window = GetWindow(instance);
   if (!window) {
@@ -190,16 +247,22 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
     return 1;
   }
 
+  if (!InitPresentQueue(&PRESENT_QUEUE, window, device_context,
+                        DEFAULT_PRESENT_SINK, DEFAULT_WIDTH, DEFAULT_HEIGHT,
+                        perf_count_frequency)) {
+    OutputDebugStringW(L"Present queue initialization failed\n");
+    return 1;
+  }
+
   int default_fps = 30;
   int target_fps = (refresh_rate >= default_fps) ? default_fps : refresh_rate;
   float target_sec_per_frame = 1.0f / static_cast<float>(target_fps);
-  int audio_latency_frames = 4;
 
   SoundOutput sound_output;
   sound_output.secondary_buffer_size =
       sound_output.samples_per_second * sound_output.bytes_per_sample;
-  sound_output.latency_sample_count =
-      audio_latency_frames * sound_output.samples_per_second / target_fps;
+  AudioLatency audio_latency;
+  InitAudioLatency(&audio_latency, &sound_output, target_sec_per_frame);
 
   IDirectSoundBuffer *sound_buffer =
       InitDirectSound(window, sound_output.samples_per_second,
@@ -217,19 +280,29 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
     return 1;
   }
 
-  int16_t *samples = reinterpret_cast<int16_t *>(
-      VirtualAlloc(0, sound_output.secondary_buffer_size,
+  if (!CalibrateAudioLatency(&audio_latency, sound_buffer,
+                             AUDIO_CALIBRATION_SEC, perf_count_frequency)) {
+    OutputDebugStringW(L"Audio cursor calibration failed\n");
+  }
+  sound_output.latency_sample_count = audio_latency.latency_sample_count;
+
+  int max_sample_count =
+      sound_output.secondary_buffer_size / sound_output.bytes_per_sample;
+  float *left_samples = reinterpret_cast<float *>(
+      VirtualAlloc(0, max_sample_count * 2 * sizeof(float),
                    MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
 
-  if (!samples) {
+  if (!left_samples) {
     OutputDebugStringW(L"Samples allocation failed\n");
     return 1;
   }
 
 #if DEV
-  LPVOID base_address = (LPVOID)Terabytes((uint64_t)2);
+  LPVOID base_address = (LPVOID)DEV_MEMORY_BASE_ADDRESS;
+  DWORD allocation_type = MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH;
 #else
   LPVOID base_address = 0;
+  DWORD allocation_type = MEM_RESERVE | MEM_COMMIT;
 #endif
 
   GameMemory memory = {};
@@ -240,7 +313,7 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
 
   memory.permanent_storage =
       VirtualAlloc(base_address, static_cast<size_t>(total_memory_size),
-                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+                   allocation_type, PAGE_READWRITE);
   memory.transient_storage =
       reinterpret_cast<uint8_t *>(memory.permanent_storage) +
       memory.permanent_storage_size;
@@ -252,23 +325,102 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
     return 1;
   }
 
+  InitPlatformApi(&memory.platform);
+#if DEV
+  // A recorded run streams inline, like its replay, so chunks arrive on the
+  // same frames in both.
+  bool is_replay_recording = ParseReplayRecordMode(command_line);
+#else
+  bool is_replay_recording = false;
+#endif
+  if (!is_replay_recording && !StartStreamQueue()) {
+    OutputDebugStringW(L"Stream queue start failed, loading synchronously\n");
+  }
+
+#if DEV
+  // Recovery relies on the fixed base address so the pointers inside the
+  // game state stay valid.
+  wchar_t save_state_file_path[] = L"save-state.bin";
+  if (ParseRecoverMode(command_line)) {
+    if (LoadSaveStateFile(save_state_file_path, memory.permanent_storage,
+                          static_cast<size_t>(memory.permanent_storage_size))) {
+      memory.is_init = true;
+    } else {
+      OutputDebugStringW(L"Save state recovery failed\n");
+    }
+  }
+
+  // Replays start from a fresh game, so a recovered session is not recorded.
+  ReplayRecorder replay_recorder = {};
+  if (is_replay_recording && !memory.is_init) {
+    wchar_t replay_file_path[] = L"replay.bin";
+    if (!StartReplayRecording(&replay_recorder, replay_file_path, &memory,
+                              DEFAULT_WIDTH, DEFAULT_HEIGHT,
+                              sound_output.samples_per_second, true)) {
+      Log(LOG_LEVEL_WARNING, LOG_CATEGORY_FRAME, "Replay recording failed");
+    }
+  }
+
+  SaveState save_state;
+  bool is_save_state_enabled =
+      SAVE_STATE_ENABLED &&
+      InitSaveState(&save_state, memory.permanent_storage,
+                    static_cast<size_t>(memory.permanent_storage_size),
+                    save_state_file_path, perf_count_frequency);
+  float save_state_timer = 0.0f;
+
+  MemoryReport memory_report;
+  bool is_memory_report_enabled =
+      InitMemoryReport(&memory_report, &memory, perf_count_frequency);
+
+  FileWatcher file_watcher;
+  wchar_t watch_directory_path[] = L".";
+  if (!StartFileWatcher(&file_watcher, watch_directory_path,
+                        perf_count_frequency)) {
+    Log(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "File watcher start failed");
+  }
+#endif
+
+  CaptureQueue capture_queue = {};
+  if (CAPTURE_ENABLED) {
+    wchar_t capture_file_path[] = L"capture.y4m";
+    if (!StartCapture(&capture_queue, capture_file_path, DEFAULT_WIDTH,
+                      DEFAULT_HEIGHT, target_fps, CAPTURE_POLICY,
+                      perf_count_frequency)) {
+      OutputDebugStringW(L"Capture initialization failed\n");
+      return 1;
+    }
+  }
+
   GameInput old_input = {};
   GameInput new_input = {};
 
   LARGE_INTEGER last_counter = GetWallClock();
+#if DEV
   int debug_marker_idx = 0;
   DebugTimeMarker debug_markers[15] = {};
+#endif
 
   DWORD last_play_cursor = 0;
   bool is_sound_valid = false;
+  LARGE_INTEGER last_audio_counter = GetWallClock();
 
-#if DEBUG
-  char debug_buffer[256];
+#if DEV
+  TextCache text_cache;
+  bool is_overlay_enabled = SHOW_DEBUG_OVERLAY && InitTextCache(&text_cache);
+  float overlay_ms = 0.0f;
+
+  FrameTelemetry frame_telemetry;
+  InitFrameTelemetry(&frame_telemetry, target_sec_per_frame);
 #endif
 
   uint64_t last_cycle_count = __rdtsc();
 
   while (RUNNING) {
+#if DEV
+    FrameSample *frame_sample = BeginFrameSample(&frame_telemetry);
+#endif
+
     ControllerInput *old_keyboard_controller = GetController(&old_input, 0);
     ControllerInput *new_keyboard_controller = GetController(&new_input, 0);
     *new_keyboard_controller = {};
@@ -287,46 +439,91 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
     SwapInputs(&old_input, &new_input);
 
     DWORD byte_to_lock = 0;
-    DWORD target_cursor = 0;
     DWORD bytes_to_write = 0;
     if (is_sound_valid) {
       byte_to_lock =
           (sound_output.running_sample_idx * sound_output.bytes_per_sample) %
           sound_output.secondary_buffer_size;
-      target_cursor = (last_play_cursor + (sound_output.latency_sample_count *
-                                           sound_output.bytes_per_sample)) %
-                      sound_output.secondary_buffer_size;
-      bytes_to_write = 0;
-
-      if (byte_to_lock > target_cursor) {
-        bytes_to_write = sound_output.secondary_buffer_size - byte_to_lock;
-        bytes_to_write += target_cursor;
-
-      } else {
-        bytes_to_write = target_cursor - byte_to_lock;
-      }
+      bytes_to_write =
+          GetAudioBytesToWrite(&audio_latency, byte_to_lock, last_play_cursor);
     }
 
+    Buffer *backbuffer = AcquireBackbuffer(&PRESENT_QUEUE);
+    SetRenderResolution(backbuffer, GetRenderResolution(&RENDER_RESOLUTION));
+
     GameBuffer game_buffer = {};
-    game_buffer.memory = BUFFER.memory;
-    game_buffer.width = BUFFER.width;
-    game_buffer.height = BUFFER.height;
-    game_buffer.pitch = BUFFER.pitch;
-    game_buffer.bytes_per_pixel = BUFFER.bytes_per_pixel;
+    game_buffer.memory = backbuffer->memory;
+    game_buffer.width = backbuffer->width;
+    game_buffer.height = backbuffer->height;
+    game_buffer.pitch = backbuffer->pitch;
+    game_buffer.bytes_per_pixel = backbuffer->bytes_per_pixel;
+    game_buffer.format = PIXEL_FORMAT_BGRA8;
 
     GameSoundBuffer game_sound_buffer = {};
     game_sound_buffer.samples_per_second = sound_output.samples_per_second;
     game_sound_buffer.sample_count =
         bytes_to_write / sound_output.bytes_per_sample;
-    game_sound_buffer.samples = samples;
+    game_sound_buffer.left_samples = left_samples;
+    game_sound_buffer.right_samples = left_samples + max_sample_count;
 
+    new_input.dt_for_frame = target_sec_per_frame;
+#if DEV
+    // F5 rewinds the game to the last save state snapshot. Transient storage
+    // is left alone; the streamer drops loads that no longer fit the state.
+    if (ConsumeRewindRequest() && is_save_state_enabled &&
+        RestoreSaveState(&save_state)) {
+      Log(LOG_LEVEL_INFO, LOG_CATEGORY_SAVE_STATE,
+          "Rewound to the last snapshot in %.02f ms",
+          save_state.stats.restore_ms);
+      if (replay_recorder.file) {
+        StopReplayRecording(&replay_recorder);
+        Log(LOG_LEVEL_WARNING, LOG_CATEGORY_FRAME,
+            "Replay recording stopped by a rewind");
+      }
+    }
+    PollFileWatcher(&file_watcher, &memory.file_changes);
+    if (replay_recorder.file) {
+      BeginReplayFrame(&replay_recorder, &memory, &new_input);
+    }
+#endif
     UpdateAndRender(&memory, &game_buffer, &game_sound_buffer, &new_input);
+#if DEV
+    if (replay_recorder.file) {
+      EndReplayFrame(&replay_recorder, &memory, &game_buffer,
+                     &game_sound_buffer);
+    }
+#endif
 
     if (is_sound_valid) {
       FillSoundBuffer(sound_buffer, &sound_output, byte_to_lock, bytes_to_write,
                       &game_sound_buffer);
     }
 
+    CaptureBuffer(&capture_queue, backbuffer);
+
+#if DEV
+    if (is_memory_report_enabled) {
+      StepMemoryReport(&memory_report, &memory);
+    }
+
+    if (is_save_state_enabled) {
+      save_state_timer += target_sec_per_frame;
+      if (save_state_timer >= SAVE_STATE_INTERVAL_SEC &&
+          CaptureSaveState(&save_state)) {
+        save_state_timer = 0.0f;
+      }
+      if (StepSaveState(&save_state, SAVE_STATE_PAGES_PER_STEP)) {
+        SaveStateStats *stats = &save_state.stats;
+        Log(LOG_LEVEL_INFO, LOG_CATEGORY_SAVE_STATE,
+            "Save state %lld: %u dirty, %u changed pages, %llu -> %llu "
+            "bytes, %.02f ms capture, %.02f ms compress",
+            stats->snapshot_count, stats->dirty_page_count,
+            stats->changed_page_count, stats->raw_size,
+            stats->compressed_size, stats->capture_ms, stats->compress_ms);
+      }
+    }
+#endif
+
     LARGE_INTEGER work_counter = GetWallClock();
     float elapsed_sec_per_frame_work =
         GetSecondsElapsed(last_counter, work_counter, perf_count_frequency);
@@ -340,40 +537,120 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
         NanoSleep(sleep_ms);
       }
 
+#if DEBUG
       float test_elapsed_sec_for_frame =
           GetSecondsElapsed(last_counter, GetWallClock(), perf_count_frequency);
       Assert(test_elapsed_sec_for_frame < target_sec_per_frame);
+#endif
 
       while (elapsed_sec_per_frame < target_sec_per_frame) {
         elapsed_sec_per_frame = GetSecondsElapsed(last_counter, GetWallClock(),
                                                   perf_count_frequency);
       }
     } else {
-      // missed frame
+#if DEV
+      frame_sample->is_missed = true;
+#endif
     }
 
     LARGE_INTEGER end_counter = GetWallClock();
+#if DEV
     float ms_per_frame = 1000.0f * GetSecondsElapsed(last_counter, end_counter,
                                                      perf_count_frequency);
+#endif
     last_counter = end_counter;
 
-    Dimensions window_dimensions = GetDimensions(window);
-
 #if DEV
-    DebugSyncDisplay(&BUFFER, ArraySize(debug_markers), debug_markers,
+    DebugSyncDisplay(backbuffer, ArraySize(debug_markers), debug_markers,
                      &sound_output, target_sec_per_frame);
+
+    if (is_overlay_enabled) {
+      LARGE_INTEGER overlay_start = GetWallClock();
+      char overlay_line[TEXT_MAX_LENGTH];
+      int line_height = text_cache.atlas.glyph_height;
+
+      snprintf(overlay_line, sizeof(overlay_line), "%6.2f ms/f  %6.1f fps",
+               ms_per_frame, 1000.0f / ms_per_frame);
+      DrawDebugText(backbuffer, &text_cache, 8, 8, overlay_line, 0xFFFFFFFF,
+                    DEBUG_TEXT_BLEND_SPACE);
+      snprintf(overlay_line, sizeof(overlay_line),
+               "%6.2f ms present latency  %6.2f ms audio latency",
+               PRESENT_QUEUE.stats.avg_latency_ms,
+               GetAudioLatencyMs(&audio_latency));
+      DrawDebugText(backbuffer, &text_cache, 8, 8 + line_height, overlay_line,
+                    0xFFFFFFFF, DEBUG_TEXT_BLEND_SPACE);
+      snprintf(overlay_line, sizeof(overlay_line), "render %dx%d",
+               backbuffer->width, backbuffer->height);
+      DrawDebugText(backbuffer, &text_cache, 8, 8 + 2 * line_height,
+                    overlay_line, 0xFFFFFFFF, DEBUG_TEXT_BLEND_SPACE);
+      snprintf(overlay_line, sizeof(overlay_line), "%6.3f ms overlay",
+               overlay_ms);
+      DrawDebugText(backbuffer, &text_cache, 8, 8 + 3 * line_height,
+                    overlay_line, 0xFFFFFFFF, DEBUG_TEXT_BLEND_SPACE);
+      if (is_memory_report_enabled) {
+        MemoryRegionStats *permanent =
+            &memory_report.regions[MEMORY_REGION_PERMANENT];
+        MemoryRegionStats *transient =
+            &memory_report.regions[MEMORY_REGION_TRANSIENT];
+        snprintf(overlay_line, sizeof(overlay_line),
+                 "mem %.1f/%.1f MB perm  %.1f/%.1f MB trans",
+                 permanent->used_high_water / 1048576.0f,
+                 permanent->resident_size / 1048576.0f,
+                 transient->used_high_water / 1048576.0f,
+                 transient->resident_size / 1048576.0f);
+        DrawDebugText(backbuffer, &text_cache, 8, 8 + 4 * line_height,
+                      overlay_line, 0xFFFFFFFF, DEBUG_TEXT_BLEND_SPACE);
+      }
+      FramePercentiles frame_percentiles =
+          GetFramePercentiles(&frame_telemetry, FRAME_METRIC_FRAME);
+      snprintf(overlay_line, sizeof(overlay_line),
+               "p50 %.2f p99 %.2f max %.2f ms  %lld missed  %lld hitches",
+               frame_percentiles.p50_ms, frame_percentiles.p99_ms,
+               frame_percentiles.max_ms,
+               static_cast<long long>(frame_telemetry.missed_frame_count),
+               static_cast<long long>(frame_telemetry.hitch_count));
+      DrawDebugText(backbuffer, &text_cache, 8, 8 + 5 * line_height,
+                    overlay_line, 0xFFFFFFFF, DEBUG_TEXT_BLEND_SPACE);
+      GameStreamStats *stream_stats = &memory.stream_stats;
+      snprintf(overlay_line, sizeof(overlay_line),
+               "stream %u resident  %u in flight  %lld late  %lld missed",
+               stream_stats->resident_count, stream_stats->in_flight_count,
+               static_cast<long long>(stream_stats->late_count),
+               static_cast<long long>(stream_stats->missed_count));
+      DrawDebugText(backbuffer, &text_cache, 8, 8 + 6 * line_height,
+                    overlay_line, 0xFFFFFFFF, DEBUG_TEXT_BLEND_SPACE);
+
+      overlay_ms = 1000.0f * GetSecondsElapsed(overlay_start, GetWallClock(),
+                                               perf_count_frequency);
+    }
 #endif
 
-    DisplayBuffer(device_context, 0, 0, window_dimensions.width,
-                  window_dimensions.height, &BUFFER);
+    SubmitBackbuffer(&PRESENT_QUEUE, RENDER_RESOLUTION.filter);
+
+    UpdateRenderResolution(&RENDER_RESOLUTION, elapsed_sec_per_frame_work,
+                           target_sec_per_frame);
 
     DWORD play_cursor;
     DWORD write_cursor;
     if (SUCCEEDED(
             sound_buffer->GetCurrentPosition(&play_cursor, &write_cursor))) {
+      LARGE_INTEGER audio_counter = GetWallClock();
+      float audio_sec = GetSecondsElapsed(last_audio_counter, audio_counter,
+                                          perf_count_frequency);
+      last_audio_counter = audio_counter;
       last_play_cursor = play_cursor;
 
-      if (!is_sound_valid) {
+      bool is_underrun = UpdateAudioLatency(&audio_latency, play_cursor,
+                                            write_cursor, audio_sec);
+      sound_output.latency_sample_count = audio_latency.latency_sample_count;
+#if DEV
+      if (is_underrun) {
+        Log(LOG_LEVEL_WARNING, LOG_CATEGORY_AUDIO,
+            "Audio underrun %d, latency now %.02f ms",
+            audio_latency.underrun_count, GetAudioLatencyMs(&audio_latency));
+      }
+#endif
+      if (!is_sound_valid || is_underrun) {
         sound_output.running_sample_idx =
             write_cursor / sound_output.bytes_per_sample;
         is_sound_valid = true;
@@ -382,30 +659,12 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
       is_sound_valid = false;
     }
 
-#if 0
-    // 1920 jump, 480 sample
-    {
-      while (RUNNING) {
-        DWORD play_cursor;
-        DWORD write_cursor;
-        sound_buffer->GetCurrentPosition(&play_cursor, &write_cursor);
-
-        snprintf(debug_buffer, sizeof(debug_buffer),
-                 "play_cursor: %lu, write_cursor: %lu\n", play_cursor,
-                 write_cursor);
-        OutputDebugStringA(debug_buffer);
-      }
-    }
-#endif
-
-#if DEBUG
-    {
-      snprintf(debug_buffer, sizeof(debug_buffer),
-               "last_play_cursor: %lu, byte_to_lock: %lu, target_cursor: "
-               "%lu, bytes_to_write: %lu\n",
-               last_play_cursor, byte_to_lock, target_cursor, bytes_to_write);
-      OutputDebugStringA(debug_buffer);
-    }
+#if DEV
+    Log(LOG_LEVEL_DEBUG, LOG_CATEGORY_AUDIO,
+        "last_play_cursor: %lu, byte_to_lock: %lu, bytes_to_write: %lu, "
+        "audio_latency: %.02f ms",
+        last_play_cursor, byte_to_lock, bytes_to_write,
+        GetAudioLatencyMs(&audio_latency));
 #endif
 
 #if DEV
@@ -419,14 +678,22 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
     }
 #endif
 
-    float fps = 1000.0f / ms_per_frame;
-
-#if DEBUG
-    {
-      snprintf(debug_buffer, sizeof(debug_buffer), "%.02f ms/f\t%.02f fps\n",
-               ms_per_frame, fps);
-      OutputDebugStringA(debug_buffer);
-    }
+#if DEV
+    Log(LOG_LEVEL_DEBUG, LOG_CATEGORY_FRAME,
+        "%.02f ms/f\t%.02f fps\t%.02f ms present latency", ms_per_frame,
+        1000.0f / ms_per_frame, PRESENT_QUEUE.stats.avg_latency_ms);
+
+    float work_ms = 1000.0f * elapsed_sec_per_frame_work;
+    frame_sample->metric_ms[FRAME_METRIC_FRAME] = ms_per_frame;
+    frame_sample->metric_ms[FRAME_METRIC_WORK] = work_ms;
+    frame_sample->metric_ms[FRAME_METRIC_SLEEP] = ms_per_frame - work_ms;
+    frame_sample->overlay_ms = overlay_ms;
+    frame_sample->present_latency_ms = PRESENT_QUEUE.stats.avg_latency_ms;
+    frame_sample->audio_latency_ms = GetAudioLatencyMs(&audio_latency);
+    frame_sample->render_width = backbuffer->width;
+    frame_sample->render_height = backbuffer->height;
+    frame_sample->input = new_input;
+    EndFrameSample(&frame_telemetry, frame_sample);
 #endif
 
     uint64_t end_cycle_count = __rdtsc();
@@ -434,6 +701,29 @@ int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prev_instance,
     last_cycle_count = end_cycle_count;
   }
 
+  StopCapture(&capture_queue);
+  StopStreamQueue();
+#if DEV
+  StopFileWatcher(&file_watcher);
+  StopReplayRecording(&replay_recorder);
+  if (is_save_state_enabled) {
+    StopSaveState(&save_state);
+  }
+  if (is_memory_report_enabled) {
+    wchar_t memory_report_file_path[] = L"memory-report.json";
+    if (!WriteMemoryReport(&memory_report, memory_report_file_path)) {
+      Log(LOG_LEVEL_ERROR, LOG_CATEGORY_MEMORY, "Memory report write failed");
+    }
+    StopMemoryReport(&memory_report);
+  }
+  wchar_t frame_telemetry_file_path[] = L"frame-telemetry.json";
+  if (!WriteFrameTelemetryReport(&frame_telemetry,
+                                 frame_telemetry_file_path)) {
+    Log(LOG_LEVEL_ERROR, LOG_CATEGORY_FRAME, "Frame telemetry write failed");
+  }
+  StopLog();
+#endif
+  ShutdownPresentQueue(&PRESENT_QUEUE);
   ReleaseDC(window, device_context);
 
   return 0;
@@ -6,7 +6,11 @@
 
 #include <cstdint>
 
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/win32/win32-capture.h"
 #include "../../src/win32/win32-display.h"
+#include "../../src/win32/win32-log.h"
+#include "../../src/win32/win32-present.h"
 
 #ifndef DEV
 #define DEV 1
@@ -24,10 +28,28 @@ struct DebugTimeMarker {
 static bool RUNNING = true;
 static const int DEFAULT_WIDTH = 1920;
 static const int DEFAULT_HEIGHT = 1080;
+static const int DEFAULT_RESOLUTION_LEVEL = 0;
+static const bool DYNAMIC_RESOLUTION = true;
+static const ScaleFilter DEFAULT_SCALE_FILTER = SCALE_FILTER_BILINEAR;
+static const PresentSink DEFAULT_PRESENT_SINK = PRESENT_SINK_WINDOW;
+static const bool CAPTURE_ENABLED = false;
+static const CapturePolicy CAPTURE_POLICY = CAPTURE_POLICY_DROP;
+static const bool SHOW_DEBUG_OVERLAY = true;
+static const BlendSpace DEBUG_TEXT_BLEND_SPACE = BLEND_SPACE_LINEAR;
+static const bool SAVE_STATE_ENABLED = true;
+static const float SAVE_STATE_INTERVAL_SEC = 5.0f;
+#if DEV
+static const LogSink DEBUG_LOG_SINK = LOG_SINK_FILE;
+static const LogLevel DEBUG_LOG_LEVEL = LOG_LEVEL_DEBUG;
+#endif
 
-static Buffer BUFFER;
+static PresentQueue PRESENT_QUEUE;
+static RenderResolution RENDER_RESOLUTION;
 static int64_t perf_count_frequency;
 
+void DebugDrawVertical(Buffer *buffer, int x, int top, int bottom,
+                       uint32_t color);
+
 static inline LRESULT CALLBACK MainWindowCallback(HWND window, UINT message,
                                                   WPARAM w_param,
                                                   LPARAM l_param);
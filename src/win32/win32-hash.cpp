@@ -0,0 +1,133 @@
+#include "../../src/win32/win32-hash.h"
+
+#include <emmintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+static const uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const int HASH_LANE_COUNT = 4;
+static const size_t HASH_STRIPE_SIZE = HASH_LANE_COUNT * sizeof(__m128i);
+static const int HASH_STRIPES_PER_BLOCK = 16;
+static const uint32_t HASH_SCRAMBLE_PRIME = 0x9E3779B1;
+static const uint32_t HASH_KEY_STEP_WORDS[4] = {0x7FEB352D, 0x846CA68B,
+                                                0x2C1B3C6D, 0x297A2D39};
+
+static const uint32_t HASH_INIT_WORDS[HASH_LANE_COUNT][4] = {
+    {0x85EBCA77, 0xC2B2AE3D, 0x27D4EB2F, 0x165667B1},
+    {0x9E3779B1, 0x85EBCA6B, 0xCC9E2D51, 0x1B873593},
+    {0xE6546B64, 0x38B34AE5, 0xA1B2C3D5, 0x5BD1E995},
+    {0x68E31DA4, 0xB5297A4D, 0x1B56C4E9, 0x7FEB352D},
+};
+static const uint32_t HASH_KEY_WORDS[HASH_LANE_COUNT][4] = {
+    {0xBE4BA423, 0x396CFEB8, 0x1CAD21F7, 0x2C81017C},
+    {0xDB979083, 0x78E5C0CC, 0x4EE6E2CB, 0x85E6F31F},
+    {0x3A9E2A53, 0xB2C6A7DF, 0x7C01812C, 0xF721AD1C},
+    {0xDED46DE9, 0x839097DB, 0x7240A4A4, 0xB7B3671F},
+};
+
+static inline uint64_t MixHash(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+static inline uint64_t CombineHash(uint64_t hash, uint64_t value) {
+  uint64_t result = (hash ^ MixHash(value * HASH_PRIME_2)) * HASH_PRIME_1;
+  return result;
+}
+
+// Folds the high bits back down and multiplies, so sums accumulated in one
+// block do not commute with those of the next.
+static inline __m128i ScrambleAccumulator(__m128i accumulator, __m128i key) {
+  __m128i prime = _mm_set1_epi32(HASH_SCRAMBLE_PRIME);
+  accumulator = _mm_xor_si128(accumulator, _mm_srli_epi64(accumulator, 47));
+  accumulator = _mm_xor_si128(accumulator, key);
+  __m128i low = _mm_mul_epu32(accumulator, prime);
+  __m128i high = _mm_mul_epu32(_mm_srli_epi64(accumulator, 32), prime);
+
+  __m128i result = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+  return result;
+}
+
+// Four independent 128-bit accumulators eat 64 bytes per iteration. Each
+// 64-bit half adds the product of its own two 32-bit words plus the other
+// half's raw data, so every input bit reaches the accumulator. The key
+// advances with every stripe of a block and the accumulators are scrambled
+// between blocks, so moving data to another offset changes the hash.
+uint64_t HashMemory(void *memory, size_t size, uint64_t seed) {
+  uint8_t *at = reinterpret_cast<uint8_t *>(memory);
+  uint64_t seed_words[2] = {seed, seed ^ HASH_PRIME_2};
+
+  __m128i seed_lanes = _mm_loadu_si128(reinterpret_cast<__m128i *>(seed_words));
+  __m128i accumulators[HASH_LANE_COUNT];
+  __m128i keys[HASH_LANE_COUNT];
+  for (int i = 0; i < HASH_LANE_COUNT; ++i) {
+    __m128i init = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(HASH_INIT_WORDS[i]));
+    accumulators[i] = _mm_xor_si128(init, seed_lanes);
+    keys[i] = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(HASH_KEY_WORDS[i]));
+  }
+
+  __m128i key_step =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(HASH_KEY_STEP_WORDS));
+  __m128i stripe_keys[HASH_LANE_COUNT];
+  for (int i = 0; i < HASH_LANE_COUNT; ++i) {
+    stripe_keys[i] = keys[i];
+  }
+
+  size_t stripe_count = size / HASH_STRIPE_SIZE;
+  int block_stripe = 0;
+  for (size_t stripe = 0; stripe < stripe_count; ++stripe) {
+    for (int i = 0; i < HASH_LANE_COUNT; ++i) {
+      __m128i data = _mm_loadu_si128(reinterpret_cast<__m128i *>(at) + i);
+      __m128i keyed = _mm_xor_si128(data, stripe_keys[i]);
+      __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+      __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+      accumulators[i] =
+          _mm_add_epi64(accumulators[i], _mm_add_epi64(product, swapped));
+      stripe_keys[i] = _mm_add_epi32(stripe_keys[i], key_step);
+    }
+    at += HASH_STRIPE_SIZE;
+
+    if (++block_stripe == HASH_STRIPES_PER_BLOCK) {
+      for (int i = 0; i < HASH_LANE_COUNT; ++i) {
+        accumulators[i] = ScrambleAccumulator(accumulators[i], keys[i]);
+        stripe_keys[i] = keys[i];
+      }
+      block_stripe = 0;
+    }
+  }
+
+  uint64_t hash = seed ^ (static_cast<uint64_t>(size) * HASH_PRIME_1);
+  for (int i = 0; i < HASH_LANE_COUNT; ++i) {
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), accumulators[i]);
+    hash = CombineHash(hash, lanes[0]);
+    hash = CombineHash(hash, lanes[1]);
+  }
+
+  size_t remaining = size - stripe_count * HASH_STRIPE_SIZE;
+  while (remaining >= sizeof(uint64_t)) {
+    uint64_t value;
+    memcpy(&value, at, sizeof(value));
+    hash = CombineHash(hash, value);
+    at += sizeof(value);
+    remaining -= sizeof(value);
+  }
+
+  if (remaining) {
+    uint64_t value = 0;
+    memcpy(&value, at, remaining);
+    hash = CombineHash(hash, value);
+  }
+
+  uint64_t result = MixHash(hash);
+  return result;
+}
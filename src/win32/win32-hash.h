@@ -0,0 +1,9 @@
+#ifndef SRC_WIN32_WIN32_HASH_H_
+#define SRC_WIN32_WIN32_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+uint64_t HashMemory(void *memory, size_t size, uint64_t seed);
+
+#endif  // SRC_WIN32_WIN32_HASH_H_
@@ -5,6 +5,9 @@
 
 static XInputGetStateT *DyXInputGetState;
 static XInputSetStateT *DyXInputSetState;
+#if DEV
+static bool REWIND_REQUESTED;
+#endif
 
 bool InitXInput() {
   HMODULE xinput_lib = LoadLibraryW(L"xinput1_4.dll");
@@ -57,6 +60,12 @@ bool ProcessPendingMessages(ControllerInput *keyboard_controller) {
           break;
         }
 
+#if DEV
+        if (vk_code == VK_F5 && is_key_down && !was_key_down) {
+          REWIND_REQUESTED = true;
+        }
+#endif
+
         if (was_key_down != is_key_down) {
           HandleKeyboard(keyboard_controller, vk_code, is_key_down);
         }
@@ -74,6 +83,14 @@ bool ProcessPendingMessages(ControllerInput *keyboard_controller) {
   return result;
 }
 
+#if DEV
+bool ConsumeRewindRequest() {
+  bool result = REWIND_REQUESTED;
+  REWIND_REQUESTED = false;
+  return result;
+}
+#endif
+
 static inline void ProcessXInputDigitalButton(ButtonState *old_state,
                                               ButtonState *new_state,
                                               DWORD xinput_button_state,
@@ -150,8 +167,7 @@ static inline void HandleKeyboard(ControllerInput *keyboard_controller,
   }
 }
 
-static inline float ProcessXInputStickPosition(SHORT raw_stick_value,
-                                               SHORT deadzone) {
+float ProcessXInputStickPosition(SHORT raw_stick_value, SHORT deadzone) {
   float stick_value;
   if (raw_stick_value < -deadzone) {
     stick_value =
@@ -13,6 +13,9 @@ typedef DWORD WINAPI XInputSetStateT(DWORD controller_idx,
 
 bool InitXInput();
 bool ProcessPendingMessages(ControllerInput *keyboard_controller);
+#if DEV
+bool ConsumeRewindRequest();
+#endif
 static inline void ProcessXInputDigitalButton(ButtonState *old_state,
                                               ButtonState *new_state,
                                               DWORD xinput_button_state,
@@ -22,8 +25,7 @@ static inline void ProcessKeyboardMessage(ButtonState *new_state,
                                           uint32_t button_code);
 static inline void HandleKeyboard(ControllerInput *keyboard_controller,
                                   uint32_t vk_code, bool is_key_down);
-static inline float ProcessXInputStickPosition(SHORT raw_stick_value,
-                                               SHORT deadzone);
+float ProcessXInputStickPosition(SHORT raw_stick_value, SHORT deadzone);
 void HandleGamepad(GameInput *old_input, GameInput *new_input);
 void SwapInputs(GameInput *old_input, GameInput *new_input);
 
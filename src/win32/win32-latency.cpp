@@ -0,0 +1,323 @@
+#include "../../src/win32/win32-latency.h"
+
+#include <dsound.h>
+#include <math.h>
+#include <windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-clock.h"
+#include "../../src/win32/win32-sound.h"
+
+static uint32_t GetCursorDistance(AudioLatency *latency, DWORD from, DWORD to) {
+  uint32_t result = (to + latency->buffer_size - from) % latency->buffer_size;
+  return result;
+}
+
+static void ComputeAudioLatency(AudioLatency *latency) {
+  uint32_t bytes_per_second =
+      latency->samples_per_second * latency->bytes_per_sample;
+  uint32_t granularity = latency->cursor_granularity;
+  if (!granularity) {
+    granularity =
+        static_cast<uint32_t>(AUDIO_DEFAULT_GRANULARITY_SEC * bytes_per_second);
+  }
+
+  float frame_sec_deviation = sqrtf(latency->frame_sec_variance);
+  latency->frame_sec_budget =
+      latency->frame_sec_mean + AUDIO_FRAME_TIME_SIGMAS * frame_sec_deviation;
+  uint32_t latency_bytes =
+      latency->write_ahead + granularity + latency->margin +
+      static_cast<uint32_t>(latency->frame_sec_budget * bytes_per_second);
+
+  uint32_t max_latency_bytes =
+      static_cast<uint32_t>(AUDIO_MAX_LATENCY_SEC * bytes_per_second);
+  if (max_latency_bytes > latency->buffer_size / 2) {
+    max_latency_bytes = latency->buffer_size / 2;
+  }
+  if (latency_bytes > max_latency_bytes) {
+    latency_bytes = max_latency_bytes;
+  }
+
+  latency->latency_sample_count =
+      (latency_bytes + latency->bytes_per_sample - 1) /
+      latency->bytes_per_sample;
+}
+
+void InitAudioLatency(AudioLatency *latency, SoundOutput *sound_output,
+                      float target_sec_per_frame) {
+  *latency = {};
+  latency->buffer_size = sound_output->secondary_buffer_size;
+  latency->bytes_per_sample = sound_output->bytes_per_sample;
+  latency->samples_per_second = sound_output->samples_per_second;
+  latency->frame_sec_mean = target_sec_per_frame;
+  ComputeAudioLatency(latency);
+}
+
+// Cursor samples taken in a tight loop: the smallest play cursor step is the
+// granularity the device reports its position in.
+void AddAudioCursorSample(AudioLatency *latency, DWORD play_cursor,
+                          DWORD write_cursor) {
+  if (latency->is_cursor_valid && play_cursor != latency->last_play_cursor) {
+    uint32_t step =
+        GetCursorDistance(latency, latency->last_play_cursor, play_cursor);
+    if (!latency->cursor_granularity || step < latency->cursor_granularity) {
+      latency->cursor_granularity = step;
+    }
+  }
+
+  uint32_t write_ahead = GetCursorDistance(latency, play_cursor, write_cursor);
+  if (write_ahead > latency->write_ahead) {
+    latency->write_ahead = write_ahead;
+  }
+
+  latency->last_play_cursor = play_cursor;
+  latency->is_cursor_valid = true;
+}
+
+bool CalibrateAudioLatency(AudioLatency *latency,
+                           IDirectSoundBuffer *sound_buffer, float seconds,
+                           int64_t perf_count_frequency) {
+  LARGE_INTEGER start_counter = GetWallClock();
+  while (GetSecondsElapsed(start_counter, GetWallClock(),
+                           perf_count_frequency) < seconds) {
+    DWORD play_cursor;
+    DWORD write_cursor;
+    if (!SUCCEEDED(
+            sound_buffer->GetCurrentPosition(&play_cursor, &write_cursor))) {
+      return false;
+    }
+    AddAudioCursorSample(latency, play_cursor, write_cursor);
+  }
+
+  latency->is_cursor_valid = false;
+  ComputeAudioLatency(latency);
+  return latency->cursor_granularity != 0;
+}
+
+DWORD GetAudioBytesToWrite(AudioLatency *latency, DWORD byte_to_lock,
+                           DWORD play_cursor) {
+  uint32_t lead = GetCursorDistance(latency, play_cursor, byte_to_lock);
+  uint32_t latency_bytes =
+      latency->latency_sample_count * latency->bytes_per_sample;
+
+  DWORD result = 0;
+  if (lead < latency_bytes) {
+    result = latency_bytes - lead;
+  }
+
+  latency->lead = lead + result;
+  latency->is_lead_valid = true;
+  return result;
+}
+
+// Called once per frame with the cursors measured after the frame's sound was
+// written. Returns true when the write cursor passed the end of the written
+// audio, so the device already committed stale samples and the caller has to
+// restart writing at the write cursor. Only
+// underruns in frames that stayed within the frame time budget widen the
+// margin; a hitch past the budget is not something more latency should hide.
+bool UpdateAudioLatency(AudioLatency *latency, DWORD play_cursor,
+                        DWORD write_cursor, float frame_sec) {
+  bool result = false;
+  if (latency->is_cursor_valid && latency->is_lead_valid) {
+    uint32_t write_reach =
+        GetCursorDistance(latency, latency->last_play_cursor, write_cursor);
+    if (write_reach > latency->lead) {
+      result = true;
+      ++latency->underrun_count;
+      if (frame_sec <= latency->frame_sec_budget) {
+        latency->margin +=
+            latency->cursor_granularity ? latency->cursor_granularity
+                                        : latency->bytes_per_sample * 64;
+        latency->clean_frame_count = 0;
+      }
+    } else if (++latency->clean_frame_count >= AUDIO_MARGIN_RECOVERY_FRAMES) {
+      latency->margin /= 2;
+      latency->clean_frame_count = 0;
+    }
+  }
+
+  uint32_t write_ahead = GetCursorDistance(latency, play_cursor, write_cursor);
+  if (write_ahead > latency->write_ahead) {
+    latency->write_ahead = write_ahead;
+  } else {
+    latency->write_ahead -=
+        (latency->write_ahead - write_ahead) / AUDIO_WRITE_AHEAD_DECAY;
+  }
+
+  // A hitch longer than the latency cap cannot be covered anyway, so it is not
+  // allowed to inflate the variance for the frames after it.
+  if (frame_sec > AUDIO_MAX_LATENCY_SEC) {
+    frame_sec = AUDIO_MAX_LATENCY_SEC;
+  }
+  float delta = frame_sec - latency->frame_sec_mean;
+  latency->frame_sec_mean += AUDIO_FRAME_TIME_SMOOTHING * delta;
+  latency->frame_sec_variance =
+      (1.0f - AUDIO_FRAME_TIME_SMOOTHING) *
+      (latency->frame_sec_variance +
+       AUDIO_FRAME_TIME_SMOOTHING * delta * delta);
+
+  latency->last_play_cursor = play_cursor;
+  latency->is_cursor_valid = true;
+  latency->is_lead_valid = false;
+  ComputeAudioLatency(latency);
+  return result;
+}
+
+float GetAudioLatencyMs(AudioLatency *latency) {
+  float result = 1000.0f * latency->latency_sample_count /
+                 static_cast<float>(latency->samples_per_second);
+  return result;
+}
+
+#if DEV
+static const LatencySimScenario LATENCY_SIM_SCENARIOS[] = {
+    {0.0f, 0}, {1.0f, 0}, {2.0f, 0}, {5.0f, 0}, {10.0f, 0}, {5.0f, 300},
+};
+
+bool ParseLatencySimMode(char *command_line) {
+  bool result = command_line && strstr(command_line, "-latency-sim") != 0;
+  return result;
+}
+
+static uint64_t GetSimulatedPlayPosition(SimulatedAudioDevice *device) {
+  uint64_t result =
+      static_cast<uint64_t>(device->time_sec * device->bytes_per_second);
+  result -= result % device->granularity;
+  return result;
+}
+
+static void GetSimulatedCursors(SimulatedAudioDevice *device,
+                                DWORD *play_cursor, DWORD *write_cursor) {
+  uint64_t play_position = GetSimulatedPlayPosition(device);
+  *play_cursor = static_cast<DWORD>(play_position % device->buffer_size);
+  *write_cursor = static_cast<DWORD>((play_position + device->write_ahead) %
+                                     device->buffer_size);
+}
+
+// Follows the frame loop in WinMain: the sound for a frame is written right
+// after the previous frame measured the cursors, then the frame takes its
+// jittered time. A glitch is a frame after which the device's write cursor
+// has passed the end of the written audio, so it committed stale samples.
+LatencySimResult RunLatencySimScenario(LatencySimScenario *scenario,
+                                       uint32_t random_seed) {
+  SoundOutput sound_output;
+  sound_output.secondary_buffer_size =
+      sound_output.samples_per_second * sound_output.bytes_per_sample;
+
+  SimulatedAudioDevice device = {};
+  device.buffer_size = sound_output.secondary_buffer_size;
+  device.bytes_per_second =
+      sound_output.samples_per_second * sound_output.bytes_per_sample;
+  device.granularity = static_cast<uint32_t>(LATENCY_SIM_GRANULARITY_SEC *
+                                             device.bytes_per_second);
+  device.write_ahead = static_cast<uint32_t>(LATENCY_SIM_WRITE_AHEAD_SEC *
+                                             device.bytes_per_second);
+
+  float target_sec_per_frame = 1.0f / LATENCY_SIM_FPS;
+  AudioLatency latency;
+  InitAudioLatency(&latency, &sound_output, target_sec_per_frame);
+
+  while (device.time_sec < AUDIO_CALIBRATION_SEC) {
+    DWORD play_cursor;
+    DWORD write_cursor;
+    GetSimulatedCursors(&device, &play_cursor, &write_cursor);
+    AddAudioCursorSample(&latency, play_cursor, write_cursor);
+    device.time_sec += LATENCY_SIM_SAMPLE_STEP_SEC;
+  }
+  latency.is_cursor_valid = false;
+  ComputeAudioLatency(&latency);
+
+  LatencySimResult result = {};
+  result.min_latency_ms = GetAudioLatencyMs(&latency);
+  result.max_latency_ms = result.min_latency_ms;
+
+  uint32_t random_state = random_seed;
+  uint64_t written_position = 0;
+  DWORD last_play_cursor = 0;
+  bool is_sound_valid = false;
+  float latency_ms_sum = 0.0f;
+
+  for (int frame_idx = 0; frame_idx < LATENCY_SIM_FRAME_COUNT; ++frame_idx) {
+    if (is_sound_valid) {
+      DWORD byte_to_lock =
+          static_cast<DWORD>(written_position % device.buffer_size);
+      written_position +=
+          GetAudioBytesToWrite(&latency, byte_to_lock, last_play_cursor);
+    }
+
+    float frame_sec = target_sec_per_frame + 0.001f * scenario->jitter_ms *
+                                                 RandomBilateral(&random_state);
+    if (scenario->hitch_interval &&
+        (frame_idx + 1) % scenario->hitch_interval == 0) {
+      frame_sec += LATENCY_SIM_HITCH_SEC;
+    }
+    device.time_sec += frame_sec;
+
+    uint64_t write_position =
+        GetSimulatedPlayPosition(&device) + device.write_ahead;
+    if (is_sound_valid && write_position > written_position) {
+      ++result.glitch_count;
+    }
+
+    DWORD play_cursor;
+    DWORD write_cursor;
+    GetSimulatedCursors(&device, &play_cursor, &write_cursor);
+    last_play_cursor = play_cursor;
+
+    bool is_underrun =
+        UpdateAudioLatency(&latency, play_cursor, write_cursor, frame_sec);
+    if (!is_sound_valid || is_underrun) {
+      written_position = write_position;
+      is_sound_valid = true;
+    }
+
+    float latency_ms = GetAudioLatencyMs(&latency);
+    latency_ms_sum += latency_ms;
+    if (latency_ms < result.min_latency_ms) {
+      result.min_latency_ms = latency_ms;
+    }
+    if (latency_ms > result.max_latency_ms) {
+      result.max_latency_ms = latency_ms;
+    }
+  }
+
+  result.final_latency_ms = GetAudioLatencyMs(&latency);
+  result.mean_latency_ms = latency_ms_sum / LATENCY_SIM_FRAME_COUNT;
+  result.underrun_count = latency.underrun_count;
+  return result;
+}
+
+// Hitch-free scenarios must run without glitches; the hitch scenario only
+// reports how the tracker recovers. In every scenario the tracker has to
+// report exactly the glitches the device produced.
+int RunLatencySimulation() {
+  char debug_buffer[256];
+  int result = 0;
+
+  for (int i = 0; i < ArraySize(LATENCY_SIM_SCENARIOS); ++i) {
+    LatencySimScenario scenario = LATENCY_SIM_SCENARIOS[i];
+    LatencySimResult sim = RunLatencySimScenario(&scenario, 0x2545F491);
+
+    snprintf(debug_buffer, sizeof(debug_buffer),
+             "Latency sim: jitter %4.1f ms, hitch every %3d frames: latency "
+             "%5.1f ms (min %5.1f, mean %5.1f, max %5.1f), %d underruns, "
+             "%d glitches\n",
+             scenario.jitter_ms, scenario.hitch_interval,
+             sim.final_latency_ms, sim.min_latency_ms, sim.mean_latency_ms,
+             sim.max_latency_ms, sim.underrun_count, sim.glitch_count);
+    OutputDebugStringA(debug_buffer);
+
+    if ((!scenario.hitch_interval && sim.glitch_count) ||
+        sim.underrun_count != sim.glitch_count) {
+      result = 1;
+    }
+  }
+
+  return result;
+}
+#endif
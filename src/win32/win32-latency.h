@@ -0,0 +1,96 @@
+#ifndef SRC_WIN32_WIN32_LATENCY_H_
+#define SRC_WIN32_WIN32_LATENCY_H_
+
+#include <dsound.h>
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/win32/win32-sound.h"
+
+static const float AUDIO_CALIBRATION_SEC = 0.1f;
+static const float AUDIO_DEFAULT_GRANULARITY_SEC = 0.01f;
+static const float AUDIO_MAX_LATENCY_SEC = 0.25f;
+static const float AUDIO_FRAME_TIME_SIGMAS = 3.0f;
+static const float AUDIO_FRAME_TIME_SMOOTHING = 1.0f / 16.0f;
+static const uint32_t AUDIO_WRITE_AHEAD_DECAY = 64;
+static const int AUDIO_MARGIN_RECOVERY_FRAMES = 300;
+
+// Picks the smallest write-ahead past the last measured play cursor that
+// still covers the device's write cursor distance, the granularity the play
+// cursor moves in and the time until the next frame writes again. Underruns
+// widen a safety margin that halves again after a stretch of clean frames.
+struct AudioLatency {
+  uint32_t buffer_size;
+  int bytes_per_sample;
+  int samples_per_second;
+
+  uint32_t cursor_granularity;
+  uint32_t write_ahead;
+  uint32_t margin;
+  float frame_sec_mean;
+  float frame_sec_variance;
+  float frame_sec_budget;
+  int clean_frame_count;
+  int underrun_count;
+
+  DWORD last_play_cursor;
+  uint32_t lead;
+  bool is_cursor_valid;
+  bool is_lead_valid;
+  int latency_sample_count;
+};
+
+void InitAudioLatency(AudioLatency *latency, SoundOutput *sound_output,
+                      float target_sec_per_frame);
+void AddAudioCursorSample(AudioLatency *latency, DWORD play_cursor,
+                          DWORD write_cursor);
+bool CalibrateAudioLatency(AudioLatency *latency,
+                           IDirectSoundBuffer *sound_buffer, float seconds,
+                           int64_t perf_count_frequency);
+DWORD GetAudioBytesToWrite(AudioLatency *latency, DWORD byte_to_lock,
+                           DWORD play_cursor);
+bool UpdateAudioLatency(AudioLatency *latency, DWORD play_cursor,
+                        DWORD write_cursor, float frame_sec);
+float GetAudioLatencyMs(AudioLatency *latency);
+
+#if DEV
+static const int LATENCY_SIM_FRAME_COUNT = 1800;
+static const float LATENCY_SIM_FPS = 30.0f;
+static const float LATENCY_SIM_GRANULARITY_SEC = 0.01f;
+static const float LATENCY_SIM_WRITE_AHEAD_SEC = 0.03f;
+static const float LATENCY_SIM_SAMPLE_STEP_SEC = 0.0005f;
+static const float LATENCY_SIM_HITCH_SEC = 0.1f;
+
+// A device whose play cursor moves in fixed steps and whose write cursor
+// stays a fixed distance ahead of it, driven by a simulated clock instead of
+// DirectSound.
+struct SimulatedAudioDevice {
+  uint32_t buffer_size;
+  uint32_t bytes_per_second;
+  uint32_t granularity;
+  uint32_t write_ahead;
+  double time_sec;
+};
+
+struct LatencySimScenario {
+  float jitter_ms;
+  int hitch_interval;
+};
+
+struct LatencySimResult {
+  float final_latency_ms;
+  float min_latency_ms;
+  float max_latency_ms;
+  float mean_latency_ms;
+  int underrun_count;
+  int glitch_count;
+};
+
+bool ParseLatencySimMode(char *command_line);
+LatencySimResult RunLatencySimScenario(LatencySimScenario *scenario,
+                                       uint32_t random_seed);
+int RunLatencySimulation();
+#endif
+
+#endif  // SRC_WIN32_WIN32_LATENCY_H_
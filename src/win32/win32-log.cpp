@@ -0,0 +1,421 @@
+#include "../../src/win32/win32-log.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../../src/win32/win32-clock.h"
+
+#if DEV
+static const char *LOG_LEVEL_NAMES[LOG_LEVEL_COUNT] = {"debug", "info",
+                                                       "warning", "error"};
+static const char *LOG_CATEGORY_NAMES[LOG_CATEGORY_COUNT] = {
+    "frame", "audio", "save-state", "memory", "asset"};
+
+static Logger LOGGER;
+static thread_local LogRing *THREAD_LOG_RING;
+static thread_local bool IS_THREAD_LOG_RING_ASSIGNED;
+
+// Threads claim a ring on their first record. Threads past
+// LOG_MAX_THREAD_COUNT get none and their records count as dropped.
+static LogRing *GetThreadLogRing() {
+  if (!IS_THREAD_LOG_RING_ASSIGNED) {
+    LONG ring_idx = InterlockedIncrement(&LOGGER.ring_count) - 1;
+    if (ring_idx < LOG_MAX_THREAD_COUNT) {
+      THREAD_LOG_RING = &LOGGER.rings[ring_idx];
+    }
+    IS_THREAD_LOG_RING_ASSIGNED = true;
+  }
+  return THREAD_LOG_RING;
+}
+
+static LogRecord *GetLogRecord(LogRing *ring, int64_t idx) {
+  LogRecord *result = &ring->records[idx & (LOG_RING_RECORD_COUNT - 1)];
+  return result;
+}
+
+bool IsLogEnabled(LogLevel level, LogCategory category) {
+  bool result = LOGGER.is_running && level >= LOGGER.min_level &&
+                (LOGGER.category_mask & (1u << category));
+  return result;
+}
+
+void WriteLogRecord(LogLevel level, LogCategory category, const char *format,
+                    LogArg *args, int arg_count) {
+  LogRing *ring = GetThreadLogRing();
+  if (!ring) {
+    InterlockedIncrement(&LOGGER.unregistered_dropped_count);
+    return;
+  }
+
+  int64_t write_idx = ring->write_idx;
+  if (write_idx - ring->read_idx >= LOG_RING_RECORD_COUNT) {
+    ring->dropped_count = ring->dropped_count + 1;
+    return;
+  }
+
+  LogRecord *record = GetLogRecord(ring, write_idx);
+  record->timestamp = GetWallClock().QuadPart;
+  record->format = format;
+  record->level = static_cast<uint8_t>(level);
+  record->category = static_cast<uint8_t>(category);
+  record->arg_count = static_cast<uint8_t>(arg_count);
+  record->thread_idx = static_cast<uint8_t>(ring - LOGGER.rings);
+  record->arg_types = 0;
+  for (int i = 0; i < arg_count; ++i) {
+    record->arg_types |= static_cast<uint32_t>(args[i].type) << (4 * i);
+    record->args[i] = args[i].u;
+  }
+
+  // Publish the record only after its contents are written.
+  _ReadWriteBarrier();
+  ring->write_idx = write_idx + 1;
+}
+
+static int AppendLogArg(char *dest, int dest_capacity, char *spec,
+                        int spec_size, char conversion, LogArgType type,
+                        uint64_t value) {
+  const char *length = "";
+  bool is_valid = false;
+  switch (conversion) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+      length = "ll";
+      is_valid = type == LOG_ARG_INT || type == LOG_ARG_UINT;
+      break;
+    case 'c':
+      is_valid = type == LOG_ARG_INT || type == LOG_ARG_UINT;
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      is_valid = type == LOG_ARG_FLOAT;
+      break;
+    case 's':
+      is_valid = type == LOG_ARG_STRING;
+      break;
+    case 'p':
+      is_valid = type == LOG_ARG_POINTER || type == LOG_ARG_STRING;
+      break;
+  }
+
+  if (!is_valid) {
+    int result = snprintf(dest, dest_capacity, "<bad %%%c arg>", conversion);
+    return result;
+  }
+
+  snprintf(spec + spec_size, 8, "%s%c", length, conversion);
+
+  int result = 0;
+  LogArg arg;
+  arg.u = value;
+  switch (type) {
+    case LOG_ARG_INT:
+      if (conversion == 'c') {
+        result = snprintf(dest, dest_capacity, spec, static_cast<int>(arg.i));
+      } else {
+        result = snprintf(dest, dest_capacity, spec,
+                          static_cast<long long>(arg.i));
+      }
+      break;
+    case LOG_ARG_UINT:
+      if (conversion == 'c') {
+        result = snprintf(dest, dest_capacity, spec, static_cast<int>(arg.u));
+      } else {
+        result = snprintf(dest, dest_capacity, spec,
+                          static_cast<unsigned long long>(arg.u));
+      }
+      break;
+    case LOG_ARG_FLOAT:
+      result = snprintf(dest, dest_capacity, spec, arg.f);
+      break;
+    case LOG_ARG_STRING:
+      if (conversion == 's') {
+        result = snprintf(dest, dest_capacity, spec, arg.s ? arg.s : "(null)");
+      } else {
+        result = snprintf(dest, dest_capacity, spec, arg.p);
+      }
+      break;
+    default:
+      result = snprintf(dest, dest_capacity, spec, arg.p);
+      break;
+  }
+  return result;
+}
+
+// Expands the record's printf-style format with its captured arguments.
+// Length modifiers in the format are ignored since integers are always
+// captured as 64-bit values.
+int FormatLogRecord(LogRecord *record, char *dest, int dest_capacity) {
+  int64_t elapsed = record->timestamp - LOGGER.start_counter;
+  double seconds = static_cast<double>(elapsed) /
+                   static_cast<double>(LOGGER.perf_count_frequency);
+  int capacity = dest_capacity - 1;
+  int size = snprintf(dest, capacity, "%10.4f %-7s %-10s ", seconds,
+                      LOG_LEVEL_NAMES[record->level],
+                      LOG_CATEGORY_NAMES[record->category]);
+  if (size > capacity - 1) {
+    size = capacity - 1;
+  }
+
+  const char *at = record->format;
+  int arg_idx = 0;
+  while (*at && size < capacity - 1) {
+    if (*at != '%') {
+      dest[size++] = *at++;
+      continue;
+    }
+    if (at[1] == '%') {
+      dest[size++] = '%';
+      at += 2;
+      continue;
+    }
+
+    char spec[32];
+    int spec_size = 0;
+    spec[spec_size++] = *at++;
+    while (*at && strchr("-+ #0", *at) && spec_size < 8) {
+      spec[spec_size++] = *at++;
+    }
+    while (*at >= '0' && *at <= '9' && spec_size < 16) {
+      spec[spec_size++] = *at++;
+    }
+    if (*at == '.') {
+      spec[spec_size++] = *at++;
+      while (*at >= '0' && *at <= '9' && spec_size < 24) {
+        spec[spec_size++] = *at++;
+      }
+    }
+    while (*at && strchr("hlLzjtI", *at)) {
+      bool is_sized = *at == 'I';
+      ++at;
+      while (is_sized && *at >= '0' && *at <= '9') {
+        ++at;
+      }
+    }
+
+    char conversion = *at;
+    if (!conversion) {
+      break;
+    }
+    ++at;
+
+    int arg_size = 0;
+    if (arg_idx < record->arg_count) {
+      LogArgType type =
+          static_cast<LogArgType>((record->arg_types >> (4 * arg_idx)) & 0xF);
+      arg_size = AppendLogArg(dest + size, capacity - 1 - size, spec,
+                              spec_size, conversion, type,
+                              record->args[arg_idx]);
+      ++arg_idx;
+    } else {
+      arg_size = snprintf(dest + size, capacity - 1 - size, "<missing>");
+    }
+
+    size += arg_size;
+    if (size > capacity - 1) {
+      size = capacity - 1;
+    }
+  }
+
+  dest[size++] = '\n';
+  dest[size] = 0;
+  return size;
+}
+
+static void FlushLogOutput(Logger *logger) {
+  if (!logger->output_size) {
+    return;
+  }
+
+  if (logger->sink == LOG_SINK_DEBUGGER) {
+    logger->output_buffer[logger->output_size] = 0;
+    OutputDebugStringA(logger->output_buffer);
+  } else {
+    DWORD bytes_written = 0;
+    WriteFile(logger->output, logger->output_buffer,
+              static_cast<DWORD>(logger->output_size), &bytes_written, 0);
+    logger->stats.bytes_written += bytes_written;
+  }
+  logger->output_size = 0;
+}
+
+static void AppendLogOutput(Logger *logger, char *line, int line_size) {
+  if (logger->output_size + line_size >= LOG_OUTPUT_BUFFER_SIZE) {
+    FlushLogOutput(logger);
+  }
+  memcpy(logger->output_buffer + logger->output_size, line, line_size);
+  logger->output_size += line_size;
+}
+
+// Merges the rings in timestamp order so records from different threads come
+// out interleaved the way they were logged.
+static void DrainLog(Logger *logger) {
+  LARGE_INTEGER flush_start = GetWallClock();
+
+  int ring_count = logger->ring_count;
+  if (ring_count > LOG_MAX_THREAD_COUNT) {
+    ring_count = LOG_MAX_THREAD_COUNT;
+  }
+
+  int64_t read_indices[LOG_MAX_THREAD_COUNT];
+  int64_t write_indices[LOG_MAX_THREAD_COUNT];
+  for (int i = 0; i < ring_count; ++i) {
+    read_indices[i] = logger->rings[i].read_idx;
+    write_indices[i] = logger->rings[i].write_idx;
+  }
+  _ReadWriteBarrier();
+
+  char line[LOG_MAX_LINE_LENGTH];
+  while (true) {
+    int oldest_idx = -1;
+    LogRecord *oldest = 0;
+    for (int i = 0; i < ring_count; ++i) {
+      if (read_indices[i] == write_indices[i]) {
+        continue;
+      }
+      LogRecord *record = GetLogRecord(&logger->rings[i], read_indices[i]);
+      if (!oldest || record->timestamp < oldest->timestamp) {
+        oldest = record;
+        oldest_idx = i;
+      }
+    }
+    if (!oldest) {
+      break;
+    }
+
+    int line_size = FormatLogRecord(oldest, line, sizeof(line));
+    AppendLogOutput(logger, line, line_size);
+    ++logger->stats.records_written;
+
+    _ReadWriteBarrier();
+    logger->rings[oldest_idx].read_idx = ++read_indices[oldest_idx];
+  }
+
+  int64_t dropped_count = logger->unregistered_dropped_count;
+  for (int i = 0; i < ring_count; ++i) {
+    dropped_count += logger->rings[i].dropped_count;
+  }
+  if (dropped_count > logger->reported_dropped_count) {
+    int64_t elapsed = GetWallClock().QuadPart - logger->start_counter;
+    int line_size = snprintf(
+        line, sizeof(line), "%10.4f %-7s %-10s %lld records dropped\n",
+        static_cast<double>(elapsed) /
+            static_cast<double>(logger->perf_count_frequency),
+        LOG_LEVEL_NAMES[LOG_LEVEL_WARNING], "log",
+        static_cast<long long>(dropped_count - logger->reported_dropped_count));
+    AppendLogOutput(logger, line, line_size);
+    logger->reported_dropped_count = dropped_count;
+  }
+  logger->stats.records_dropped = dropped_count;
+
+  FlushLogOutput(logger);
+  logger->stats.last_flush_ms =
+      1000.0f * GetSecondsElapsed(flush_start, GetWallClock(),
+                                  logger->perf_count_frequency);
+}
+
+static DWORD WINAPI LogThreadProc(LPVOID parameter) {
+  Logger *logger = reinterpret_cast<Logger *>(parameter);
+
+  while (true) {
+    DWORD wait_result =
+        WaitForSingleObject(logger->stop_event, LOG_FLUSH_INTERVAL_MS);
+    DrainLog(logger);
+    if (wait_result != WAIT_TIMEOUT) {
+      break;
+    }
+  }
+
+  return 0;
+}
+
+bool StartLog(LogSink sink, wchar_t *file_path, LogLevel min_level,
+              int64_t perf_count_frequency) {
+  Logger *logger = &LOGGER;
+  *logger = {};
+  logger->sink = sink;
+  logger->min_level = min_level;
+  logger->category_mask = (1u << LOG_CATEGORY_COUNT) - 1;
+  logger->start_counter = GetWallClock().QuadPart;
+  logger->perf_count_frequency = perf_count_frequency;
+
+  size_t ring_size = LOG_RING_RECORD_COUNT * sizeof(LogRecord);
+  uint8_t *memory = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, LOG_MAX_THREAD_COUNT * ring_size + LOG_OUTPUT_BUFFER_SIZE,
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!memory) {
+    return false;
+  }
+  for (int i = 0; i < LOG_MAX_THREAD_COUNT; ++i) {
+    logger->rings[i].records =
+        reinterpret_cast<LogRecord *>(memory + i * ring_size);
+  }
+  logger->output_buffer =
+      reinterpret_cast<char *>(memory + LOG_MAX_THREAD_COUNT * ring_size);
+
+  if (sink == LOG_SINK_FILE) {
+    logger->output = CreateFileW(file_path, GENERIC_WRITE, FILE_SHARE_READ, 0,
+                                 CREATE_ALWAYS, 0, 0);
+  } else if (sink == LOG_SINK_STDERR) {
+    logger->output = GetStdHandle(STD_ERROR_HANDLE);
+  }
+  if (sink != LOG_SINK_DEBUGGER &&
+      (!logger->output || logger->output == INVALID_HANDLE_VALUE)) {
+    logger->output = 0;
+    return false;
+  }
+
+  logger->stop_event = CreateEventW(0, FALSE, FALSE, 0);
+  if (!logger->stop_event) {
+    return false;
+  }
+
+  logger->is_running = true;
+  logger->thread = CreateThread(0, 0, LogThreadProc, logger, 0, 0);
+  if (!logger->thread) {
+    logger->is_running = false;
+    return false;
+  }
+
+  return true;
+}
+
+LogStats GetLogStats() {
+  LogStats result = LOGGER.stats;
+  return result;
+}
+
+void StopLog() {
+  Logger *logger = &LOGGER;
+  logger->is_running = false;
+  if (logger->thread) {
+    SetEvent(logger->stop_event);
+    WaitForSingleObject(logger->thread, INFINITE);
+    CloseHandle(logger->thread);
+    logger->thread = 0;
+  }
+
+  if (logger->stop_event) {
+    CloseHandle(logger->stop_event);
+    logger->stop_event = 0;
+  }
+
+  if (logger->sink == LOG_SINK_FILE && logger->output) {
+    FlushFileBuffers(logger->output);
+    CloseHandle(logger->output);
+  }
+  logger->output = 0;
+}
+#endif
@@ -0,0 +1,195 @@
+#ifndef SRC_WIN32_WIN32_LOG_H_
+#define SRC_WIN32_WIN32_LOG_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#if DEV
+static const int LOG_MAX_THREAD_COUNT = 8;
+static const int LOG_RING_RECORD_COUNT = 1024;
+static const int LOG_MAX_ARG_COUNT = 8;
+static const int LOG_MAX_LINE_LENGTH = 512;
+static const int LOG_OUTPUT_BUFFER_SIZE = 64 * 1024;
+static const DWORD LOG_FLUSH_INTERVAL_MS = 50;
+
+enum LogLevel {
+  LOG_LEVEL_DEBUG,
+  LOG_LEVEL_INFO,
+  LOG_LEVEL_WARNING,
+  LOG_LEVEL_ERROR,
+  LOG_LEVEL_COUNT,
+};
+
+enum LogCategory {
+  LOG_CATEGORY_FRAME,
+  LOG_CATEGORY_AUDIO,
+  LOG_CATEGORY_SAVE_STATE,
+  LOG_CATEGORY_MEMORY,
+  LOG_CATEGORY_ASSET,
+  LOG_CATEGORY_COUNT,
+};
+
+enum LogSink {
+  LOG_SINK_FILE,
+  LOG_SINK_STDERR,
+  LOG_SINK_DEBUGGER,
+};
+
+enum LogArgType {
+  LOG_ARG_NONE,
+  LOG_ARG_INT,
+  LOG_ARG_UINT,
+  LOG_ARG_FLOAT,
+  LOG_ARG_STRING,
+  LOG_ARG_POINTER,
+};
+
+struct LogArg {
+  union {
+    int64_t i;
+    uint64_t u;
+    double f;
+    const char *s;
+    const void *p;
+  };
+  LogArgType type;
+};
+
+// Arguments are captured by value and formatted later on the log thread, so
+// the format and any %s argument must outlive the record, e.g. be literals.
+struct LogRecord {
+  int64_t timestamp;
+  const char *format;
+  uint32_t arg_types;
+  uint8_t level;
+  uint8_t category;
+  uint8_t arg_count;
+  uint8_t thread_idx;
+  uint64_t args[LOG_MAX_ARG_COUNT];
+};
+
+// Single-producer ring owned by one thread. The producer only advances
+// write_idx and the log thread only advances read_idx, so neither side takes
+// a lock. A full ring drops the record and counts it.
+struct LogRing {
+  LogRecord *records;
+  volatile int64_t write_idx;
+  volatile int64_t read_idx;
+  volatile int64_t dropped_count;
+};
+
+struct LogStats {
+  int64_t records_written;
+  int64_t records_dropped;
+  int64_t bytes_written;
+  float last_flush_ms;
+};
+
+struct Logger {
+  LogRing rings[LOG_MAX_THREAD_COUNT];
+  volatile LONG ring_count;
+  volatile LONG unregistered_dropped_count;
+  int64_t reported_dropped_count;
+
+  LogLevel min_level;
+  uint32_t category_mask;
+  LogSink sink;
+  HANDLE output;
+  char *output_buffer;
+  int output_size;
+
+  int64_t start_counter;
+  int64_t perf_count_frequency;
+  HANDLE stop_event;
+  HANDLE thread;
+  volatile bool is_running;
+
+  LogStats stats;
+};
+
+inline LogArg MakeLogArg(int value) {
+  LogArg result;
+  result.i = value;
+  result.type = LOG_ARG_INT;
+  return result;
+}
+
+inline LogArg MakeLogArg(long value) {
+  LogArg result;
+  result.i = value;
+  result.type = LOG_ARG_INT;
+  return result;
+}
+
+inline LogArg MakeLogArg(long long value) {
+  LogArg result;
+  result.i = value;
+  result.type = LOG_ARG_INT;
+  return result;
+}
+
+inline LogArg MakeLogArg(unsigned int value) {
+  LogArg result;
+  result.u = value;
+  result.type = LOG_ARG_UINT;
+  return result;
+}
+
+inline LogArg MakeLogArg(unsigned long value) {
+  LogArg result;
+  result.u = value;
+  result.type = LOG_ARG_UINT;
+  return result;
+}
+
+inline LogArg MakeLogArg(unsigned long long value) {
+  LogArg result;
+  result.u = value;
+  result.type = LOG_ARG_UINT;
+  return result;
+}
+
+inline LogArg MakeLogArg(double value) {
+  LogArg result;
+  result.f = value;
+  result.type = LOG_ARG_FLOAT;
+  return result;
+}
+
+inline LogArg MakeLogArg(const char *value) {
+  LogArg result;
+  result.s = value;
+  result.type = LOG_ARG_STRING;
+  return result;
+}
+
+inline LogArg MakeLogArg(const void *value) {
+  LogArg result;
+  result.p = value;
+  result.type = LOG_ARG_POINTER;
+  return result;
+}
+
+bool StartLog(LogSink sink, wchar_t *file_path, LogLevel min_level,
+              int64_t perf_count_frequency);
+bool IsLogEnabled(LogLevel level, LogCategory category);
+void WriteLogRecord(LogLevel level, LogCategory category, const char *format,
+                    LogArg *args, int arg_count);
+int FormatLogRecord(LogRecord *record, char *dest, int dest_capacity);
+LogStats GetLogStats();
+void StopLog();
+
+template <typename... Args>
+inline void Log(LogLevel level, LogCategory category, const char *format,
+                Args... args) {
+  static_assert(sizeof...(args) <= LOG_MAX_ARG_COUNT, "Too many log args");
+  if (IsLogEnabled(level, category)) {
+    LogArg arg_values[] = {MakeLogArg(args)..., MakeLogArg(0)};
+    WriteLogRecord(level, category, format, arg_values,
+                   static_cast<int>(sizeof...(args)));
+  }
+}
+#endif
+
+#endif  // SRC_WIN32_WIN32_LOG_H_
@@ -0,0 +1,215 @@
+#include "../../src/win32/win32-memory.h"
+
+#include <psapi.h>
+#include <windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-clock.h"
+#include "../../src/win32/win32-file-io.h"
+
+#if DEV
+static const char *MEMORY_REGION_NAMES[MEMORY_REGION_COUNT] = {"permanent",
+                                                               "transient"};
+static const char *MEMORY_TAG_NAMES[MEMORY_TAG_COUNT] = {
+    "untagged", "world", "entity", "particle", "collision", "stream",
+    "flow"};
+
+static char memory_report_json[MEMORY_REPORT_SIZE];
+
+static size_t GetCommittedSize(uint8_t *base, size_t size) {
+  size_t result = 0;
+  uint8_t *at = base;
+  uint8_t *end = base + size;
+  while (at < end) {
+    MEMORY_BASIC_INFORMATION info;
+    if (!VirtualQuery(at, &info, sizeof(info))) {
+      break;
+    }
+
+    uint8_t *region_end =
+        reinterpret_cast<uint8_t *>(info.BaseAddress) + info.RegionSize;
+    if (region_end > end) {
+      region_end = end;
+    }
+    if (info.State == MEM_COMMIT) {
+      result += region_end - at;
+    }
+    at = region_end;
+  }
+  return result;
+}
+
+bool InitMemoryReport(MemoryReport *report, GameMemory *memory,
+                      int64_t perf_count_frequency) {
+  *report = {};
+
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  report->page_size = system_info.dwPageSize;
+  report->perf_count_frequency = perf_count_frequency;
+
+  report->region_bases[MEMORY_REGION_PERMANENT] =
+      reinterpret_cast<uint8_t *>(memory->permanent_storage);
+  report->region_sizes[MEMORY_REGION_PERMANENT] =
+      static_cast<size_t>(memory->permanent_storage_size);
+  report->region_bases[MEMORY_REGION_TRANSIENT] =
+      reinterpret_cast<uint8_t *>(memory->transient_storage);
+  report->region_sizes[MEMORY_REGION_TRANSIENT] =
+      static_cast<size_t>(memory->transient_storage_size);
+
+  report->query_entries = reinterpret_cast<PSAPI_WORKING_SET_EX_INFORMATION *>(
+      VirtualAlloc(0,
+                   MEMORY_QUERY_PAGES_PER_STEP *
+                       sizeof(PSAPI_WORKING_SET_EX_INFORMATION),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!report->query_entries) {
+    return false;
+  }
+
+  for (int i = 0; i < MEMORY_REGION_COUNT; ++i) {
+    report->regions[i].reserved_size = report->region_sizes[i];
+  }
+  return true;
+}
+
+static void FinishMemoryScan(MemoryReport *report) {
+  for (int i = 0; i < MEMORY_REGION_COUNT; ++i) {
+    report->regions[i].committed_size =
+        GetCommittedSize(report->region_bases[i], report->region_sizes[i]);
+  }
+
+  PROCESS_MEMORY_COUNTERS counters = {};
+  counters.cb = sizeof(counters);
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    report->working_set_size = counters.WorkingSetSize;
+    report->peak_working_set_size = counters.PeakWorkingSetSize;
+  }
+
+  ++report->scan_count;
+  report->last_scan_ms = report->scan_ms;
+  report->scan_ms = 0.0f;
+}
+
+// Records the game's arena usage and samples the residency of the next
+// batch of pages.
+void StepMemoryReport(MemoryReport *report, GameMemory *memory) {
+  GameMemoryUsage *usage = &memory->usage;
+  report->regions[MEMORY_REGION_PERMANENT].used_size = usage->permanent_used;
+  report->regions[MEMORY_REGION_TRANSIENT].used_size = usage->transient_used;
+  for (int i = 0; i < MEMORY_REGION_COUNT; ++i) {
+    MemoryRegionStats *region = &report->regions[i];
+    if (region->used_size > region->used_high_water) {
+      region->used_high_water = region->used_size;
+    }
+  }
+  for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+    report->tag_sizes[i] = usage->tag_sizes[i];
+    if (report->tag_sizes[i] > report->tag_high_water[i]) {
+      report->tag_high_water[i] = report->tag_sizes[i];
+    }
+  }
+
+  LARGE_INTEGER start_counter = GetWallClock();
+
+  int region_idx = report->scan_region;
+  uint8_t *base = report->region_bases[region_idx];
+  size_t page_count = report->region_sizes[region_idx] / report->page_size;
+  size_t query_count = page_count - report->scan_page_idx;
+  if (query_count > MEMORY_QUERY_PAGES_PER_STEP) {
+    query_count = MEMORY_QUERY_PAGES_PER_STEP;
+  }
+
+  for (size_t i = 0; i < query_count; ++i) {
+    report->query_entries[i].VirtualAddress =
+        base + (report->scan_page_idx + i) * report->page_size;
+  }
+  if (QueryWorkingSetEx(GetCurrentProcess(), report->query_entries,
+                        static_cast<DWORD>(
+                            query_count *
+                            sizeof(PSAPI_WORKING_SET_EX_INFORMATION)))) {
+    for (size_t i = 0; i < query_count; ++i) {
+      report->scan_resident_count +=
+          report->query_entries[i].VirtualAttributes.Valid;
+    }
+  }
+  report->scan_page_idx += query_count;
+
+  if (report->scan_page_idx >= page_count) {
+    MemoryRegionStats *region = &report->regions[region_idx];
+    region->resident_size = report->scan_resident_count * report->page_size;
+    if (region->resident_size > region->resident_high_water) {
+      region->resident_high_water = region->resident_size;
+    }
+
+    report->scan_page_idx = 0;
+    report->scan_resident_count = 0;
+    report->scan_region = (region_idx + 1) % MEMORY_REGION_COUNT;
+  }
+
+  report->scan_ms += 1000.0f * GetSecondsElapsed(start_counter, GetWallClock(),
+                                                 report->perf_count_frequency);
+  if (report->scan_region == 0 && report->scan_page_idx == 0) {
+    FinishMemoryScan(report);
+  }
+}
+
+bool WriteMemoryReport(MemoryReport *report, wchar_t *file_path) {
+  char *json = memory_report_json;
+  int json_capacity = sizeof(memory_report_json);
+  int json_size =
+      snprintf(json, json_capacity,
+               "{\n  \"page_size\": %u,\n  \"scan_count\": %lld,\n"
+               "  \"last_scan_ms\": %.3f,\n  \"working_set\": %llu,\n"
+               "  \"peak_working_set\": %llu,\n  \"regions\": [\n",
+               report->page_size, static_cast<long long>(report->scan_count),
+               report->last_scan_ms,
+               static_cast<unsigned long long>(report->working_set_size),
+               static_cast<unsigned long long>(report->peak_working_set_size));
+
+  for (int i = 0; i < MEMORY_REGION_COUNT; ++i) {
+    MemoryRegionStats *region = &report->regions[i];
+    json_size += snprintf(
+        json + json_size, json_capacity - json_size,
+        "    {\"name\": \"%s\", \"reserved\": %llu, \"committed\": %llu, "
+        "\"resident\": %llu, \"resident_high_water\": %llu, \"used\": %llu, "
+        "\"used_high_water\": %llu}%s\n",
+        MEMORY_REGION_NAMES[i],
+        static_cast<unsigned long long>(region->reserved_size),
+        static_cast<unsigned long long>(region->committed_size),
+        static_cast<unsigned long long>(region->resident_size),
+        static_cast<unsigned long long>(region->resident_high_water),
+        static_cast<unsigned long long>(region->used_size),
+        static_cast<unsigned long long>(region->used_high_water),
+        i + 1 < MEMORY_REGION_COUNT ? "," : "");
+  }
+
+  json_size += snprintf(json + json_size, json_capacity - json_size,
+                        "  ],\n  \"tags\": [\n");
+  for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+    json_size += snprintf(
+        json + json_size, json_capacity - json_size,
+        "    {\"name\": \"%s\", \"size\": %llu, \"high_water\": %llu}%s\n",
+        MEMORY_TAG_NAMES[i],
+        static_cast<unsigned long long>(report->tag_sizes[i]),
+        static_cast<unsigned long long>(report->tag_high_water[i]),
+        i + 1 < MEMORY_TAG_COUNT ? "," : "");
+  }
+  json_size +=
+      snprintf(json + json_size, json_capacity - json_size, "  ]\n}\n");
+
+  bool result = WriteEntireFileDebug(file_path,
+                                     static_cast<uint32_t>(json_size), json);
+  return result;
+}
+
+void StopMemoryReport(MemoryReport *report) {
+  if (report->query_entries) {
+    VirtualFree(report->query_entries, 0, MEM_RELEASE);
+  }
+  report->query_entries = 0;
+}
+#endif
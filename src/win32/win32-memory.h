@@ -0,0 +1,63 @@
+#ifndef SRC_WIN32_WIN32_MEMORY_H_
+#define SRC_WIN32_WIN32_MEMORY_H_
+
+#include <psapi.h>
+#include <windows.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+#if DEV
+static const int MEMORY_QUERY_PAGES_PER_STEP = 2048;
+static const int MEMORY_REPORT_SIZE = Kilobytes(4);
+
+enum MemoryRegion {
+  MEMORY_REGION_PERMANENT,
+  MEMORY_REGION_TRANSIENT,
+  MEMORY_REGION_COUNT,
+};
+
+// Reserved and committed come from VirtualQuery, resident from the working
+// set, used from the game's own arenas.
+struct MemoryRegionStats {
+  size_t reserved_size;
+  size_t committed_size;
+  size_t resident_size;
+  size_t resident_high_water;
+  size_t used_size;
+  size_t used_high_water;
+};
+
+// Residency is sampled a batch of pages per frame, so a full scan of the
+// reservation is spread over many frames instead of stalling one.
+struct MemoryReport {
+  uint8_t *region_bases[MEMORY_REGION_COUNT];
+  size_t region_sizes[MEMORY_REGION_COUNT];
+  uint32_t page_size;
+  int64_t perf_count_frequency;
+
+  PSAPI_WORKING_SET_EX_INFORMATION *query_entries;
+  int scan_region;
+  size_t scan_page_idx;
+  size_t scan_resident_count;
+  float scan_ms;
+
+  MemoryRegionStats regions[MEMORY_REGION_COUNT];
+  size_t tag_sizes[MEMORY_TAG_COUNT];
+  size_t tag_high_water[MEMORY_TAG_COUNT];
+  size_t working_set_size;
+  size_t peak_working_set_size;
+  int64_t scan_count;
+  float last_scan_ms;
+};
+
+bool InitMemoryReport(MemoryReport *report, GameMemory *memory,
+                      int64_t perf_count_frequency);
+void StepMemoryReport(MemoryReport *report, GameMemory *memory);
+bool WriteMemoryReport(MemoryReport *report, wchar_t *file_path);
+void StopMemoryReport(MemoryReport *report);
+#endif
+
+#endif  // SRC_WIN32_WIN32_MEMORY_H_
@@ -0,0 +1,120 @@
+#include "../../src/win32/win32-music.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero-music.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-file-io.h"
+#include "../../src/win32/win32-sound.h"
+#include "../../src/win32/win32-stream.h"
+
+#if DEV
+bool ParseEncodeMusicMode(char *command_line) {
+  bool result = command_line && strstr(command_line, "-encode-music") != 0;
+  return result;
+}
+
+// Walks the RIFF chunks for the format and the samples. Only 16-bit PCM,
+// mono or stereo, is accepted.
+static bool ParseWave(uint8_t *content, uint32_t size, WaveFormat *format,
+                      int16_t **samples, uint32_t *samples_size) {
+  if (size < 12 || *reinterpret_cast<uint32_t *>(content) != RIFF_ID ||
+      *reinterpret_cast<uint32_t *>(content + 8) != WAVE_ID) {
+    return false;
+  }
+
+  bool has_format = false;
+  *samples = 0;
+  uint32_t at = 12;
+  while (size - at >= sizeof(RiffChunkHeader)) {
+    RiffChunkHeader *chunk = reinterpret_cast<RiffChunkHeader *>(content + at);
+    uint32_t body = at + sizeof(RiffChunkHeader);
+    uint32_t body_size = chunk->size;
+    if (body_size > size - body) {
+      body_size = size - body;
+    }
+
+    if (chunk->id == WAVE_FMT_ID && body_size >= sizeof(WaveFormat)) {
+      memcpy(format, content + body, sizeof(WaveFormat));
+      has_format = true;
+    } else if (chunk->id == WAVE_DATA_ID) {
+      *samples = reinterpret_cast<int16_t *>(content + body);
+      *samples_size = body_size;
+    }
+
+    // Chunks are padded to an even size.
+    if (body_size + (body_size & 1) >= size - body) {
+      break;
+    }
+    at = body + body_size + (body_size & 1);
+  }
+
+  bool result = has_format && *samples && format->format_tag == 1 &&
+                format->bits_per_sample == 16 && format->channels >= 1 &&
+                format->channels <= 2;
+  return result;
+}
+
+// Offline encoder: reads a WAV and writes the ADPCM music file the game
+// streams from.
+int RunEncodeMusic(wchar_t *wave_file_path) {
+  FileResult wave = ReadEntireFileDebug(wave_file_path);
+  if (!wave.content) {
+    OutputDebugStringW(L"Encode: could not read the input wave\n");
+    return 1;
+  }
+
+  WaveFormat format = {};
+  int16_t *samples = 0;
+  uint32_t samples_size = 0;
+  if (!ParseWave(reinterpret_cast<uint8_t *>(wave.content), wave.file_size,
+                 &format, &samples, &samples_size)) {
+    OutputDebugStringW(L"Encode: input must be 16-bit PCM, mono or stereo\n");
+    FreeFileMemoryDebug(&wave.content);
+    return 1;
+  }
+
+  // The game has no resampler and rejects music at any other rate.
+  SoundOutput sound_output;
+  if (format.samples_per_second !=
+      static_cast<uint32_t>(sound_output.samples_per_second)) {
+    char debug_buffer[256];
+    snprintf(debug_buffer, sizeof(debug_buffer),
+             "Encode: input is %u Hz, the game plays at %d Hz\n",
+             format.samples_per_second, sound_output.samples_per_second);
+    OutputDebugStringA(debug_buffer);
+    FreeFileMemoryDebug(&wave.content);
+    return 1;
+  }
+
+  uint32_t frame_count = samples_size / (format.channels * sizeof(int16_t));
+  uint32_t music_size = GetMusicFileSize(frame_count);
+  uint8_t *music = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, music_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  PlatformApi platform = {};
+  InitPlatformApi(&platform);
+
+  bool is_written =
+      music &&
+      EncodeMusic(samples, frame_count, format.channels,
+                  format.samples_per_second, music, music_size) &&
+      platform.WriteEntireFile(MUSIC_FILE_NAME, music_size, music);
+
+  char debug_buffer[256];
+  snprintf(debug_buffer, sizeof(debug_buffer),
+           "Encode: %u frames at %u Hz, %u bytes -> %u bytes%s\n",
+           frame_count, format.samples_per_second, samples_size, music_size,
+           is_written ? "" : " (failed)");
+  OutputDebugStringA(debug_buffer);
+
+  if (music) {
+    VirtualFree(music, 0, MEM_RELEASE);
+  }
+  FreeFileMemoryDebug(&wave.content);
+  return is_written ? 0 : 1;
+}
+#endif
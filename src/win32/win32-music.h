@@ -0,0 +1,32 @@
+#ifndef SRC_WIN32_WIN32_MUSIC_H_
+#define SRC_WIN32_WIN32_MUSIC_H_
+
+#include <cstdint>
+
+#if DEV
+static const uint32_t RIFF_ID = 0x46464952;       // "RIFF"
+static const uint32_t WAVE_ID = 0x45564157;       // "WAVE"
+static const uint32_t WAVE_FMT_ID = 0x20746D66;   // "fmt "
+static const uint32_t WAVE_DATA_ID = 0x61746164;  // "data"
+
+#pragma pack(push, 1)
+struct RiffChunkHeader {
+  uint32_t id;
+  uint32_t size;
+};
+
+struct WaveFormat {
+  uint16_t format_tag;
+  uint16_t channels;
+  uint32_t samples_per_second;
+  uint32_t avg_bytes_per_second;
+  uint16_t block_align;
+  uint16_t bits_per_sample;
+};
+#pragma pack(pop)
+
+bool ParseEncodeMusicMode(char *command_line);
+int RunEncodeMusic(wchar_t *wave_file_path);
+#endif
+
+#endif  // SRC_WIN32_WIN32_MUSIC_H_
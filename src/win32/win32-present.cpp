@@ -0,0 +1,134 @@
+#include "../../src/win32/win32-present.h"
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-clock.h"
+
+static const float LATENCY_SMOOTHING = 0.1f;
+
+static DWORD WINAPI PresentThreadProc(LPVOID parameter) {
+  PresentQueue *queue = reinterpret_cast<PresentQueue *>(parameter);
+  HANDLE wait_handles[2] = {queue->ready_semaphore, queue->repaint_event};
+
+  while (true) {
+    DWORD wait_result = WaitForMultipleObjects(ArraySize(wait_handles),
+                                               wait_handles, FALSE, INFINITE);
+    if (!queue->is_running) {
+      break;
+    }
+
+    if (wait_result == WAIT_OBJECT_0 + 1) {
+      Buffer *present_buffer = &queue->present_buffer;
+      if (queue->sink == PRESENT_SINK_WINDOW && present_buffer->memory) {
+        Dimensions window_dimensions = GetDimensions(queue->window);
+        DisplayBuffer(queue->device_context, 0, 0, window_dimensions.width,
+                      window_dimensions.height, present_buffer);
+      }
+      continue;
+    }
+
+    int present_idx = queue->present_idx;
+    queue->present_idx = (present_idx + 1) % BACKBUFFER_COUNT;
+
+    LARGE_INTEGER blit_start = GetWallClock();
+    if (queue->sink == PRESENT_SINK_WINDOW) {
+      PresentBuffer(queue->device_context, GetDimensions(queue->window),
+                    &queue->backbuffers[present_idx], &queue->present_buffer,
+                    queue->filters[present_idx]);
+    }
+    LARGE_INTEGER blit_end = GetWallClock();
+
+    PresentStats *stats = &queue->stats;
+    stats->last_blit_ms =
+        1000.0f * GetSecondsElapsed(blit_start, blit_end,
+                                    queue->perf_count_frequency);
+    stats->last_latency_ms =
+        1000.0f * GetSecondsElapsed(queue->submit_counters[present_idx],
+                                    blit_end, queue->perf_count_frequency);
+    if (stats->last_latency_ms > stats->max_latency_ms) {
+      stats->max_latency_ms = stats->last_latency_ms;
+    }
+    stats->avg_latency_ms +=
+        LATENCY_SMOOTHING * (stats->last_latency_ms - stats->avg_latency_ms);
+    ++stats->frames_presented;
+
+    InterlockedDecrement(&queue->frames_in_flight);
+    ReleaseSemaphore(queue->free_semaphore, 1, 0);
+  }
+
+  return 0;
+}
+
+bool InitPresentQueue(PresentQueue *queue, HWND window, HDC device_context,
+                      PresentSink sink, int width, int height,
+                      int64_t perf_count_frequency) {
+  *queue = {};
+  queue->window = window;
+  queue->device_context = device_context;
+  queue->sink = sink;
+  queue->perf_count_frequency = perf_count_frequency;
+
+  for (int i = 0; i < BACKBUFFER_COUNT; ++i) {
+    ResizeDIBSection(&queue->backbuffers[i], width, height);
+    if (!queue->backbuffers[i].memory) {
+      return false;
+    }
+  }
+
+  queue->free_semaphore = CreateSemaphoreExW(
+      0, BACKBUFFER_COUNT, BACKBUFFER_COUNT, 0, 0, SEMAPHORE_ALL_ACCESS);
+  queue->ready_semaphore = CreateSemaphoreExW(0, 0, BACKBUFFER_COUNT, 0, 0,
+                                              SEMAPHORE_ALL_ACCESS);
+  queue->repaint_event = CreateEventW(0, FALSE, FALSE, 0);
+  if (!queue->free_semaphore || !queue->ready_semaphore ||
+      !queue->repaint_event) {
+    return false;
+  }
+
+  queue->is_running = true;
+  queue->thread = CreateThread(0, 0, PresentThreadProc, queue, 0, 0);
+  if (!queue->thread) {
+    queue->is_running = false;
+    return false;
+  }
+
+  return true;
+}
+
+Buffer *AcquireBackbuffer(PresentQueue *queue) {
+  WaitForSingleObject(queue->free_semaphore, INFINITE);
+  Buffer *result = &queue->backbuffers[queue->render_idx];
+  return result;
+}
+
+void SubmitBackbuffer(PresentQueue *queue, ScaleFilter filter) {
+  int render_idx = queue->render_idx;
+  queue->filters[render_idx] = filter;
+  queue->submit_counters[render_idx] = GetWallClock();
+  queue->render_idx = (render_idx + 1) % BACKBUFFER_COUNT;
+  ++queue->stats.frames_submitted;
+
+  InterlockedIncrement(&queue->frames_in_flight);
+  ReleaseSemaphore(queue->ready_semaphore, 1, 0);
+}
+
+void RequestRepaint(PresentQueue *queue) {
+  if (queue->repaint_event) {
+    SetEvent(queue->repaint_event);
+  }
+}
+
+void ShutdownPresentQueue(PresentQueue *queue) {
+  if (!queue->thread) {
+    return;
+  }
+
+  queue->is_running = false;
+  ReleaseSemaphore(queue->ready_semaphore, 1, 0);
+  WaitForSingleObject(queue->thread, INFINITE);
+  CloseHandle(queue->thread);
+  queue->thread = 0;
+}
@@ -0,0 +1,60 @@
+#ifndef SRC_WIN32_WIN32_PRESENT_H_
+#define SRC_WIN32_WIN32_PRESENT_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/win32/win32-display.h"
+
+static const int BACKBUFFER_COUNT = 3;
+
+enum PresentSink {
+  PRESENT_SINK_WINDOW,
+  PRESENT_SINK_NULL,
+};
+
+struct PresentStats {
+  int64_t frames_submitted;
+  int64_t frames_presented;
+  float last_latency_ms;
+  float max_latency_ms;
+  float avg_latency_ms;
+  float last_blit_ms;
+};
+
+// Backbuffers are handed out round-robin: the game renders into one while the
+// present thread pushes the previously submitted ones to the sink in order.
+struct PresentQueue {
+  Buffer backbuffers[BACKBUFFER_COUNT];
+  ScaleFilter filters[BACKBUFFER_COUNT];
+  LARGE_INTEGER submit_counters[BACKBUFFER_COUNT];
+  Buffer present_buffer;
+
+  HWND window;
+  HDC device_context;
+  PresentSink sink;
+  int64_t perf_count_frequency;
+
+  HANDLE free_semaphore;
+  HANDLE ready_semaphore;
+  HANDLE repaint_event;
+  HANDLE thread;
+
+  int render_idx;
+  int present_idx;
+  volatile LONG frames_in_flight;
+  volatile bool is_running;
+
+  PresentStats stats;
+};
+
+bool InitPresentQueue(PresentQueue *queue, HWND window, HDC device_context,
+                      PresentSink sink, int width, int height,
+                      int64_t perf_count_frequency);
+Buffer *AcquireBackbuffer(PresentQueue *queue);
+void SubmitBackbuffer(PresentQueue *queue, ScaleFilter filter);
+void RequestRepaint(PresentQueue *queue);
+void ShutdownPresentQueue(PresentQueue *queue);
+
+#endif  // SRC_WIN32_WIN32_PRESENT_H_
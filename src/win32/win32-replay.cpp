@@ -0,0 +1,330 @@
+#include "../../src/win32/win32-replay.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero-music.h"
+#include "../../src/handmade-hero/handmade-hero-stream.h"
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-display.h"
+#include "../../src/win32/win32-file-io.h"
+#include "../../src/win32/win32-golden.h"
+#include "../../src/win32/win32-hash.h"
+#include "../../src/win32/win32-stream.h"
+
+#if DEV
+ReplayMode ParseReplayMode(char *command_line) {
+  if (!command_line) {
+    return REPLAY_MODE_OFF;
+  }
+
+  if (strstr(command_line, "-replay-script")) {
+    return REPLAY_MODE_SCRIPT;
+  }
+
+  if (strstr(command_line, "-replay-verify")) {
+    return REPLAY_MODE_VERIFY;
+  }
+
+  return REPLAY_MODE_OFF;
+}
+
+bool ParseReplayRecordMode(char *command_line) {
+  bool result = command_line && strstr(command_line, "-replay-record") != 0;
+  return result;
+}
+
+// Only the used part of permanent storage is hashed: the game state and
+// everything pushed on the world arena after it.
+uint64_t HashGameState(GameMemory *memory) {
+  uint64_t result =
+      HashMemory(memory->permanent_storage,
+                 static_cast<size_t>(memory->usage.permanent_used), 0);
+  return result;
+}
+
+// The game names its files in ASCII, relative to the working directory.
+static bool HashInputFile(const char *file_name, uint64_t *hash) {
+  wchar_t file_path[FILE_CHANGE_MAX_NAME];
+  int length = 0;
+  while (file_name[length] && length < FILE_CHANGE_MAX_NAME - 1) {
+    file_path[length] = file_name[length];
+    ++length;
+  }
+  file_path[length] = 0;
+
+  FileResult file = ReadEntireFileDebug(file_path);
+  if (!file.content) {
+    return false;
+  }
+  *hash = HashMemory(file.content, file.file_size, 0);
+  FreeFileMemoryDebug(&file.content);
+  return true;
+}
+
+static bool HashInputFiles(uint64_t *world_file_hash,
+                           uint64_t *music_file_hash) {
+  bool result = HashInputFile(WORLD_FILE_NAME, world_file_hash) &&
+                HashInputFile(MUSIC_FILE_NAME, music_file_hash);
+  return result;
+}
+
+// A live recording needs the world and music files to exist already: on a
+// first launch the game bakes them during the first frame instead of
+// streaming them, and that run cannot be replayed.
+bool StartReplayRecording(ReplayRecorder *recorder, wchar_t *file_path,
+                          GameMemory *memory, int width, int height,
+                          int samples_per_second, bool is_live) {
+  *recorder = {};
+
+  ReplayFileHeader header = {};
+  if (is_live &&
+      !HashInputFiles(&header.world_file_hash, &header.music_file_hash)) {
+    OutputDebugStringW(L"Replay: world or music file missing, run the game "
+                       L"once before recording\n");
+    return false;
+  }
+
+  recorder->file = CreateFileW(file_path, GENERIC_WRITE, FILE_SHARE_READ, 0,
+                               CREATE_ALWAYS, 0, 0);
+  if (recorder->file == INVALID_HANDLE_VALUE) {
+    *recorder = {};
+    return false;
+  }
+
+  header.magic = REPLAY_FILE_MAGIC;
+  header.version = REPLAY_FILE_VERSION;
+  header.frame_size = sizeof(ReplayFrame);
+  header.width = width;
+  header.height = height;
+  header.samples_per_second = samples_per_second;
+  header.is_live = is_live;
+  header.permanent_storage_size = memory->permanent_storage_size;
+
+  DWORD bytes_written = 0;
+  if (!WriteFile(recorder->file, &header, sizeof(header), &bytes_written, 0) ||
+      bytes_written != sizeof(header)) {
+    StopReplayRecording(recorder);
+    return false;
+  }
+  return true;
+}
+
+// The game may consume its inputs, so they are copied before the frame runs.
+void BeginReplayFrame(ReplayRecorder *recorder, GameMemory *memory,
+                      GameInput *input) {
+  recorder->frame.input = *input;
+  recorder->frame.file_changes = memory->file_changes;
+}
+
+bool EndReplayFrame(ReplayRecorder *recorder, GameMemory *memory,
+                    GameBuffer *buffer, GameSoundBuffer *sound_buffer) {
+  if (!recorder->file) {
+    return false;
+  }
+
+  ReplayFrame *frame = &recorder->frame;
+  frame->width = buffer->width;
+  frame->height = buffer->height;
+  frame->sample_count = sound_buffer->sample_count;
+  frame->state_hash = HashGameState(memory);
+
+  DWORD bytes_written = 0;
+  bool result =
+      WriteFile(recorder->file, frame, sizeof(*frame), &bytes_written, 0) &&
+      bytes_written == sizeof(*frame);
+  if (result) {
+    ++recorder->frame_count;
+  } else {
+    OutputDebugStringW(L"Replay: write failed, recording stopped\n");
+    StopReplayRecording(recorder);
+  }
+  return result;
+}
+
+void StopReplayRecording(ReplayRecorder *recorder) {
+  if (recorder->file) {
+    CloseHandle(recorder->file);
+  }
+  *recorder = {};
+}
+
+// Records the golden scripted input with state hashes, so a later build can
+// check it still simulates the same frames with -replay-verify.
+int RunScriptedReplay(wchar_t *replay_file_path, int frame_count, int width,
+                      int height) {
+  GameMemory memory;
+  if (!AllocateGameMemory(&memory,
+                          reinterpret_cast<void *>(DEV_MEMORY_BASE_ADDRESS))) {
+    OutputDebugStringW(L"Replay: memory allocation failed\n");
+    return 1;
+  }
+
+  Buffer buffer = {};
+  ResizeDIBSection(&buffer, width, height);
+
+  int samples_per_frame = GOLDEN_SAMPLES_PER_SECOND / GOLDEN_FPS;
+  float *samples = reinterpret_cast<float *>(
+      VirtualAlloc(0, samples_per_frame * 2 * sizeof(float),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!buffer.memory || !samples) {
+    OutputDebugStringW(L"Replay: buffer allocation failed\n");
+    return 1;
+  }
+
+  ReplayRecorder recorder;
+  if (!StartReplayRecording(&recorder, replay_file_path, &memory, width,
+                            height, GOLDEN_SAMPLES_PER_SECOND, false)) {
+    OutputDebugStringW(L"Replay: could not create the replay file\n");
+    return 1;
+  }
+
+  GameInput old_input = {};
+  GameInput new_input = {};
+  int result = 0;
+
+  for (int frame_idx = 0; frame_idx < frame_count; ++frame_idx) {
+    GetScriptedInput(frame_idx, &old_input, &new_input);
+
+    GameBuffer game_buffer = {};
+    game_buffer.memory = buffer.memory;
+    game_buffer.width = buffer.width;
+    game_buffer.height = buffer.height;
+    game_buffer.pitch = buffer.pitch;
+    game_buffer.bytes_per_pixel = buffer.bytes_per_pixel;
+    game_buffer.format = PIXEL_FORMAT_BGRA8;
+
+    GameSoundBuffer game_sound_buffer = {};
+    game_sound_buffer.samples_per_second = GOLDEN_SAMPLES_PER_SECOND;
+    game_sound_buffer.sample_count = samples_per_frame;
+    game_sound_buffer.left_samples = samples;
+    game_sound_buffer.right_samples = samples + samples_per_frame;
+
+    BeginReplayFrame(&recorder, &memory, &new_input);
+    UpdateAndRender(&memory, &game_buffer, &game_sound_buffer, &new_input);
+    if (!EndReplayFrame(&recorder, &memory, &game_buffer,
+                        &game_sound_buffer)) {
+      result = 1;
+      break;
+    }
+    old_input = new_input;
+  }
+
+  StopReplayRecording(&recorder);
+  return result;
+}
+
+// Feeds the recorded frames back through UpdateAndRender and stops at the
+// first frame whose state hash differs from the recording.
+int RunReplayVerify(wchar_t *replay_file_path) {
+  char debug_buffer[256];
+
+  FileResult replay = ReadEntireFileDebug(replay_file_path);
+  ReplayFileHeader *header =
+      reinterpret_cast<ReplayFileHeader *>(replay.content);
+  if (!replay.content || replay.file_size < sizeof(ReplayFileHeader) ||
+      header->magic != REPLAY_FILE_MAGIC ||
+      header->version != REPLAY_FILE_VERSION ||
+      header->frame_size != sizeof(ReplayFrame)) {
+    OutputDebugStringW(L"Replay: missing or incompatible replay file\n");
+    FreeFileMemoryDebug(&replay.content);
+    return 1;
+  }
+
+  GameMemory memory;
+  if (!AllocateGameMemory(&memory,
+                          reinterpret_cast<void *>(DEV_MEMORY_BASE_ADDRESS)) ||
+      memory.permanent_storage_size != header->permanent_storage_size) {
+    OutputDebugStringW(L"Replay: memory allocation failed\n");
+    FreeFileMemoryDebug(&replay.content);
+    return 1;
+  }
+  if (header->is_live) {
+    uint64_t world_file_hash = 0;
+    uint64_t music_file_hash = 0;
+    if (!HashInputFiles(&world_file_hash, &music_file_hash) ||
+        world_file_hash != header->world_file_hash ||
+        music_file_hash != header->music_file_hash) {
+      OutputDebugStringW(L"Replay: world or music file differs from the "
+                         L"recording\n");
+      FreeFileMemoryDebug(&replay.content);
+      return 1;
+    }
+    InitPlatformApi(&memory.platform);
+  }
+
+  Buffer buffer = {};
+  ResizeDIBSection(&buffer, header->width, header->height);
+
+  // The live loop never mixes more than one second of sound per frame.
+  int max_sample_count = header->samples_per_second;
+  float *samples = reinterpret_cast<float *>(
+      VirtualAlloc(0, max_sample_count * 2 * sizeof(float),
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!buffer.memory || !samples) {
+    OutputDebugStringW(L"Replay: buffer allocation failed\n");
+    FreeFileMemoryDebug(&replay.content);
+    return 1;
+  }
+
+  ReplayFrame *frames = reinterpret_cast<ReplayFrame *>(
+      reinterpret_cast<uint8_t *>(replay.content) + sizeof(ReplayFileHeader));
+  int frame_count = static_cast<int>(
+      (replay.file_size - sizeof(ReplayFileHeader)) / sizeof(ReplayFrame));
+  int diverged_frame_idx = -1;
+
+  for (int frame_idx = 0; frame_idx < frame_count; ++frame_idx) {
+    ReplayFrame *frame = &frames[frame_idx];
+    if (frame->width > buffer.width || frame->height > buffer.height ||
+        frame->sample_count < 0 || frame->sample_count > max_sample_count) {
+      snprintf(debug_buffer, sizeof(debug_buffer),
+               "Replay: frame %d is corrupt\n", frame_idx);
+      OutputDebugStringA(debug_buffer);
+      diverged_frame_idx = frame_idx;
+      break;
+    }
+
+    GameBuffer game_buffer = {};
+    game_buffer.memory = buffer.memory;
+    game_buffer.width = frame->width;
+    game_buffer.height = frame->height;
+    game_buffer.pitch = buffer.pitch;
+    game_buffer.bytes_per_pixel = buffer.bytes_per_pixel;
+    game_buffer.format = PIXEL_FORMAT_BGRA8;
+
+    GameSoundBuffer game_sound_buffer = {};
+    game_sound_buffer.samples_per_second = header->samples_per_second;
+    game_sound_buffer.sample_count = frame->sample_count;
+    game_sound_buffer.left_samples = samples;
+    game_sound_buffer.right_samples = samples + max_sample_count;
+
+    GameInput input = frame->input;
+    memory.file_changes = frame->file_changes;
+    UpdateAndRender(&memory, &game_buffer, &game_sound_buffer, &input);
+
+    uint64_t state_hash = HashGameState(&memory);
+    if (state_hash != frame->state_hash) {
+      snprintf(debug_buffer, sizeof(debug_buffer),
+               "Replay: state diverged at frame %d (%016llx, recorded "
+               "%016llx)\n",
+               frame_idx, static_cast<unsigned long long>(state_hash),
+               static_cast<unsigned long long>(frame->state_hash));
+      OutputDebugStringA(debug_buffer);
+      diverged_frame_idx = frame_idx;
+      break;
+    }
+  }
+
+  if (diverged_frame_idx < 0) {
+    snprintf(debug_buffer, sizeof(debug_buffer),
+             "Replay: all %d frames match\n", frame_count);
+    OutputDebugStringA(debug_buffer);
+  }
+
+  FreeFileMemoryDebug(&replay.content);
+  return (diverged_frame_idx < 0) ? 0 : 1;
+}
+#endif
@@ -0,0 +1,69 @@
+#ifndef SRC_WIN32_WIN32_REPLAY_H_
+#define SRC_WIN32_WIN32_REPLAY_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+#if DEV
+static const uint32_t REPLAY_FILE_MAGIC = 0x52484848;  // "HHHR"
+static const uint32_t REPLAY_FILE_VERSION = 3;
+
+enum ReplayMode {
+  REPLAY_MODE_OFF,
+  REPLAY_MODE_SCRIPT,
+  REPLAY_MODE_VERIFY,
+};
+
+// Scripted replays run on the harness files; live recordings read the world
+// and music files from disk, so verifying them does too, and only against the
+// files whose hashes were recorded.
+struct ReplayFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t frame_size;
+  int32_t width;
+  int32_t height;
+  int32_t samples_per_second;
+  int32_t is_live;
+  uint64_t permanent_storage_size;
+  uint64_t world_file_hash;
+  uint64_t music_file_hash;
+};
+
+// Everything the platform hands UpdateAndRender for one frame, followed by
+// the hash of permanent storage once the frame has run.
+struct ReplayFrame {
+  GameInput input;
+  GameFileChanges file_changes;
+  int32_t width;
+  int32_t height;
+  int32_t sample_count;
+  uint64_t state_hash;
+};
+
+struct ReplayRecorder {
+  HANDLE file;
+  ReplayFrame frame;
+  int32_t frame_count;
+};
+
+ReplayMode ParseReplayMode(char *command_line);
+bool ParseReplayRecordMode(char *command_line);
+uint64_t HashGameState(GameMemory *memory);
+bool StartReplayRecording(ReplayRecorder *recorder, wchar_t *file_path,
+                          GameMemory *memory, int width, int height,
+                          int samples_per_second, bool is_live);
+void BeginReplayFrame(ReplayRecorder *recorder, GameMemory *memory,
+                      GameInput *input);
+bool EndReplayFrame(ReplayRecorder *recorder, GameMemory *memory,
+                    GameBuffer *buffer, GameSoundBuffer *sound_buffer);
+void StopReplayRecording(ReplayRecorder *recorder);
+int RunScriptedReplay(wchar_t *replay_file_path, int frame_count, int width,
+                      int height);
+int RunReplayVerify(wchar_t *replay_file_path);
+#endif
+
+#endif  // SRC_WIN32_WIN32_REPLAY_H_
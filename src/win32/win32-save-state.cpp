@@ -0,0 +1,574 @@
+#include "../../src/win32/win32-save-state.h"
+
+#include <emmintrin.h>
+#include <windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-clock.h"
+#include "../../src/win32/win32-file-io.h"
+
+#if DEV
+static const int SAVE_STATE_HASH_BITS = 12;
+static const int SAVE_STATE_MIN_MATCH = 4;
+static const int SAVE_STATE_MAX_PAGE_SIZE = 65535;
+
+// Codec: LZ4-style sequences of a token (4-bit literal count, 4-bit match
+// length minus SAVE_STATE_MIN_MATCH, 15 meaning more length bytes follow),
+// the literals, then a 16-bit match offset. The last sequence has literals
+// only. XOR deltas are mostly zero, which collapses to offset 1 matches.
+static uint8_t *WriteLength(uint8_t *out, int length) {
+  while (length >= 255) {
+    *out++ = 255;
+    length -= 255;
+  }
+  *out++ = static_cast<uint8_t>(length);
+  return out;
+}
+
+static bool ReadLength(uint8_t **in, uint8_t *in_end, int *length) {
+  uint8_t value = 0;
+  do {
+    if (*in >= in_end) {
+      return false;
+    }
+    value = *(*in)++;
+    *length += value;
+  } while (value == 255);
+  return true;
+}
+
+static uint8_t *WriteSequence(uint8_t *out, uint8_t *out_end,
+                              uint8_t *literals, int literal_length,
+                              int offset, int match_length) {
+  int needed = 1 + literal_length / 255 + 1 + literal_length + 2 +
+               match_length / 255 + 1;
+  if (out_end - out < needed) {
+    return 0;
+  }
+
+  int literal_code = literal_length < 15 ? literal_length : 15;
+  int match_code = 0;
+  if (match_length) {
+    match_code = match_length - SAVE_STATE_MIN_MATCH;
+    match_code = match_code < 15 ? match_code : 15;
+  }
+
+  *out++ = static_cast<uint8_t>((literal_code << 4) | match_code);
+  if (literal_code == 15) {
+    out = WriteLength(out, literal_length - 15);
+  }
+  memcpy(out, literals, literal_length);
+  out += literal_length;
+
+  if (match_length) {
+    *out++ = static_cast<uint8_t>(offset & 0xFF);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    if (match_code == 15) {
+      out = WriteLength(out, match_length - SAVE_STATE_MIN_MATCH - 15);
+    }
+  }
+  return out;
+}
+
+// Returns 0 when the output does not fit in dest_capacity, in which case the
+// caller stores the page raw.
+int CompressSaveStatePage(uint8_t *source, int size, uint8_t *dest,
+                          int dest_capacity) {
+  Assert(size <= SAVE_STATE_MAX_PAGE_SIZE);
+
+  // Positions are stored plus one so that zero means empty.
+  uint16_t table[1 << SAVE_STATE_HASH_BITS] = {};
+  uint8_t *out = dest;
+  uint8_t *out_end = dest + dest_capacity;
+
+  int anchor = 0;
+  int i = 0;
+  while (i + SAVE_STATE_MIN_MATCH <= size) {
+    uint32_t sequence;
+    memcpy(&sequence, source + i, sizeof(sequence));
+    uint32_t hash = (sequence * 2654435761u) >> (32 - SAVE_STATE_HASH_BITS);
+    int candidate = table[hash] - 1;
+    table[hash] = static_cast<uint16_t>(i + 1);
+
+    if (candidate < 0 ||
+        memcmp(source + candidate, &sequence, sizeof(sequence)) != 0) {
+      ++i;
+      continue;
+    }
+
+    int match_length = SAVE_STATE_MIN_MATCH;
+    while (i + match_length < size &&
+           source[candidate + match_length] == source[i + match_length]) {
+      ++match_length;
+    }
+
+    out = WriteSequence(out, out_end, source + anchor, i - anchor,
+                        i - candidate, match_length);
+    if (!out) {
+      return 0;
+    }
+    i += match_length;
+    anchor = i;
+  }
+
+  out = WriteSequence(out, out_end, source + anchor, size - anchor, 0, 0);
+  if (!out) {
+    return 0;
+  }
+
+  int result = static_cast<int>(out - dest);
+  return result;
+}
+
+bool DecompressSaveStatePage(uint8_t *source, int size, uint8_t *dest,
+                             int dest_size) {
+  uint8_t *in = source;
+  uint8_t *in_end = source + size;
+  int written = 0;
+
+  while (in < in_end) {
+    int token = *in++;
+
+    int literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(&in, in_end, &literal_length)) {
+      return false;
+    }
+    if (in_end - in < literal_length || dest_size - written < literal_length) {
+      return false;
+    }
+    memcpy(dest + written, in, literal_length);
+    in += literal_length;
+    written += literal_length;
+
+    if (in == in_end) {
+      break;
+    }
+
+    if (in_end - in < 2) {
+      return false;
+    }
+    int offset = in[0] | (in[1] << 8);
+    in += 2;
+
+    int match_length = token & 0xF;
+    if (match_length == 15 && !ReadLength(&in, in_end, &match_length)) {
+      return false;
+    }
+    match_length += SAVE_STATE_MIN_MATCH;
+    if (offset == 0 || offset > written ||
+        dest_size - written < match_length) {
+      return false;
+    }
+
+    // Byte by byte since short offsets overlap the bytes being written.
+    for (int i = 0; i < match_length; ++i) {
+      dest[written] = dest[written - offset];
+      ++written;
+    }
+  }
+
+  bool result = written == dest_size;
+  return result;
+}
+
+// Writes page ^ shadow to delta and page to shadow in one pass, returning
+// whether anything changed.
+static bool DiffPage(uint8_t *page, uint8_t *shadow, uint8_t *delta,
+                     uint32_t page_size) {
+  __m128i changed = _mm_setzero_si128();
+  for (uint32_t i = 0; i < page_size; i += 16) {
+    __m128i current = _mm_loadu_si128(reinterpret_cast<__m128i *>(page + i));
+    __m128i previous = _mm_loadu_si128(reinterpret_cast<__m128i *>(shadow + i));
+    __m128i difference = _mm_xor_si128(current, previous);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(delta + i), difference);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(shadow + i), current);
+    changed = _mm_or_si128(changed, difference);
+  }
+
+  bool result =
+      _mm_movemask_epi8(_mm_cmpeq_epi8(changed, _mm_setzero_si128())) != 0xFFFF;
+  return result;
+}
+
+static void ApplyDelta(uint8_t *page, uint8_t *delta, uint32_t page_size) {
+  for (uint32_t i = 0; i < page_size; i += sizeof(uint64_t)) {
+    uint64_t value;
+    uint64_t difference;
+    memcpy(&value, page + i, sizeof(value));
+    memcpy(&difference, delta + i, sizeof(difference));
+    value ^= difference;
+    memcpy(page + i, &value, sizeof(value));
+  }
+}
+
+bool ParseRecoverMode(char *command_line) {
+  bool result = command_line && strstr(command_line, "-recover") != 0;
+  return result;
+}
+
+bool InitSaveState(SaveState *state, void *memory, size_t memory_size,
+                   wchar_t *file_path, int64_t perf_count_frequency) {
+  *state = {};
+
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  state->memory = reinterpret_cast<uint8_t *>(memory);
+  state->memory_size = memory_size;
+  state->page_size = system_info.dwPageSize;
+  state->page_count = static_cast<uint32_t>(memory_size / state->page_size);
+  state->perf_count_frequency = perf_count_frequency;
+  Assert(memory_size % state->page_size == 0);
+  Assert(state->page_size <= SAVE_STATE_MAX_PAGE_SIZE);
+
+  size_t dirty_pages_size = state->page_count * sizeof(void *);
+  size_t indices_size = state->page_count * sizeof(uint32_t);
+  size_t block_capacity =
+      sizeof(SaveStateBlockHeader) +
+      static_cast<size_t>(state->page_count) *
+          (sizeof(SaveStatePageHeader) + state->page_size);
+  size_t total_size = 2 * memory_size + dirty_pages_size + indices_size +
+                      block_capacity;
+
+  // The shadow starts zeroed, so the first snapshot is a full one.
+  uint8_t *storage = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, total_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!storage) {
+    return false;
+  }
+  state->shadow = storage;
+  state->deltas = state->shadow + memory_size;
+  state->dirty_pages = reinterpret_cast<void **>(state->deltas + memory_size);
+  state->delta_page_indices = reinterpret_cast<uint32_t *>(
+      reinterpret_cast<uint8_t *>(state->dirty_pages) + dirty_pages_size);
+  state->block =
+      reinterpret_cast<uint8_t *>(state->delta_page_indices) + indices_size;
+
+  swprintf(state->file_path, ArraySize(state->file_path), L"%ls", file_path);
+  swprintf(state->pending_file_path, ArraySize(state->pending_file_path),
+           L"%ls.pending", file_path);
+  state->file = CreateFileW(state->pending_file_path, GENERIC_WRITE,
+                            FILE_SHARE_READ, 0, CREATE_ALWAYS, 0, 0);
+  if (state->file == INVALID_HANDLE_VALUE) {
+    VirtualFree(storage, 0, MEM_RELEASE);
+    *state = {};
+    return false;
+  }
+
+  state->needs_full_snapshot = true;
+  return true;
+}
+
+// Stores every nonzero page of the shadow as its delta against zeroed
+// memory, so the block does not depend on any block before it.
+static uint32_t CollectFullSnapshot(SaveState *state) {
+  uint32_t result = 0;
+  for (uint32_t page_idx = 0; page_idx < state->page_count; ++page_idx) {
+    uint8_t *page =
+        state->shadow + static_cast<size_t>(page_idx) * state->page_size;
+    uint8_t *delta =
+        state->deltas + static_cast<size_t>(result) * state->page_size;
+    __m128i nonzero = _mm_setzero_si128();
+    for (uint32_t i = 0; i < state->page_size; i += 16) {
+      __m128i value = _mm_loadu_si128(reinterpret_cast<__m128i *>(page + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(delta + i), value);
+      nonzero = _mm_or_si128(nonzero, value);
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(nonzero, _mm_setzero_si128())) !=
+        0xFFFF) {
+      state->delta_page_indices[result++] = page_idx;
+    }
+  }
+  return result;
+}
+
+// Diffs every page written since the last capture. Returns false while the
+// previous snapshot is still being compressed.
+bool CaptureSaveState(SaveState *state) {
+  if (state->is_pending) {
+    return false;
+  }
+
+  LARGE_INTEGER start_counter = GetWallClock();
+
+  ULONG_PTR dirty_count = state->page_count;
+  ULONG granularity = 0;
+  if (GetWriteWatch(WRITE_WATCH_FLAG_RESET, state->memory, state->memory_size,
+                    state->dirty_pages, &dirty_count, &granularity) != 0) {
+    return false;
+  }
+  Assert(granularity == state->page_size);
+
+  uint32_t changed_count = 0;
+  for (ULONG_PTR i = 0; i < dirty_count; ++i) {
+    uint8_t *page = reinterpret_cast<uint8_t *>(state->dirty_pages[i]);
+    uint32_t page_idx =
+        static_cast<uint32_t>((page - state->memory) / state->page_size);
+    uint8_t *delta =
+        state->deltas + static_cast<size_t>(changed_count) * state->page_size;
+    if (DiffPage(page, state->shadow + page_idx * state->page_size, delta,
+                 state->page_size)) {
+      state->delta_page_indices[changed_count++] = page_idx;
+    }
+  }
+  if (state->needs_full_snapshot) {
+    changed_count = CollectFullSnapshot(state);
+  }
+
+  state->pending_count = changed_count;
+  state->compressed_count = 0;
+  state->block_size = sizeof(SaveStateBlockHeader);
+  state->is_pending = true;
+  state->is_full_snapshot = state->needs_full_snapshot;
+  state->has_capture = true;
+
+  state->stats.dirty_page_count = static_cast<uint32_t>(dirty_count);
+  state->stats.changed_page_count = changed_count;
+  state->stats.raw_size =
+      static_cast<uint64_t>(changed_count) * state->page_size;
+  state->stats.compress_ms = 0.0f;
+  state->stats.capture_ms =
+      1000.0f * GetSecondsElapsed(start_counter, GetWallClock(),
+                                  state->perf_count_frequency);
+  return true;
+}
+
+// Full snapshots start a new side file, truncating whatever a failed attempt
+// left in it. The committed file stays in place until the rename.
+static bool OpenPendingSaveStateFile(SaveState *state) {
+  if (state->file && state->file != INVALID_HANDLE_VALUE) {
+    CloseHandle(state->file);
+  }
+  state->file = CreateFileW(state->pending_file_path, GENERIC_WRITE,
+                            FILE_SHARE_READ, 0, CREATE_ALWAYS, 0, 0);
+  bool result = state->file != INVALID_HANDLE_VALUE;
+  return result;
+}
+
+// Once a full snapshot is on disk the side file can replace the previous
+// recovery point. Later blocks are appended in place.
+static bool CommitSaveStateFile(SaveState *state) {
+  FlushFileBuffers(state->file);
+  CloseHandle(state->file);
+  state->file = 0;
+
+  if (!MoveFileExW(state->pending_file_path, state->file_path,
+                   MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    return false;
+  }
+
+  HANDLE file = CreateFileW(state->file_path, GENERIC_WRITE, FILE_SHARE_READ,
+                            0, OPEN_EXISTING, 0, 0);
+  LARGE_INTEGER zero = {};
+  if (file == INVALID_HANDLE_VALUE ||
+      !SetFilePointerEx(file, zero, 0, FILE_END)) {
+    if (file != INVALID_HANDLE_VALUE) {
+      CloseHandle(file);
+    }
+    return false;
+  }
+
+  state->file = file;
+  return true;
+}
+
+// Compresses up to page_budget pending pages. Returns true on the step that
+// finishes the snapshot and writes it out: appended to the file, or for a
+// full snapshot, committed as a new file.
+bool StepSaveState(SaveState *state, int page_budget) {
+  if (!state->is_pending) {
+    return false;
+  }
+
+  LARGE_INTEGER start_counter = GetWallClock();
+
+  uint32_t end_idx = state->compressed_count + page_budget;
+  if (end_idx > state->pending_count) {
+    end_idx = state->pending_count;
+  }
+
+  uint8_t *out = state->block + state->block_size;
+  for (uint32_t i = state->compressed_count; i < end_idx; ++i) {
+    uint8_t *delta = state->deltas + static_cast<size_t>(i) * state->page_size;
+    uint8_t *data = out + sizeof(SaveStatePageHeader);
+    int page_size = static_cast<int>(state->page_size);
+
+    int compressed_size =
+        CompressSaveStatePage(delta, page_size, data, page_size - 1);
+    if (!compressed_size) {
+      memcpy(data, delta, page_size);
+      compressed_size = page_size;
+    }
+
+    SaveStatePageHeader page_header = {};
+    page_header.page_idx = state->delta_page_indices[i];
+    page_header.compressed_size = compressed_size;
+    memcpy(out, &page_header, sizeof(page_header));
+    out = data + compressed_size;
+  }
+  state->block_size = out - state->block;
+  state->compressed_count = end_idx;
+
+  state->stats.compress_ms +=
+      1000.0f * GetSecondsElapsed(start_counter, GetWallClock(),
+                                  state->perf_count_frequency);
+
+  if (state->compressed_count < state->pending_count) {
+    return false;
+  }
+
+  SaveStateBlockHeader header = {};
+  header.magic = SAVE_STATE_FILE_MAGIC;
+  header.version = SAVE_STATE_FILE_VERSION;
+  header.page_size = state->page_size;
+  header.record_count = state->pending_count;
+  header.memory_size = state->memory_size;
+  header.data_size = state->block_size - sizeof(header);
+  memcpy(state->block, &header, sizeof(header));
+
+  state->is_pending = false;
+
+  bool result = !state->is_full_snapshot || OpenPendingSaveStateFile(state);
+  DWORD bytes_written = 0;
+  result = result &&
+           WriteFile(state->file, state->block,
+                     static_cast<DWORD>(state->block_size), &bytes_written,
+                     0) &&
+           bytes_written == state->block_size;
+
+  ++state->stats.snapshot_count;
+  state->stats.compressed_size = state->block_size;
+
+  if (result && state->is_full_snapshot) {
+    result = CommitSaveStateFile(state);
+    state->full_size = bytes_written;
+    state->appended_size = 0;
+    state->stats.file_size = bytes_written;
+  } else if (result) {
+    state->appended_size += bytes_written;
+    state->stats.file_size += bytes_written;
+  }
+
+  // A failed write leaves the file behind the shadow, so only a full
+  // snapshot can bring it back in step.
+  state->needs_full_snapshot =
+      !result || state->appended_size > state->full_size;
+  return result;
+}
+
+// Rolls memory back to the last capture by copying back only the pages
+// written since. Before the first capture the shadow is all zeros, so there
+// is nothing to roll back to.
+bool RestoreSaveState(SaveState *state) {
+  if (!state->has_capture) {
+    return false;
+  }
+
+  LARGE_INTEGER start_counter = GetWallClock();
+
+  ULONG_PTR dirty_count = state->page_count;
+  ULONG granularity = 0;
+  if (GetWriteWatch(0, state->memory, state->memory_size, state->dirty_pages,
+                    &dirty_count, &granularity) != 0) {
+    return false;
+  }
+
+  for (ULONG_PTR i = 0; i < dirty_count; ++i) {
+    uint8_t *page = reinterpret_cast<uint8_t *>(state->dirty_pages[i]);
+    size_t offset = page - state->memory;
+    memcpy(page, state->shadow + offset, state->page_size);
+  }
+  ResetWriteWatch(state->memory, state->memory_size);
+
+  state->stats.restore_ms =
+      1000.0f * GetSecondsElapsed(start_counter, GetWallClock(),
+                                  state->perf_count_frequency);
+  return true;
+}
+
+// Replays every block of a save state file over memory. Pointers stored in
+// the state are only valid when memory sits at the address it was captured
+// from.
+bool LoadSaveStateFile(wchar_t *file_path, void *memory, size_t memory_size) {
+  FileResult file = ReadEntireFileDebug(file_path);
+  if (!file.content) {
+    return false;
+  }
+
+  uint8_t *at = reinterpret_cast<uint8_t *>(file.content);
+  uint8_t *end = at + file.file_size;
+  uint8_t page[SAVE_STATE_MAX_PAGE_SIZE];
+  bool result = at < end;
+  memset(memory, 0, memory_size);
+
+  while (result && at < end) {
+    SaveStateBlockHeader header;
+    if (static_cast<size_t>(end - at) < sizeof(header)) {
+      result = false;
+      break;
+    }
+    memcpy(&header, at, sizeof(header));
+    at += sizeof(header);
+
+    if (header.magic != SAVE_STATE_FILE_MAGIC ||
+        header.version != SAVE_STATE_FILE_VERSION ||
+        header.memory_size != memory_size ||
+        header.page_size > SAVE_STATE_MAX_PAGE_SIZE ||
+        header.data_size > static_cast<uint64_t>(end - at)) {
+      result = false;
+      break;
+    }
+
+    uint8_t *block_end = at + header.data_size;
+    for (uint32_t i = 0; i < header.record_count; ++i) {
+      SaveStatePageHeader page_header;
+      if (static_cast<size_t>(block_end - at) < sizeof(page_header)) {
+        result = false;
+        break;
+      }
+      memcpy(&page_header, at, sizeof(page_header));
+      at += sizeof(page_header);
+
+      uint64_t page_offset =
+          static_cast<uint64_t>(page_header.page_idx) * header.page_size;
+      if (page_offset + header.page_size > memory_size ||
+          page_header.compressed_size > header.page_size ||
+          page_header.compressed_size >
+              static_cast<uint32_t>(block_end - at)) {
+        result = false;
+        break;
+      }
+
+      int page_size = static_cast<int>(header.page_size);
+      if (page_header.compressed_size == header.page_size) {
+        memcpy(page, at, page_size);
+      } else if (!DecompressSaveStatePage(
+                     at, page_header.compressed_size, page, page_size)) {
+        result = false;
+        break;
+      }
+      ApplyDelta(reinterpret_cast<uint8_t *>(memory) + page_offset, page,
+                 header.page_size);
+      at += page_header.compressed_size;
+    }
+    at = block_end;
+  }
+
+  FreeFileMemoryDebug(&file.content);
+  return result;
+}
+
+void StopSaveState(SaveState *state) {
+  if (state->file && state->file != INVALID_HANDLE_VALUE) {
+    CloseHandle(state->file);
+  }
+  if (state->shadow) {
+    VirtualFree(state->shadow, 0, MEM_RELEASE);
+  }
+  *state = {};
+}
+#endif
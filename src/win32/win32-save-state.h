@@ -0,0 +1,97 @@
+#ifndef SRC_WIN32_WIN32_SAVE_STATE_H_
+#define SRC_WIN32_WIN32_SAVE_STATE_H_
+
+#include <windows.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#if DEV
+static const uint32_t SAVE_STATE_FILE_MAGIC = 0x53484848;  // "HHHS"
+static const uint32_t SAVE_STATE_FILE_VERSION = 1;
+static const int SAVE_STATE_PAGES_PER_STEP = 64;
+
+// The file is a sequence of blocks, one per snapshot. Each record holds the
+// XOR of a page against its previous snapshot, so replaying every block in
+// order over zeroed memory rebuilds the latest state.
+struct SaveStateBlockHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t page_size;
+  uint32_t record_count;
+  uint64_t memory_size;
+  uint64_t data_size;
+};
+
+// A compressed size equal to the page size means the delta is stored raw.
+struct SaveStatePageHeader {
+  uint32_t page_idx;
+  uint32_t compressed_size;
+};
+
+struct SaveStateStats {
+  int64_t snapshot_count;
+  uint32_t dirty_page_count;
+  uint32_t changed_page_count;
+  uint64_t raw_size;
+  uint64_t compressed_size;
+  uint64_t file_size;
+  float capture_ms;
+  float compress_ms;
+  float restore_ms;
+};
+
+// Tracks a region allocated with MEM_WRITE_WATCH. Capturing diffs the pages
+// written since the last snapshot against a shadow copy, which is cheap
+// enough for the frame loop. Compression of the deltas is spread over later
+// frames by StepSaveState. Snapshots go to a side file that replaces the
+// previous one once it holds a full snapshot, so the file a session was
+// recovered from survives until there is a newer recovery point. Once the
+// deltas appended after a full snapshot outgrow it, the next snapshot is a
+// full one in a new side file, so the file stays within about twice the size
+// of a full snapshot.
+struct SaveState {
+  uint8_t *memory;
+  size_t memory_size;
+  uint32_t page_size;
+  uint32_t page_count;
+  int64_t perf_count_frequency;
+
+  uint8_t *shadow;
+  void **dirty_pages;
+  uint8_t *deltas;
+  uint32_t *delta_page_indices;
+  uint8_t *block;
+
+  uint32_t pending_count;
+  uint32_t compressed_count;
+  size_t block_size;
+  bool is_pending;
+  bool is_full_snapshot;
+  bool has_capture;
+
+  HANDLE file;
+  bool needs_full_snapshot;
+  uint64_t full_size;
+  uint64_t appended_size;
+  wchar_t file_path[MAX_PATH];
+  wchar_t pending_file_path[MAX_PATH];
+  SaveStateStats stats;
+};
+
+int CompressSaveStatePage(uint8_t *source, int size, uint8_t *dest,
+                          int dest_capacity);
+bool DecompressSaveStatePage(uint8_t *source, int size, uint8_t *dest,
+                             int dest_size);
+
+bool ParseRecoverMode(char *command_line);
+bool InitSaveState(SaveState *state, void *memory, size_t memory_size,
+                   wchar_t *file_path, int64_t perf_count_frequency);
+bool CaptureSaveState(SaveState *state);
+bool StepSaveState(SaveState *state, int page_budget);
+bool RestoreSaveState(SaveState *state);
+bool LoadSaveStateFile(wchar_t *file_path, void *memory, size_t memory_size);
+void StopSaveState(SaveState *state);
+#endif
+
+#endif  // SRC_WIN32_WIN32_SAVE_STATE_H_
@@ -1,8 +1,11 @@
 #include "../../src/win32/win32-sound.h"
 
 #include <dsound.h>
+#include <emmintrin.h>
 #include <windows.h>
 
+#include <cstdint>
+
 #include "../../src/handmade-hero/handmade-hero.h"
 
 IDirectSoundBuffer *InitDirectSound(HWND window, int samples_per_second,
@@ -72,6 +75,119 @@ IDirectSoundBuffer *InitDirectSound(HWND window, int samples_per_second,
   return sound_buffer;
 }
 
+void ClearSoundRegion(void *region, DWORD region_size) {
+  uint8_t *dest = reinterpret_cast<uint8_t *>(region);
+  __m128i zero = _mm_setzero_si128();
+
+  DWORD byte_idx = 0;
+  for (; byte_idx + 64 <= region_size; byte_idx += 64) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + byte_idx), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + byte_idx + 16), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + byte_idx + 32), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + byte_idx + 48), zero);
+  }
+  for (; byte_idx + 16 <= region_size; byte_idx += 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + byte_idx), zero);
+  }
+  for (; byte_idx < region_size; ++byte_idx) {
+    dest[byte_idx] = 0;
+  }
+}
+
+static inline __m128i NextDitherState(__m128i state) {
+  state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+  state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+  state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+  return state;
+}
+
+// Uniform noise in [0, 1) from the top 24 bits of each lane.
+static inline __m128 GetDitherNoise(__m128i state) {
+  __m128 result = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(state, 8)),
+                             _mm_set1_ps(1.0f / 16777216.0f));
+  return result;
+}
+
+// Triangular noise in (-1, 1) LSB, the difference of two uniform draws.
+static inline __m128 GetTriangularDither(__m128i *state) {
+  *state = NextDitherState(*state);
+  __m128 a = GetDitherNoise(*state);
+  *state = NextDitherState(*state);
+  __m128 b = GetDitherNoise(*state);
+  return _mm_sub_ps(a, b);
+}
+
+// Converts four stereo frames to eight interleaved, saturated int16 samples.
+static inline __m128i ConvertSoundFrames(__m128 left, __m128 right,
+                                         __m128i *dither_state) {
+  __m128 scale = _mm_set1_ps(32767.0f);
+  __m128 min_value = _mm_set1_ps(-32768.0f);
+  __m128 max_value = _mm_set1_ps(32767.0f);
+
+  left = _mm_mul_ps(left, scale);
+  right = _mm_mul_ps(right, scale);
+  if (dither_state) {
+    left = _mm_add_ps(left, GetTriangularDither(dither_state));
+    right = _mm_add_ps(right, GetTriangularDither(dither_state));
+  }
+  left = _mm_min_ps(_mm_max_ps(left, min_value), max_value);
+  right = _mm_min_ps(_mm_max_ps(right, min_value), max_value);
+
+  __m128i left_int = _mm_cvtps_epi32(left);
+  __m128i right_int = _mm_cvtps_epi32(right);
+  __m128i frames_lo = _mm_unpacklo_epi32(left_int, right_int);
+  __m128i frames_hi = _mm_unpackhi_epi32(left_int, right_int);
+  return _mm_packs_epi32(frames_lo, frames_hi);
+}
+
+void ConvertSoundSamples(int16_t *dest, float *left_samples,
+                         float *right_samples, DWORD sample_count,
+                         uint32_t *dither_state) {
+  __m128i state = _mm_setzero_si128();
+  __m128i *state_ptr = 0;
+  if (dither_state) {
+    state = _mm_loadu_si128(reinterpret_cast<__m128i *>(dither_state));
+    state_ptr = &state;
+  }
+
+  DWORD i = 0;
+  for (; i + 8 <= sample_count; i += 8) {
+    __m128i frames0 =
+        ConvertSoundFrames(_mm_loadu_ps(left_samples + i),
+                           _mm_loadu_ps(right_samples + i), state_ptr);
+    __m128i frames1 =
+        ConvertSoundFrames(_mm_loadu_ps(left_samples + i + 4),
+                           _mm_loadu_ps(right_samples + i + 4), state_ptr);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 2 * i), frames0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 2 * i + 8), frames1);
+  }
+
+  while (i < sample_count) {
+    DWORD remaining = sample_count - i;
+    DWORD count = remaining < 4 ? remaining : 4;
+
+    float left[4] = {};
+    float right[4] = {};
+    for (DWORD j = 0; j < count; ++j) {
+      left[j] = left_samples[i + j];
+      right[j] = right_samples[i + j];
+    }
+
+    int16_t frames[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(frames),
+                     ConvertSoundFrames(_mm_loadu_ps(left),
+                                        _mm_loadu_ps(right), state_ptr));
+    for (DWORD j = 0; j < 2 * count; ++j) {
+      dest[2 * i + j] = frames[j];
+    }
+    i += count;
+  }
+
+  if (dither_state) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dither_state), state);
+  }
+}
+
 bool ClearBuffer(IDirectSoundBuffer *sound_buffer, SoundOutput *sound_output) {
   void *region1;
   void *region2;
@@ -85,15 +201,8 @@ bool ClearBuffer(IDirectSoundBuffer *sound_buffer, SoundOutput *sound_output) {
     return false;
   }
 
-  int8_t *dest_sample = reinterpret_cast<int8_t *>(region1);
-  for (DWORD byte_idx = 0; byte_idx < region1_size; ++byte_idx) {
-    *dest_sample++ = 0;
-  }
-
-  dest_sample = reinterpret_cast<int8_t *>(region2);
-  for (DWORD byte_idx = 0; byte_idx < region2_size; ++byte_idx) {
-    *dest_sample++ = 0;
-  }
+  ClearSoundRegion(region1, region1_size);
+  ClearSoundRegion(region2, region2_size);
 
   if (!SUCCEEDED(
           sound_buffer->Unlock(region1, region1_size, region2, region2_size))) {
@@ -119,22 +228,22 @@ bool FillSoundBuffer(IDirectSoundBuffer *sound_buffer,
     return false;
   }
 
+  uint32_t *dither_state =
+      sound_output->is_dither_enabled ? sound_output->dither_state : 0;
+  float *left_samples = game_sound_buffer->left_samples;
+  float *right_samples = game_sound_buffer->right_samples;
+
   DWORD region1_sample_count = region1_size / sound_output->bytes_per_sample;
-  int16_t *dest_sample = reinterpret_cast<int16_t *>(region1);
-  int16_t *source_sample = game_sound_buffer->samples;
-  for (DWORD i = 0; i < region1_sample_count; ++i) {
-    *dest_sample++ = *source_sample++;
-    *dest_sample++ = *source_sample++;
-    ++sound_output->running_sample_idx;
-  }
+  ConvertSoundSamples(reinterpret_cast<int16_t *>(region1), left_samples,
+                      right_samples, region1_sample_count, dither_state);
+  left_samples += region1_sample_count;
+  right_samples += region1_sample_count;
+  sound_output->running_sample_idx += region1_sample_count;
 
   DWORD region2_sample_count = region2_size / sound_output->bytes_per_sample;
-  dest_sample = reinterpret_cast<int16_t *>(region2);
-  for (DWORD i = 0; i < region2_sample_count; ++i) {
-    *dest_sample++ = *source_sample++;
-    *dest_sample++ = *source_sample++;
-    ++sound_output->running_sample_idx;
-  }
+  ConvertSoundSamples(reinterpret_cast<int16_t *>(region2), left_samples,
+                      right_samples, region2_sample_count, dither_state);
+  sound_output->running_sample_idx += region2_sample_count;
 
   sound_buffer->Unlock(region1, region1_size, region2, region2_size);
 
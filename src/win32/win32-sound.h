@@ -19,10 +19,16 @@ struct SoundOutput {
   int secondary_buffer_size = 0;
   float t_sin = 0.0f;
   int latency_sample_count = 0;
+  bool is_dither_enabled = true;
+  uint32_t dither_state[4] = {0x9E3779B9, 0x7F4A7C15, 0x85EBCA6B, 0xC2B2AE35};
 };
 
 IDirectSoundBuffer *InitDirectSound(HWND window, int samples_per_second,
                                     int buffer_size);
+void ClearSoundRegion(void *region, DWORD region_size);
+void ConvertSoundSamples(int16_t *dest, float *left_samples,
+                         float *right_samples, DWORD sample_count,
+                         uint32_t *dither_state);
 bool ClearBuffer(IDirectSoundBuffer *sound_buffer, SoundOutput *sound_output);
 bool FillSoundBuffer(IDirectSoundBuffer *sound_buffer,
                      SoundOutput *sound_output, uint32_t byte_to_lock,
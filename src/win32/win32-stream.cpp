@@ -0,0 +1,164 @@
+#include "../../src/win32/win32-stream.h"
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static StreamQueue STREAM_QUEUE;
+
+static void *OpenStreamFile(const char *file_name) {
+  // Sharing write and delete access lets tools rewrite or replace the file
+  // while the game streams from it.
+  HANDLE file = CreateFileA(
+      file_name, GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0,
+      OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, 0);
+  if (file == INVALID_HANDLE_VALUE) {
+    return 0;
+  }
+  return file;
+}
+
+static void CloseStreamFile(void *file) {
+  if (file) {
+    CloseHandle(file);
+  }
+}
+
+static bool ReadStreamFile(void *file, uint64_t offset, uint32_t size,
+                           void *dest) {
+  OVERLAPPED overlapped = {};
+  overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+  overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+  DWORD bytes_read = 0;
+  bool result = ReadFile(file, dest, size, &bytes_read, &overlapped) &&
+                bytes_read == size;
+  return result;
+}
+
+static void CompleteStreamRequest(StreamRequest *request) {
+  bool is_read = ReadStreamFile(request->file, request->offset, request->size,
+                                request->dest);
+  InterlockedExchange(request->status,
+                      is_read ? PLATFORM_READ_DONE : PLATFORM_READ_FAILED);
+}
+
+static bool QueueStreamRead(void *file, uint64_t offset, uint32_t size,
+                            void *dest, volatile int32_t *status) {
+  StreamRequest request = {};
+  request.file = file;
+  request.offset = offset;
+  request.size = size;
+  request.dest = dest;
+  request.status = reinterpret_cast<volatile LONG *>(status);
+
+  StreamQueue *queue = &STREAM_QUEUE;
+  if (!queue->is_running) {
+    CompleteStreamRequest(&request);
+    return true;
+  }
+
+  LONG write_idx = queue->write_idx;
+  if (write_idx - queue->read_idx >= STREAM_REQUEST_COUNT) {
+    return false;
+  }
+
+  queue->requests[write_idx % STREAM_REQUEST_COUNT] = request;
+  InterlockedExchange(&queue->write_idx, write_idx + 1);
+  ReleaseSemaphore(queue->semaphore, 1, 0);
+  return true;
+}
+
+static bool WriteEntireStreamFile(const char *file_name, uint32_t size,
+                                  void *memory) {
+  HANDLE file =
+      CreateFileA(file_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  DWORD bytes_written = 0;
+  bool result = WriteFile(file, memory, size, &bytes_written, 0) &&
+                bytes_written == size;
+  CloseHandle(file);
+  return result;
+}
+
+static DWORD WINAPI StreamThreadProc(LPVOID parameter) {
+  StreamQueue *queue = reinterpret_cast<StreamQueue *>(parameter);
+  while (queue->is_running) {
+    WaitForSingleObject(queue->semaphore, INFINITE);
+
+    for (;;) {
+      LONG read_idx = queue->read_idx;
+      if (read_idx == queue->write_idx) {
+        break;
+      }
+
+      // The slot is copied before it is claimed; once read_idx moves past it
+      // the producer is free to reuse it.
+      StreamRequest request = queue->requests[read_idx % STREAM_REQUEST_COUNT];
+      if (InterlockedCompareExchange(&queue->read_idx, read_idx + 1,
+                                     read_idx) == read_idx) {
+        CompleteStreamRequest(&request);
+      }
+    }
+  }
+
+  return 0;
+}
+
+void InitPlatformApi(PlatformApi *platform) {
+  platform->OpenFile = OpenStreamFile;
+  platform->CloseFile = CloseStreamFile;
+  platform->ReadFile = ReadStreamFile;
+  platform->QueueRead = QueueStreamRead;
+  platform->WriteEntireFile = WriteEntireStreamFile;
+}
+
+bool StartStreamQueue() {
+  StreamQueue *queue = &STREAM_QUEUE;
+  *queue = {};
+
+  queue->semaphore =
+      CreateSemaphoreExW(0, 0, STREAM_REQUEST_COUNT + STREAM_WORKER_COUNT, 0,
+                         0, SEMAPHORE_ALL_ACCESS);
+  if (!queue->semaphore) {
+    return false;
+  }
+
+  queue->is_running = true;
+  for (int i = 0; i < STREAM_WORKER_COUNT; ++i) {
+    queue->threads[i] = CreateThread(0, 0, StreamThreadProc, queue, 0, 0);
+    if (!queue->threads[i]) {
+      StopStreamQueue();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void StopStreamQueue() {
+  StreamQueue *queue = &STREAM_QUEUE;
+  queue->is_running = false;
+  if (queue->semaphore) {
+    ReleaseSemaphore(queue->semaphore, STREAM_WORKER_COUNT, 0);
+  }
+
+  for (int i = 0; i < STREAM_WORKER_COUNT; ++i) {
+    if (queue->threads[i]) {
+      WaitForSingleObject(queue->threads[i], INFINITE);
+      CloseHandle(queue->threads[i]);
+      queue->threads[i] = 0;
+    }
+  }
+
+  if (queue->semaphore) {
+    CloseHandle(queue->semaphore);
+    queue->semaphore = 0;
+  }
+}
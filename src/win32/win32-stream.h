@@ -0,0 +1,38 @@
+#ifndef SRC_WIN32_WIN32_STREAM_H_
+#define SRC_WIN32_WIN32_STREAM_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+static const int STREAM_WORKER_COUNT = 2;
+static const int STREAM_REQUEST_COUNT = 64;
+
+struct StreamRequest {
+  HANDLE file;
+  uint64_t offset;
+  uint32_t size;
+  void *dest;
+  volatile LONG *status;
+};
+
+// The frame loop is the only producer. Workers claim requests by advancing
+// read_idx with a compare-exchange, so any idle worker can take the next one.
+struct StreamQueue {
+  StreamRequest requests[STREAM_REQUEST_COUNT];
+  volatile LONG write_idx;
+  volatile LONG read_idx;
+  HANDLE semaphore;
+  HANDLE threads[STREAM_WORKER_COUNT];
+  volatile bool is_running;
+};
+
+// Until StartStreamQueue runs, e.g. while recording or verifying a replay,
+// queued reads complete synchronously, which keeps those runs deterministic.
+void InitPlatformApi(PlatformApi *platform);
+bool StartStreamQueue();
+void StopStreamQueue();
+
+#endif  // SRC_WIN32_WIN32_STREAM_H_
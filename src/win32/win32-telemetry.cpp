@@ -0,0 +1,228 @@
+#include "../../src/win32/win32-telemetry.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+#include "../../src/win32/win32-file-io.h"
+#include "../../src/win32/win32-log.h"
+
+#if DEV
+static const char *FRAME_METRIC_NAMES[FRAME_METRIC_COUNT] = {"frame", "work",
+                                                             "sleep"};
+static const int TELEMETRY_HALF_SUB_BUCKET_COUNT =
+    TELEMETRY_SUB_BUCKET_COUNT / 2;
+
+static const size_t TELEMETRY_HITCH_FILE_SIZE =
+    sizeof(HitchFileHeader) +
+    TELEMETRY_HISTORY_FRAME_COUNT * sizeof(FrameSample);
+
+static uint8_t hitch_file_buffer[TELEMETRY_HITCH_FILE_SIZE];
+static char telemetry_report_json[TELEMETRY_REPORT_SIZE];
+
+int GetHistogramBucket(uint64_t value_us) {
+  if (value_us < TELEMETRY_SUB_BUCKET_COUNT) {
+    return static_cast<int>(value_us);
+  }
+
+  unsigned long msb;
+  _BitScanReverse64(&msb, value_us);
+  int shift = static_cast<int>(msb) - (TELEMETRY_SUB_BUCKET_BITS - 1);
+  int sub_bucket = static_cast<int>(value_us >> shift);
+  int result = TELEMETRY_SUB_BUCKET_COUNT +
+               (shift - 1) * TELEMETRY_HALF_SUB_BUCKET_COUNT +
+               (sub_bucket - TELEMETRY_HALF_SUB_BUCKET_COUNT);
+  if (result >= TELEMETRY_BUCKET_COUNT) {
+    result = TELEMETRY_BUCKET_COUNT - 1;
+  }
+  return result;
+}
+
+// Midpoint of the values that fall into the bucket.
+uint64_t GetHistogramValue(int bucket_idx) {
+  if (bucket_idx < TELEMETRY_SUB_BUCKET_COUNT) {
+    return static_cast<uint64_t>(bucket_idx);
+  }
+
+  int range_idx = bucket_idx - TELEMETRY_SUB_BUCKET_COUNT;
+  int shift = range_idx / TELEMETRY_HALF_SUB_BUCKET_COUNT + 1;
+  uint64_t sub_bucket = range_idx % TELEMETRY_HALF_SUB_BUCKET_COUNT +
+                        TELEMETRY_HALF_SUB_BUCKET_COUNT;
+  uint64_t result = (sub_bucket << shift) + (1ull << (shift - 1));
+  return result;
+}
+
+void RecordHistogramValue(FrameHistogram *histogram, float ms) {
+  uint64_t value_us = ms > 0.0f ? static_cast<uint64_t>(ms * 1000.0f) : 0;
+  ++histogram->counts[GetHistogramBucket(value_us)];
+  ++histogram->total_count;
+  if (value_us > histogram->max_us) {
+    histogram->max_us = value_us;
+  }
+}
+
+float GetHistogramPercentile(FrameHistogram *histogram, float percentile) {
+  if (!histogram->total_count) {
+    return 0.0f;
+  }
+
+  int64_t target_count = static_cast<int64_t>(
+      percentile / 100.0f * static_cast<float>(histogram->total_count) +
+      0.999f);
+  if (target_count < 1) {
+    target_count = 1;
+  }
+
+  int64_t count = 0;
+  uint64_t value_us = histogram->max_us;
+  for (int i = 0; i < TELEMETRY_BUCKET_COUNT; ++i) {
+    count += histogram->counts[i];
+    if (count >= target_count) {
+      value_us = GetHistogramValue(i);
+      break;
+    }
+  }
+  if (value_us > histogram->max_us) {
+    value_us = histogram->max_us;
+  }
+
+  float result = static_cast<float>(value_us) / 1000.0f;
+  return result;
+}
+
+FramePercentiles GetFramePercentiles(FrameTelemetry *telemetry,
+                                     FrameMetric metric) {
+  FrameHistogram *histogram = &telemetry->histograms[metric];
+  FramePercentiles result;
+  result.p50_ms = GetHistogramPercentile(histogram, 50.0f);
+  result.p95_ms = GetHistogramPercentile(histogram, 95.0f);
+  result.p99_ms = GetHistogramPercentile(histogram, 99.0f);
+  result.max_ms = static_cast<float>(histogram->max_us) / 1000.0f;
+  return result;
+}
+
+void InitFrameTelemetry(FrameTelemetry *telemetry, float target_sec_per_frame) {
+  *telemetry = {};
+  telemetry->hitch_threshold_ms =
+      TELEMETRY_HITCH_FACTOR * 1000.0f * target_sec_per_frame;
+}
+
+FrameSample *BeginFrameSample(FrameTelemetry *telemetry) {
+  FrameSample *result =
+      &telemetry->history[telemetry->frame_count %
+                          TELEMETRY_HISTORY_FRAME_COUNT];
+  *result = {};
+  result->frame_idx = telemetry->frame_count;
+  result->is_capture_write = telemetry->was_capture_written;
+  telemetry->was_capture_written = false;
+  return result;
+}
+
+static bool WriteHitchCapture(FrameTelemetry *telemetry, int64_t last_idx) {
+  int64_t first_idx =
+      telemetry->pending_hitch_frame_idx - TELEMETRY_HITCH_FRAMES_BEFORE;
+  if (first_idx < 0) {
+    first_idx = 0;
+  }
+
+  HitchFileHeader *header =
+      reinterpret_cast<HitchFileHeader *>(hitch_file_buffer);
+  header->magic = TELEMETRY_HITCH_FILE_MAGIC;
+  header->version = TELEMETRY_HITCH_FILE_VERSION;
+  header->hitch_frame_idx = telemetry->pending_hitch_frame_idx;
+  header->hitch_threshold_ms = telemetry->hitch_threshold_ms;
+  header->sample_count = static_cast<int32_t>(last_idx - first_idx + 1);
+
+  FrameSample *samples =
+      reinterpret_cast<FrameSample *>(hitch_file_buffer + sizeof(*header));
+  for (int64_t i = first_idx; i <= last_idx; ++i) {
+    samples[i - first_idx] =
+        telemetry->history[i % TELEMETRY_HISTORY_FRAME_COUNT];
+  }
+
+  wchar_t file_path[64];
+  swprintf(file_path, ArraySize(file_path), L"hitch-%04d.bin",
+           telemetry->capture_count);
+  uint32_t file_size = static_cast<uint32_t>(
+      sizeof(*header) + header->sample_count * sizeof(FrameSample));
+  bool result = WriteEntireFileDebug(file_path, file_size, hitch_file_buffer);
+  return result;
+}
+
+// Records the finished frame. A frame over the hitch threshold schedules a
+// capture of the frames around it, written once enough frames after it have
+// been recorded. The frame that pays for writing a capture is not counted as
+// a hitch itself.
+void EndFrameSample(FrameTelemetry *telemetry, FrameSample *sample) {
+  for (int i = 0; i < FRAME_METRIC_COUNT; ++i) {
+    RecordHistogramValue(&telemetry->histograms[i], sample->metric_ms[i]);
+  }
+  if (sample->is_missed) {
+    ++telemetry->missed_frame_count;
+  }
+
+  float frame_ms = sample->metric_ms[FRAME_METRIC_FRAME];
+  if (frame_ms > telemetry->hitch_threshold_ms && !sample->is_capture_write) {
+    ++telemetry->hitch_count;
+    Log(LOG_LEVEL_WARNING, LOG_CATEGORY_FRAME,
+        "Hitch at frame %lld: %.02f ms (%.02f ms work)", sample->frame_idx,
+        frame_ms, sample->metric_ms[FRAME_METRIC_WORK]);
+    if (!telemetry->is_hitch_pending &&
+        telemetry->capture_count < TELEMETRY_MAX_HITCH_CAPTURES) {
+      telemetry->pending_hitch_frame_idx = sample->frame_idx;
+      telemetry->is_hitch_pending = true;
+    }
+  }
+
+  if (telemetry->is_hitch_pending &&
+      sample->frame_idx >=
+          telemetry->pending_hitch_frame_idx + TELEMETRY_HITCH_FRAMES_AFTER) {
+    if (WriteHitchCapture(telemetry, sample->frame_idx)) {
+      Log(LOG_LEVEL_INFO, LOG_CATEGORY_FRAME,
+          "Hitch at frame %lld captured to hitch-%04d.bin",
+          telemetry->pending_hitch_frame_idx, telemetry->capture_count);
+    }
+    ++telemetry->capture_count;
+    telemetry->is_hitch_pending = false;
+    telemetry->was_capture_written = true;
+  }
+
+  ++telemetry->frame_count;
+}
+
+bool WriteFrameTelemetryReport(FrameTelemetry *telemetry, wchar_t *file_path) {
+  char *json = telemetry_report_json;
+  int json_capacity = sizeof(telemetry_report_json);
+  int json_size = snprintf(
+      json, json_capacity,
+      "{\n  \"frame_count\": %lld,\n  \"missed_frame_count\": %lld,\n"
+      "  \"hitch_count\": %lld,\n  \"hitch_capture_count\": %d,\n"
+      "  \"hitch_threshold_ms\": %.3f,\n  \"metrics\": [\n",
+      static_cast<long long>(telemetry->frame_count),
+      static_cast<long long>(telemetry->missed_frame_count),
+      static_cast<long long>(telemetry->hitch_count), telemetry->capture_count,
+      telemetry->hitch_threshold_ms);
+
+  for (int i = 0; i < FRAME_METRIC_COUNT; ++i) {
+    FramePercentiles percentiles =
+        GetFramePercentiles(telemetry, static_cast<FrameMetric>(i));
+    json_size += snprintf(
+        json + json_size, json_capacity - json_size,
+        "    {\"name\": \"%s\", \"p50_ms\": %.3f, \"p95_ms\": %.3f, "
+        "\"p99_ms\": %.3f, \"max_ms\": %.3f}%s\n",
+        FRAME_METRIC_NAMES[i], percentiles.p50_ms, percentiles.p95_ms,
+        percentiles.p99_ms, percentiles.max_ms,
+        i + 1 < FRAME_METRIC_COUNT ? "," : "");
+  }
+  json_size +=
+      snprintf(json + json_size, json_capacity - json_size, "  ]\n}\n");
+
+  bool result = WriteEntireFileDebug(file_path,
+                                     static_cast<uint32_t>(json_size), json);
+  return result;
+}
+#endif
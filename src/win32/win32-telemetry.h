@@ -0,0 +1,95 @@
+#ifndef SRC_WIN32_WIN32_TELEMETRY_H_
+#define SRC_WIN32_WIN32_TELEMETRY_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero.h"
+
+#if DEV
+static const int TELEMETRY_SUB_BUCKET_BITS = 6;
+static const int TELEMETRY_SUB_BUCKET_COUNT = 1 << TELEMETRY_SUB_BUCKET_BITS;
+static const int TELEMETRY_BUCKET_COUNT = 1024;
+static const int TELEMETRY_HISTORY_FRAME_COUNT = 128;
+static const int TELEMETRY_HITCH_FRAMES_BEFORE = 60;
+static const int TELEMETRY_HITCH_FRAMES_AFTER = 30;
+static const int TELEMETRY_MAX_HITCH_CAPTURES = 16;
+static const float TELEMETRY_HITCH_FACTOR = 1.5f;
+static const uint32_t TELEMETRY_HITCH_FILE_MAGIC = 0x43484848;  // "HHHC"
+static const uint32_t TELEMETRY_HITCH_FILE_VERSION = 1;
+static const int TELEMETRY_REPORT_SIZE = 4096;
+
+enum FrameMetric {
+  FRAME_METRIC_FRAME,
+  FRAME_METRIC_WORK,
+  FRAME_METRIC_SLEEP,
+  FRAME_METRIC_COUNT,
+};
+
+// Log-linear histogram of microsecond values: exact below
+// TELEMETRY_SUB_BUCKET_COUNT, then every power of two is split into half as
+// many linear buckets, keeping the relative error under 2^-(bits-1).
+struct FrameHistogram {
+  uint32_t counts[TELEMETRY_BUCKET_COUNT];
+  int64_t total_count;
+  uint64_t max_us;
+};
+
+struct FramePercentiles {
+  float p50_ms;
+  float p95_ms;
+  float p99_ms;
+  float max_ms;
+};
+
+struct FrameSample {
+  int64_t frame_idx;
+  float metric_ms[FRAME_METRIC_COUNT];
+  float overlay_ms;
+  float present_latency_ms;
+  float audio_latency_ms;
+  int32_t render_width;
+  int32_t render_height;
+  bool is_missed;
+  bool is_capture_write;
+  GameInput input;
+};
+
+// A hitch file holds the header followed by sample_count frames, oldest first.
+struct HitchFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  int64_t hitch_frame_idx;
+  float hitch_threshold_ms;
+  int32_t sample_count;
+};
+
+struct FrameTelemetry {
+  FrameHistogram histograms[FRAME_METRIC_COUNT];
+  FrameSample history[TELEMETRY_HISTORY_FRAME_COUNT];
+  int64_t frame_count;
+  int64_t missed_frame_count;
+  int64_t hitch_count;
+  float hitch_threshold_ms;
+
+  int64_t pending_hitch_frame_idx;
+  bool is_hitch_pending;
+  bool was_capture_written;
+  int capture_count;
+};
+
+uint64_t GetHistogramValue(int bucket_idx);
+int GetHistogramBucket(uint64_t value_us);
+void RecordHistogramValue(FrameHistogram *histogram, float ms);
+float GetHistogramPercentile(FrameHistogram *histogram, float percentile);
+FramePercentiles GetFramePercentiles(FrameTelemetry *telemetry,
+                                     FrameMetric metric);
+
+void InitFrameTelemetry(FrameTelemetry *telemetry, float target_sec_per_frame);
+FrameSample *BeginFrameSample(FrameTelemetry *telemetry);
+void EndFrameSample(FrameTelemetry *telemetry, FrameSample *sample);
+bool WriteFrameTelemetryReport(FrameTelemetry *telemetry, wchar_t *file_path);
+#endif
+
+#endif  // SRC_WIN32_WIN32_TELEMETRY_H_
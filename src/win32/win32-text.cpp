@@ -0,0 +1,194 @@
+#include "../../src/win32/win32-text.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/win32/win32-display.h"
+#include "../../src/win32/win32-hash.h"
+
+static bool RasterizeGlyphAtlas(GlyphAtlas *atlas) {
+  HDC dc = CreateCompatibleDC(0);
+  if (!dc) {
+    return false;
+  }
+
+  HFONT font = CreateFontW(TEXT_FONT_HEIGHT, 0, 0, 0, FW_NORMAL, FALSE, FALSE,
+                           FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+                           CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY,
+                           FIXED_PITCH | FF_MODERN, L"Consolas");
+  if (!font) {
+    DeleteDC(dc);
+    return false;
+  }
+  SelectObject(dc, font);
+
+  TEXTMETRICW metrics = {};
+  GetTextMetricsW(dc, &metrics);
+  atlas->glyph_width = metrics.tmAveCharWidth;
+  atlas->glyph_height = metrics.tmHeight;
+  atlas->pitch = GLYPH_COUNT * atlas->glyph_width;
+
+  BITMAPINFO info = {};
+  info.bmiHeader.biSize = sizeof(info.bmiHeader);
+  info.bmiHeader.biWidth = atlas->glyph_width;
+  info.bmiHeader.biHeight = -atlas->glyph_height;
+  info.bmiHeader.biPlanes = 1;
+  info.bmiHeader.biBitCount = 32;
+  info.bmiHeader.biCompression = BI_RGB;
+
+  void *bits = 0;
+  HBITMAP bitmap = CreateDIBSection(dc, &info, DIB_RGB_COLORS, &bits, 0, 0);
+  atlas->coverage = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, atlas->pitch * atlas->glyph_height,
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!bitmap || !atlas->coverage) {
+    if (bitmap) {
+      DeleteObject(bitmap);
+    }
+    DeleteObject(font);
+    DeleteDC(dc);
+    return false;
+  }
+
+  SelectObject(dc, bitmap);
+  SetBkColor(dc, RGB(0, 0, 0));
+  SetTextColor(dc, RGB(255, 255, 255));
+
+  // The opaque background clears the cell before every glyph, and any
+  // channel of the white-on-black result is the coverage.
+  for (int glyph_idx = 0; glyph_idx < GLYPH_COUNT; ++glyph_idx) {
+    wchar_t glyph = static_cast<wchar_t>(GLYPH_FIRST + glyph_idx);
+    TextOutW(dc, 0, 0, &glyph, 1);
+    GdiFlush();
+
+    uint32_t *source = reinterpret_cast<uint32_t *>(bits);
+    uint8_t *dest = atlas->coverage + glyph_idx * atlas->glyph_width;
+    for (int y = 0; y < atlas->glyph_height; ++y) {
+      for (int x = 0; x < atlas->glyph_width; ++x) {
+        dest[x] = static_cast<uint8_t>(source[x] >> 8);
+      }
+      source += atlas->glyph_width;
+      dest += atlas->pitch;
+    }
+  }
+
+  DeleteObject(bitmap);
+  DeleteObject(font);
+  DeleteDC(dc);
+
+  return true;
+}
+
+bool InitTextCache(TextCache *cache) {
+  *cache = {};
+  InitSRGBTables();
+  if (!RasterizeGlyphAtlas(&cache->atlas)) {
+    return false;
+  }
+
+  GlyphAtlas *atlas = &cache->atlas;
+  int layout_pitch = (TEXT_MAX_LENGTH * atlas->glyph_width + 3) & ~3;
+  int layout_size = layout_pitch * atlas->glyph_height;
+  uint8_t *layout_memory = reinterpret_cast<uint8_t *>(
+      VirtualAlloc(0, TEXT_CACHE_SLOT_COUNT * layout_size,
+                   MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!layout_memory) {
+    return false;
+  }
+
+  for (int i = 0; i < TEXT_CACHE_SLOT_COUNT; ++i) {
+    cache->layouts[i].coverage = layout_memory + i * layout_size;
+  }
+
+  return true;
+}
+
+TextLayout *LayoutText(TextCache *cache, const char *text) {
+  int length = 0;
+  while (length < TEXT_MAX_LENGTH && text[length]) {
+    ++length;
+  }
+  uint64_t hash = HashMemory(const_cast<char *>(text), length, 0);
+
+  ++cache->use_counter;
+  TextLayout *result = &cache->layouts[0];
+  for (int i = 0; i < TEXT_CACHE_SLOT_COUNT; ++i) {
+    TextLayout *layout = &cache->layouts[i];
+    if (layout->last_used && layout->hash == hash &&
+        layout->length == length && memcmp(layout->text, text, length) == 0) {
+      ++cache->hit_count;
+      layout->last_used = cache->use_counter;
+      return layout;
+    }
+    if (layout->last_used < result->last_used) {
+      result = layout;
+    }
+  }
+  ++cache->miss_count;
+
+  // Evict the least recently used layout.
+  GlyphAtlas *atlas = &cache->atlas;
+  result->hash = hash;
+  result->length = length;
+  memcpy(result->text, text, length);
+  result->width = length * atlas->glyph_width;
+  result->height = atlas->glyph_height;
+  result->pitch = (result->width + 3) & ~3;
+  result->last_used = cache->use_counter;
+
+  for (int y = 0; y < result->height; ++y) {
+    uint8_t *dest = result->coverage + y * result->pitch;
+    uint8_t *atlas_row = atlas->coverage + y * atlas->pitch;
+    for (int i = 0; i < length; ++i) {
+      int glyph_idx = static_cast<uint8_t>(text[i]) - GLYPH_FIRST;
+      if (glyph_idx < 0 || glyph_idx >= GLYPH_COUNT) {
+        glyph_idx = '?' - GLYPH_FIRST;
+      }
+      memcpy(dest, atlas_row + glyph_idx * atlas->glyph_width,
+             atlas->glyph_width);
+      dest += atlas->glyph_width;
+    }
+    memset(dest, 0, result->pitch - result->width);
+  }
+
+  return result;
+}
+
+void BlitTextLayout(Buffer *buffer, TextLayout *layout, int x, int y,
+                    uint32_t color, BlendSpace blend_space) {
+  int source_x = x < 0 ? -x : 0;
+  int source_y = y < 0 ? -y : 0;
+  int min_x = x + source_x;
+  int min_y = y + source_y;
+  int max_x = x + layout->width;
+  int max_y = y + layout->height;
+  if (max_x > buffer->width) {
+    max_x = buffer->width;
+  }
+  if (max_y > buffer->height) {
+    max_y = buffer->height;
+  }
+  int width = max_x - min_x;
+  if (width <= 0 || max_y <= min_y) {
+    return;
+  }
+
+  uint8_t *source_row = layout->coverage + source_y * layout->pitch + source_x;
+  uint8_t *dest_row = reinterpret_cast<uint8_t *>(buffer->memory) +
+                      min_y * buffer->pitch + min_x * buffer->bytes_per_pixel;
+  for (int row = min_y; row < max_y; ++row) {
+    BlendCoverageSpan(reinterpret_cast<uint32_t *>(dest_row), source_row,
+                      width, color, blend_space);
+    source_row += layout->pitch;
+    dest_row += buffer->pitch;
+  }
+}
+
+void DrawDebugText(Buffer *buffer, TextCache *cache, int x, int y,
+                   const char *text, uint32_t color, BlendSpace blend_space) {
+  TextLayout *layout = LayoutText(cache, text);
+  BlitTextLayout(buffer, layout, x, y, color, blend_space);
+}
@@ -0,0 +1,56 @@
+#ifndef SRC_WIN32_WIN32_TEXT_H_
+#define SRC_WIN32_WIN32_TEXT_H_
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../../src/handmade-hero/handmade-hero-color.h"
+#include "../../src/win32/win32-display.h"
+
+static const int GLYPH_FIRST = 32;
+static const int GLYPH_LAST = 126;
+static const int GLYPH_COUNT = GLYPH_LAST - GLYPH_FIRST + 1;
+static const int TEXT_FONT_HEIGHT = 16;
+static const int TEXT_MAX_LENGTH = 128;
+static const int TEXT_CACHE_SLOT_COUNT = 64;
+
+// 8-bit coverage for every printable ASCII glyph, side by side in one row of
+// monospaced cells.
+struct GlyphAtlas {
+  int glyph_width;
+  int glyph_height;
+  int pitch;
+  uint8_t *coverage;
+};
+
+// A string laid out once into a coverage strip and reused while it stays in
+// the cache. Rows are padded to a multiple of four pixels with zero
+// coverage.
+struct TextLayout {
+  uint64_t hash;
+  int length;
+  char text[TEXT_MAX_LENGTH];
+  int width;
+  int height;
+  int pitch;
+  uint8_t *coverage;
+  uint64_t last_used;
+};
+
+struct TextCache {
+  GlyphAtlas atlas;
+  TextLayout layouts[TEXT_CACHE_SLOT_COUNT];
+  uint64_t use_counter;
+  uint64_t hit_count;
+  uint64_t miss_count;
+};
+
+bool InitTextCache(TextCache *cache);
+TextLayout *LayoutText(TextCache *cache, const char *text);
+void BlitTextLayout(Buffer *buffer, TextLayout *layout, int x, int y,
+                    uint32_t color, BlendSpace blend_space);
+void DrawDebugText(Buffer *buffer, TextCache *cache, int x, int y,
+                   const char *text, uint32_t color, BlendSpace blend_space);
+
+#endif  // SRC_WIN32_WIN32_TEXT_H_